@@ -28,6 +28,7 @@
 #include "../src/runtime/c_runtime_api.cc"
 #include "../src/runtime/cpu_device_api.cc"
 #include "../src/runtime/workspace_pool.cc"
+#include "../src/runtime/trace.cc"
 #include "../src/runtime/module_util.cc"
 #include "../src/runtime/system_lib_module.cc"
 #include "../src/runtime/module.cc"
@@ -39,6 +40,7 @@
 #include "../src/runtime/ndarray.cc"
 
 #include "../src/runtime/graph/graph_runtime.cc"
+#include "../src/runtime/graph/inter_op_executor.cc"
 
 #ifdef TVM_OPENCL_RUNTIME
 #include "../src/runtime/opencl/opencl_device_api.cc"
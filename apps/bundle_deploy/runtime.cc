@@ -25,6 +25,7 @@
 #include "../../src/runtime/c_runtime_api.cc"
 #include "../../src/runtime/cpu_device_api.cc"
 #include "../../src/runtime/workspace_pool.cc"
+#include "../../src/runtime/trace.cc"
 #include "../../src/runtime/module_util.cc"
 #include "../../src/runtime/module.cc"
 #include "../../src/runtime/registry.cc"
@@ -34,3 +35,4 @@
 #include "../../src/runtime/ndarray.cc"
 #include "../../src/runtime/system_lib_module.cc"
 #include "../../src/runtime/graph/graph_runtime.cc"
+#include "../../src/runtime/graph/inter_op_executor.cc"
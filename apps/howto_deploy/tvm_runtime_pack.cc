@@ -40,6 +40,7 @@
 #include "../../src/runtime/c_runtime_api.cc"
 #include "../../src/runtime/cpu_device_api.cc"
 #include "../../src/runtime/workspace_pool.cc"
+#include "../../src/runtime/trace.cc"
 #include "../../src/runtime/module_util.cc"
 #include "../../src/runtime/module.cc"
 #include "../../src/runtime/registry.cc"
@@ -59,6 +60,7 @@
 
 // Graph runtime
 #include "../../src/runtime/graph/graph_runtime.cc"
+#include "../../src/runtime/graph/inter_op_executor.cc"
 
 // Uncomment the following lines to enable RPC
 // #include "../../src/runtime/rpc/rpc_session.cc"
@@ -26,6 +26,7 @@
 #include "../../../src/runtime/c_runtime_api.cc"
 #include "../../../src/runtime/cpu_device_api.cc"
 #include "../../../src/runtime/workspace_pool.cc"
+#include "../../../src/runtime/trace.cc"
 #include "../../../src/runtime/thread_pool.cc"
 #include "../../../src/runtime/threading_backend.cc"
 #include "../../../src/runtime/module_util.cc"
@@ -42,6 +43,7 @@
 #include "../../../src/runtime/rpc/rpc_module.cc"
 // Graph runtime
 #include "../../../src/runtime/graph/graph_runtime.cc"
+#include "../../../src/runtime/graph/inter_op_executor.cc"
 // Metal
 #include "../../../src/runtime/metal/metal_module.mm"
 #include "../../../src/runtime/metal/metal_device_api.mm"
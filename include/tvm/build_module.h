@@ -229,6 +229,12 @@ class BuildConfigNode : public Node {
   /*! \brief Whether to disable loop vectorization. */
   bool disable_vectorize = false;
 
+  /*!
+   * \brief Number of threads to lower and generate code with,
+   *  non-positive to use all cores. The output does not depend on it.
+   */
+  int build_threads = 1;
+
   void VisitAttrs(AttrVisitor* v) final {
     v->Visit("data_alignment", &data_alignment);
     v->Visit("offset_factor", &offset_factor);
@@ -244,6 +250,7 @@ class BuildConfigNode : public Node {
     v->Visit("instrument_bound_checkers", &instrument_bound_checkers);
     v->Visit("disable_select_rewriting", &disable_select_rewriting);
     v->Visit("disable_vectorize", &disable_vectorize);
+    v->Visit("build_threads", &build_threads);
   }
 
   static constexpr const char* _type_key = "BuildConfig";
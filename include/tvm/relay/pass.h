@@ -46,6 +46,10 @@ namespace relay {
  * type information filled in, as well as it's checked type field
  * populated with the result type.
  *
+ * Calls to primitive operators that were type checked before keep their
+ * checked type when their argument types are unchanged, so re-inferring a
+ * partially rewritten program only solves the rewritten part.
+ *
  * \param expr The expression to type check.
  * \param mod The module used for referencing global functions, can be
  * None.
@@ -77,6 +77,22 @@ namespace transform {
  */
 class PassContext;
 
+/*! \brief The measurements of one pass execution. */
+struct PassProfileRecord {
+  /*! \brief The name of the pass. */
+  std::string name;
+  /*! \brief The start time in microseconds, on a steady clock. */
+  int64_t start_us;
+  /*! \brief The wall time of the pass in microseconds. */
+  int64_t duration_us;
+  /*! \brief The number of distinct expression nodes before the pass. */
+  int64_t nodes_before;
+  /*! \brief The number of distinct expression nodes after the pass. */
+  int64_t nodes_after;
+  /*! \brief The growth of the process peak resident memory in KB. */
+  int64_t peak_memory_kb;
+};
+
 /*!
  * \brief PassContextNode contains the information that a pass can rely on,
  * such as analysis results.
@@ -99,6 +115,17 @@ class PassContextNode : public RelayNode {
   /*! \brief The list of disabled passes. */
   tvm::Array<tvm::Expr> disabled_pass;
 
+  /*!
+   * \brief The number of threads used to run thread-safe function passes,
+   *  non-positive for all cores.
+   */
+  int num_threads{1};
+
+  /*! \brief Whether to record a PassProfileRecord for every executed pass. */
+  bool instrument{false};
+  /*! \brief The records collected while instrument is set. */
+  std::vector<PassProfileRecord> profile_records;
+
   PassContextNode() = default;
 
   void VisitAttrs(tvm::AttrVisitor* v) final {
@@ -106,6 +133,8 @@ class PassContextNode : public RelayNode {
     v->Visit("fallback_device", &fallback_device);
     v->Visit("required_pass", &required_pass);
     v->Visit("disabled_pass", &disabled_pass);
+    v->Visit("num_threads", &num_threads);
+    v->Visit("instrument", &instrument);
   }
 
   static constexpr const char* _type_key = "relay.PassContext";
@@ -337,6 +366,8 @@ Pass CreateModulePass(
  * \param opt_level The optimization level of the function pass.
  * \param name The name of the function pass.
  * \param required The list of the passes that the function pass is dependent on.
+ * \param thread_safe Whether pass_func may run on several functions at once,
+ *  see FunctionPassNode::thread_safe for the contract.
  *
  * \return The created function pass.
  */
@@ -344,7 +375,8 @@ TVM_DLL Pass CreateFunctionPass(const runtime::TypedPackedFunc<
                                 Function(Function, Module, PassContext)>& pass_func,
                                 int opt_level,
                                 const std::string& name,
-                                const tvm::Array<tvm::Expr>& required);
+                                const tvm::Array<tvm::Expr>& required,
+                                bool thread_safe = false);
 
 /*! \brief Remove expressions which does not effect the program result.
  *
@@ -112,13 +112,22 @@ typedef struct {
 typedef int (*FTVMParallelLambda)(
     int task_id, TVMParallelGroupEnv* penv, void* cdata);
 
+/*!
+ * \brief Value of num_task that launches a parallel lambda with all available
+ *  threads, and lets the runtime split its work into more tasks than threads.
+ *
+ *  Only valid for a lambda that partitions its work by penv->num_task and
+ *  never calls TVMBackendParallelBarrier.
+ */
+#define TVM_PARALLEL_NUM_TASK_SPLITTABLE -1
+
 /*!
  * \brief Backend function for running parallel jobs.
  *
  * \param flambda The parallel function to be launched.
  * \param cdata The closure data.
  * \param num_task Number of tasks to launch, can be 0, means launch
- *           with all available threads.
+ *           with all available threads, or TVM_PARALLEL_NUM_TASK_SPLITTABLE.
  *
  * \return 0 when no error is thrown, -1 when failure happens
  */
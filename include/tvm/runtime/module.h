@@ -137,6 +137,13 @@ class ModuleNode {
    * \return Possible source code when available.
    */
   TVM_DLL virtual std::string GetSource(const std::string& format = "");
+  /*!
+   * \brief Get the names of the functions exposed by the module, when known.
+   * \return The function names, empty if the module cannot enumerate them.
+   * \note Device modules implement this so that an exported library can
+   *   index its imported modules by function name and load them on demand.
+   */
+  TVM_DLL virtual std::vector<std::string> GetFunctionNames();
   /*!
    * \brief Get a function from current environment
    *  The environment includes all the imports as well as Global functions.
@@ -184,6 +184,12 @@ class TypedPackedFunc;
  *
  * Developers should prefer TypedPackedFunc over PackedFunc in C++ code
  * as it enables compile time checking.
+ *
+ * A TypedPackedFunc constructed from a typed lambda also keeps an unboxed
+ * entry to the lambda: calling it through the TypedPackedFunc passes the
+ * arguments directly instead of packing them into TVMArgs. Copies of the
+ * TypedPackedFunc share the entry, a TypedPackedFunc constructed from a
+ * PackedFunc always takes the packed path.
  * We can construct a TypedPackedFunc from a lambda function
  * with the same signature.
  *
@@ -295,6 +301,8 @@ class TypedPackedFunc<R(Args...)> {
    */
   TSelf& operator=(PackedFunc packed) {
     packed_ = packed;
+    direct_call_ = nullptr;
+    direct_self_.reset();
     return *this;
   }
   /*!
@@ -324,11 +332,19 @@ class TypedPackedFunc<R(Args...)> {
   bool operator!=(std::nullptr_t null) const {
     return packed_ != nullptr;
   }
+  /*! \return Whether calls skip the packed calling convention */
+  bool unboxed() const {
+    return direct_call_ != nullptr;
+  }
 
  private:
   friend class TVMRetValue;
   /*! \brief The internal packed function */
   PackedFunc packed_;
+  /*! \brief Calls the typed lambda in direct_self_ without boxing, may be nullptr */
+  R (*direct_call_)(const void* self, Args... args){nullptr};
+  /*! \brief The typed lambda, shared with packed_ */
+  std::shared_ptr<const void> direct_self_;
   /*!
    * \brief Assign the packed field using a typed lambda function.
    *
@@ -1268,6 +1284,20 @@ struct typed_packed_call_dispatcher<void> {
     pf(std::forward<Args>(args)...);
   }
 };
+
+template<typename R, typename FType, typename ...Args>
+struct typed_direct_call {
+  static R run(const void* self, Args... args) {
+    return (*static_cast<const FType*>(self))(std::forward<Args>(args)...);
+  }
+};
+
+template<typename FType, typename ...Args>
+struct typed_direct_call<void, FType, Args...> {
+  static void run(const void* self, Args... args) {
+    (*static_cast<const FType*>(self))(std::forward<Args>(args)...);
+  }
+};
 }  // namespace detail
 
 template<typename R, typename ...Args>
@@ -1285,13 +1315,19 @@ TypedPackedFunc<R(Args...)>::TypedPackedFunc(const TVMArgValue& value)
 template<typename R, typename ...Args>
 template<typename FType>
 inline void TypedPackedFunc<R(Args...)>::AssignTypedLambda(FType flambda) {
-  packed_ = PackedFunc([flambda](const TVMArgs& args, TVMRetValue* rv) {
-      detail::unpack_call<R, sizeof...(Args)>(flambda, args, rv);
+  std::shared_ptr<const FType> self = std::make_shared<const FType>(flambda);
+  packed_ = PackedFunc([self](const TVMArgs& args, TVMRetValue* rv) {
+      detail::unpack_call<R, sizeof...(Args)>(*self, args, rv);
     });
+  direct_call_ = detail::typed_direct_call<R, FType, Args...>::run;
+  direct_self_ = self;
 }
 
 template<typename R, typename ...Args>
 inline R TypedPackedFunc<R(Args...)>::operator()(Args... args) const {
+  if (direct_call_ != nullptr) {
+    return direct_call_(direct_self_.get(), std::forward<Args>(args)...);
+  }
   return detail::typed_packed_call_dispatcher<R>
       ::run(packed_, std::forward<Args>(args)...);
 }
@@ -76,10 +76,25 @@ class ThreadGroup {
    *        If  `true`, worker0 will not be launched in a new thread and
    *        `worker_callback` will only be called for values >= 1. This
    *        allows use of the main thread as a worker.
+   * \param core_offset The position of the first core to bind to, in the
+   *        preferred core order. Lets several groups bind to disjoint cores.
    *
    * \return The number of workers to use.
    */
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                int core_offset = 0);
+
+  /*!
+   * \brief configure the CPU id affinity to the cpus of one NUMA node
+   *
+   * \param node The NUMA node.
+   * \param nthreads The number of threads to use (0 = the share of the
+   *        node in MaxConcurrency).
+   * \param exclude_worker0 Whether to use the main thread as a worker.
+   *
+   * \return The number of workers to use.
+   */
+  int ConfigureNumaNode(int node, int nthreads, bool exclude_worker0);
 
  private:
   Impl* impl_;
@@ -95,6 +110,30 @@ void Yield();
  */
 int MaxConcurrency();
 
+/*!
+ * \return the number of NUMA nodes, read from sysfs, 1 if unknown.
+ */
+int NumaNodeCount();
+
+/*!
+ * \brief Get the cpus of a NUMA node.
+ * \param node The NUMA node.
+ * \return The cpu ids, one hardware thread of each physical core first,
+ *  then their hyper-threading siblings.
+ */
+const std::vector<unsigned>& NumaNodeCpus(int node);
+
+/*!
+ * \brief Set the NUMA node the calling thread allocates CPU memory on.
+ * \param node The NUMA node, -1 for the default policy of the OS.
+ */
+void SetNumaNode(int node);
+
+/*!
+ * \return the NUMA node the calling thread allocates CPU memory on, -1 if unset.
+ */
+int GetNumaNode();
+
 
 }  // namespace threading
 }  // namespace runtime
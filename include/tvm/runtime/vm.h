@@ -47,7 +47,8 @@ using Index = int64_t;
 /*! \brief An enumeration of Relay's opcodes.
  *
  * The opcode is used to implement instruction
- * as a tagged union.
+ * as a tagged union. The values must stay dense,
+ * they index the interpreter's dispatch table.
  */
 enum class Opcode {
   Move = 0U,
@@ -62,7 +63,8 @@ enum class Opcode {
   If = 9U,
   Select = 10U,
   LoadConst = 11U,
-  Goto = 12U
+  Goto = 12U,
+  KillRegister = 13U
 };
 
 /*! \brief A single virtual machine instruction.
@@ -262,6 +264,12 @@ struct Instruction {
    *  \return The move instruction.
    */
   static Instruction Move(RegName src, RegName dst);
+  /*! \brief Construct a kill register instruction, which drops the object
+   *  held by a register whose value is no longer live.
+   *  \param reg The register to clear.
+   *  \return The kill register instruction.
+   */
+  static Instruction KillRegister(RegName reg);
 
   Instruction();
   Instruction(const Instruction& instr);
@@ -285,17 +293,32 @@ struct VMFunction {
   std::vector<Instruction> instructions;
   /*! \brief The size of the frame for this function */
   Index register_file_size;
+  /*! \brief The instructions encoded for the interpreter.
+   *
+   * Each instruction is a run of words: the opcode followed by its
+   * operands inline, with argument lists stored as a count followed
+   * by the registers. Jump offsets are counted in words.
+   */
+  std::vector<Index> bytecode;
 
   VMFunction(const std::string& name, Index params,
              const std::vector<Instruction>& instructions,
-             Index register_file_size)
-      : name(name),
-        params(params),
-        instructions(instructions),
-        register_file_size(register_file_size) {}
+             Index register_file_size);
 
   VMFunction() {}
 
+  /*! \brief Rebuild a function from its bytecode, as stored in a
+   *  serialized executable. Every register must be inside the frame.
+   *  \param name The function's name.
+   *  \param params The number of function parameters.
+   *  \param bytecode The encoded instructions.
+   *  \param register_file_size The size of the frame.
+   *  \return The function.
+   */
+  static VMFunction FromBytecode(const std::string& name, Index params,
+                                 const std::vector<Index>& bytecode,
+                                 Index register_file_size);
+
   friend std::ostream& operator<<(std::ostream& os, const VMFunction&);
 };
 
@@ -312,8 +335,8 @@ struct VMFrame {
   Index func_index;
   /*! \brief The number of arguments. */
   Index args;
-  /*! \brief A pointer into the caller function's instructions. */
-  const Instruction* code;
+  /*! \brief A pointer into the caller function's bytecode. */
+  const Index* code;
 
   /*! \brief Statically allocated space for objects */
   std::vector<Object> register_file;
@@ -321,7 +344,7 @@ struct VMFrame {
   /*! \brief Register in caller's frame to put return value */
   RegName caller_return_register;
 
-  VMFrame(Index pc, Index func_index, Index args, const Instruction* code, Index register_file_size)
+  VMFrame(Index pc, Index func_index, Index args, const Index* code, Index register_file_size)
       : pc(pc),
         func_index(func_index),
         args(args),
@@ -344,6 +367,10 @@ struct VMFrame {
 struct VirtualMachine {
   /*! \brief The virtual machine's packed function table. */
   std::vector<PackedFunc> packed_funcs;
+  /*! \brief The names of the packed functions, looked up in lib. */
+  std::vector<std::string> packed_func_names;
+  /*! \brief The module containing the compiled operators. */
+  Module lib;
   /*! \brief The virtual machine's function table. */
   std::vector<VMFunction> functions;
   /*! \brief The current stack of call frames. */
@@ -353,7 +380,7 @@ struct VirtualMachine {
   /*! \brief The fuction table index of the current function. */
   Index func_index;
   /*! \brief The current pointer to the code section. */
-  const Instruction* code;
+  const Index* code;
   /*! \brief The virtual machine PC. */
   Index pc;
 
@@ -405,6 +432,23 @@ struct VirtualMachine {
   void Init(const std::vector<TVMContext>& contexts);
   void Run();
 
+  /*! \brief Save the executable: the functions, the constant pool and
+   *  the names of the packed functions.
+   *
+   *  The operators in lib are not included, export them separately.
+   *  \param file_name The file to write.
+   */
+  void Save(const std::string& file_name) const;
+
+  /*! \brief Load an executable written by Save.
+   *
+   *  The constants are memory mapped rather than copied.
+   *  \param file_name The file to read.
+   *  \param lib The module containing the compiled operators.
+   *  \return The virtual machine, to be initialized with Init.
+   */
+  static VirtualMachine Load(const std::string& file_name, const Module& lib);
+
   /*! \brief A map from globals (as strings) to their index in the function map.
    */
   std::unordered_map<std::string, Index> global_map_;
@@ -415,6 +459,18 @@ struct VirtualMachine {
    * This does not begin execution of the VM.
    */
   void InvokeGlobal(const VMFunction& func, const std::vector<Object>& args);
+  /*! \brief Call a function from the dispatch loop, copying the arguments
+   *  straight out of the caller's registers.
+   *
+   *  The caller must have advanced pc past the call instruction.
+   */
+  void CallFunction(const VMFunction& func, const Index* arg_regs, Index num_args,
+                    const std::vector<Object>& free_vars, RegName dst);
+
+  /*! \brief Scratch space for the arguments of packed calls. */
+  std::vector<TVMValue> packed_values_;
+  /*! \brief Scratch space for the type codes of packed calls. */
+  std::vector<int> packed_codes_;
 };
 
 }  // namespace vm
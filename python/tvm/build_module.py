@@ -144,7 +144,8 @@ class BuildConfig(NodeBase):
         "dump_pass_ir": False,
         "instrument_bound_checkers": False,
         "disable_select_rewriting": False,
-        "disable_vectorize": False
+        "disable_vectorize": False,
+        "build_threads": 1
     }
     _dump_ir = DumpIR()
 
@@ -250,6 +251,11 @@ def build_config(**kwargs):
 
     dump_pass_ir: dump ir of each pass into file idx_passname_ir.cc, default=False
 
+    build_threads: int, default=1
+        Number of threads used to lower the fused functions of relay.build
+        and to generate LLVM code. Non-positive values use all cores.
+        The generated code does not depend on it.
+
     Returns
     -------
     config: BuildConfig
@@ -0,0 +1,97 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Dynamic batching front-end for graph runtime and executor functions."""
+import json
+
+from .._ffi.function import get_global_func
+from .graph_runtime import GraphModule
+
+
+def create(input_names, buckets, max_delay_us=1000):
+    """Create a dynamic batching runtime.
+
+    Requests submitted concurrently are coalesced along their leading
+    dimension until the largest bucket is full or the oldest request
+    waited max_delay_us, then run on the smallest bucket that fits.
+
+    Parameters
+    ----------
+    input_names : list of str
+        The names of the batched inputs.
+
+    buckets : dict of int to GraphModule, Module or Function
+        Map from batch size to the executor compiled for it. A function
+        executor takes the batched inputs and returns the batched output.
+
+    max_delay_us : int
+        The maximum time in microseconds a request waits for a batch to fill.
+
+    Returns
+    -------
+    batching_module : BatchingModule
+        The batching runtime.
+    """
+    args = [len(input_names)] + list(input_names) + [max_delay_us]
+    for batch_size, executor in sorted(buckets.items()):
+        if isinstance(executor, GraphModule):
+            executor = executor.module
+        args += [batch_size, executor]
+    fcreate = get_global_func("tvm.batching_runtime.create")
+    return BatchingModule(fcreate(*args))
+
+
+class BatchingModule(object):
+    """Wrapper of the dynamic batching runtime module.
+
+    Parameters
+    ----------
+    module : Module
+        The internal tvm module of the batching runtime.
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self._run = module["run"]
+        self._get_stats = module["get_stats"]
+        self._reset_stats = module["reset_stats"]
+
+    def run(self, inputs, outputs):
+        """Run one request, blocks until the batch it joins finishes.
+
+        Parameters
+        ----------
+        inputs : list of NDArray
+            The inputs of the request, whose leading dimension is the batch.
+
+        outputs : list of NDArray
+            The output containers of the request.
+        """
+        self._run(*(list(inputs) + list(outputs)))
+
+    def get_stats(self):
+        """Get the batching statistics.
+
+        Returns
+        -------
+        stats : dict
+            Queue depth, batch fill rate and wait times of the requests.
+        """
+        return json.loads(self._get_stats())
+
+    def reset_stats(self):
+        """Reset the batching statistics."""
+        self._reset_stats()
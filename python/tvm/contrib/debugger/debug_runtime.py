@@ -16,6 +16,7 @@
 # under the License.
 """Graph debug runtime executes TVM debug packed functions."""
 
+import json
 import os
 import tempfile
 import shutil
@@ -112,6 +113,7 @@ class GraphModuleDebug(graph_runtime.GraphModule):
         self._dump_path = None
         self._get_output_by_layer = module["get_output_by_layer"]
         self._run_individual = module["run_individual"]
+        self._run_individual_counters = module["run_individual_counters"]
         graph_runtime.GraphModule.__init__(self, module)
         self._create_debug_env(graph_json_str, ctx)
 
@@ -253,6 +255,26 @@ class GraphModuleDebug(graph_runtime.GraphModule):
         ret = self._run_individual(number, repeat, min_repeat_ms)
         return ret.strip(",").split(",") if ret else []
 
+    def run_individual_counters(self, number=10):
+        """Run each operator and collect its hardware performance counters.
+
+        The counters are summed over all threads, including the thread pool
+        workers. Where perf_event_open is unavailable only the time and the
+        argument bandwidth are reported.
+
+        Parameters
+        ----------
+        number : int
+            The number of runs of each operator to average over.
+
+        Returns
+        -------
+        ops : list of dict
+            For each operator its name, time_us, io_bytes, io_bandwidth_gbps
+            and, when available, cycles, instructions, llc_misses,
+            branch_misses, fp_ops, ipc and llc_bandwidth_gbps.
+        """
+        return json.loads(self._run_individual_counters(number))["ops"]
 
     def exit(self):
         """Exits the dump folder and all its contents"""
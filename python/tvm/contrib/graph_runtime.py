@@ -20,6 +20,7 @@ import numpy as np
 from .._ffi.base import string_types
 from .._ffi.function import get_global_func
 from .._ffi.runtime_ctypes import TVMContext
+from .. import ndarray as nd
 from ..rpc import base as rpc_base
 
 def create(graph_json_str, libmod, ctx):
@@ -154,6 +155,23 @@ class GraphModule(object):
             for k in keys:
                 self._get_input(k).copyfrom(params[k])
 
+    def set_params(self, **params):
+        """Set parameters of the module via kwargs
+
+        Unlike set_input, the values are shared with all execution
+        contexts of the graph, including the ones created earlier.
+
+        Parameters
+        ----------
+        params : dict of str to NDArray or numpy.ndarray
+           The parameters
+        """
+        set_param = self.module["set_param"]
+        for key, value in params.items():
+            if not isinstance(value, nd.NDArray):
+                value = nd.array(value)
+            set_param(key, value)
+
     def run(self, **input_dict):
         """Run forward execution of the graph
 
@@ -234,6 +252,78 @@ class GraphModule(object):
         """
         self._load_params(bytearray(params_bytes))
 
+    def load_params_from_file(self, path, prefetch=False):
+        """Load parameters from a file written by relay.save_param_dict_to_file.
+
+        The file is memory mapped, and parameters that live on the CPU
+        point into the mapping rather than being copied.
+
+        Parameters
+        ----------
+        path : str
+            The parameter file.
+
+        prefetch : bool
+            Whether to ask the OS to read the whole file ahead.
+        """
+        self.module["load_params_from_file"](path, prefetch)
+
+    def create_execution_context(self):
+        """Create a lightweight execution context of the same graph.
+
+        The context shares the compiled module and the parameters with
+        this module, but owns its own activation memory, so that several
+        requests can be executed concurrently. Parameters loaded with
+        load_params or set with set_params on any of the contexts, before
+        or after this call, are visible to all, and so are later updates of
+        them with set_input. Other inputs are private to each context.
+
+        Returns
+        -------
+        graph_module : GraphModule
+            Runtime graph module of the new execution context.
+        """
+        return GraphModule(self.module["create_execution_context"]())
+
+    def set_inter_op_parallelism(self, num_workers, threads_per_op=0):
+        """Run independent operators of the graph concurrently.
+
+        Each operator runs as soon as its inputs are ready, on its own
+        partition of the cores, so that small operators of different
+        branches together use more cores than any of them alone could.
+
+        Parameters
+        ----------
+        num_workers : int
+            The maximum number of concurrent operators, 1 to run the
+            operators one by one.
+
+        threads_per_op : int
+            The threads of each operator, 0 to split the cores evenly
+            between the workers.
+        """
+        self.module["set_inter_op_parallelism"](num_workers, threads_per_op)
+
+    def create_pipeline(self, num_buffers=2):
+        """Create an asynchronous, pipelined front-end of this module.
+
+        Each buffer is an execution context, so up to num_buffers requests
+        are in flight: while one runs, the next one's inputs are copied in
+        and a finished one's outputs are read back.
+
+        Parameters
+        ----------
+        num_buffers : int
+            The number of execution contexts of the pipeline.
+
+        Returns
+        -------
+        pipeline : PipelinedModule
+            The pipelined runtime.
+        """
+        fcreate = get_global_func("tvm.graph_runtime.create_pipelined")
+        return PipelinedModule(fcreate(self.module, num_buffers))
+
     def __getitem__(self, key):
         """Get internal module function
 
@@ -243,3 +333,105 @@ class GraphModule(object):
             The key to the module.
         """
         return self.module[key]
+
+
+class PipelinedModule(object):
+    """Wrapper of the pipelined graph runtime module.
+
+    Parameters
+    ----------
+    module : Module
+        The internal tvm module of the pipelined runtime.
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self._submit = module["submit"]
+        self._wait = module["wait"]
+        self._is_done = module["is_done"]
+        self._get_output = module["get_output"]
+        self._release = module["release"]
+        self._num_outputs = module["get_num_outputs"]()
+
+    def submit(self, callback=None, **inputs):
+        """Submit a request, blocks only while all buffers are busy.
+
+        Parameters
+        ----------
+        callback : function of (int, str), optional
+            Called from the executor thread with the request id and the
+            error message, empty on success, once the request has run.
+            Requests still queued when the runtime is deleted are dropped
+            without calling their callback.
+
+        inputs : dict of str to NDArray or numpy.ndarray
+            The inputs of the request.
+
+        Returns
+        -------
+        request : PipelinedRequest
+            The handle of the request.
+        """
+        args = []
+        for key, value in inputs.items():
+            if not isinstance(value, nd.NDArray):
+                value = nd.array(value)
+            args += [key, value]
+        if callback is not None:
+            args.append(callback)
+        return PipelinedRequest(self, self._submit(*args))
+
+
+class PipelinedRequest(object):
+    """Handle of a request submitted to a PipelinedModule.
+
+    Its buffer returns to the pipeline once result is called.
+    """
+
+    def __init__(self, pipeline, request_id):
+        self.pipeline = pipeline
+        self.request_id = request_id
+
+    def done(self):
+        """Return whether the request finished running."""
+        return self.pipeline._is_done(self.request_id)
+
+    def wait(self):
+        """Block until the request finished running."""
+        self.pipeline._wait(self.request_id)
+
+    def get_output(self, index, out=None):
+        """Get index-th output of the finished request
+
+        Parameters
+        ----------
+        index : int
+            The output index
+
+        out : NDArray
+            The output array container
+        """
+        if out:
+            self.pipeline._get_output(self.request_id, index, out)
+            return out
+        return self.pipeline._get_output(self.request_id, index)
+
+    def release(self):
+        """Return the buffer of the finished request to the pipeline."""
+        self.pipeline._release(self.request_id)
+
+    def result(self):
+        """Wait for the request, copy its outputs out and release it.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            Copies of the outputs of the request.
+        """
+        self.wait()
+        outputs = []
+        for i in range(self.pipeline._num_outputs):
+            out = self.get_output(i)
+            outputs.append(out.copyto(out.ctx))
+        self.release()
+        return outputs
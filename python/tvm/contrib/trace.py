@@ -0,0 +1,58 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Timeline tracing of the runtime, in the Chrome trace format.
+
+The runtime records graph runtime ops, VM packed calls and allocations,
+thread pool tasks, workspace allocations and array copies while tracing is
+on. The result loads into chrome://tracing or Perfetto.
+"""
+import json
+
+from .._ffi.function import get_global_func
+
+
+def start(events_per_thread=1 << 16):
+    """Start tracing, dropping the events of the previous trace.
+
+    Parameters
+    ----------
+    events_per_thread : int
+        The events each thread can record, later ones are dropped.
+    """
+    get_global_func("runtime.trace_start")(events_per_thread)
+
+
+def stop():
+    """Stop tracing."""
+    get_global_func("runtime.trace_stop")()
+
+
+def dump(path=None):
+    """Get the events of the last trace, call it after stop.
+
+    Parameters
+    ----------
+    path : str, optional
+        The file to also write the Chrome trace JSON to.
+
+    Returns
+    -------
+    trace : dict
+        The Chrome trace, with the events in traceEvents.
+    """
+    fdump = get_global_func("runtime.trace_dump")
+    return json.loads(fdump(path) if path else fdump())
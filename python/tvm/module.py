@@ -25,7 +25,51 @@ from ._ffi.function import _init_api
 from ._ffi.libinfo import find_include_path
 from .contrib import cc as _cc, tar as _tar, util as _util
 
-ProfileResult = namedtuple("ProfileResult", ["mean", "results"])
+class ProfileResult(namedtuple("ProfileResult", ["mean", "results"])):
+    """Time costs reported by a time evaluator, in seconds.
+
+    Each entry of `results` is the average cost of one `repeat`.
+    """
+    __slots__ = ()
+
+    def percentile(self, q):
+        """Get the q-th percentile of the costs, with linear interpolation.
+
+        Parameters
+        ----------
+        q : float
+            The percentile in the range [0, 100].
+
+        Returns
+        -------
+        cost : float
+            The interpolated cost.
+        """
+        values = sorted(self.results)
+        if not values:
+            return float("nan")
+        pos = (len(values) - 1) * q / 100.0
+        low = int(pos)
+        high = min(low + 1, len(values) - 1)
+        return values[low] + (values[high] - values[low]) * (pos - low)
+
+    @property
+    def median(self):
+        """The median cost."""
+        return self.percentile(50)
+
+    @property
+    def p95(self):
+        """The 95th percentile cost."""
+        return self.percentile(95)
+
+    @property
+    def std(self):
+        """The standard deviation of the costs."""
+        if not self.results:
+            return float("nan")
+        var = sum((x - self.mean) ** 2 for x in self.results) / len(self.results)
+        return var ** 0.5
 
 
 class Module(ModuleBase):
@@ -143,7 +187,8 @@ class Module(ModuleBase):
             kwargs.update({'options': ["-I" + path for path in find_include_path()]})
         fcompile(file_name, files, **kwargs)
 
-    def time_evaluator(self, func_name, ctx, number=10, repeat=1, min_repeat_ms=0):
+    def time_evaluator(self, func_name, ctx, number=10, repeat=1, min_repeat_ms=0,
+                       warmup=1, flush_cache=False, pin_thread=False):
         """Get an evaluator that measures time cost of running function.
 
         Parameters
@@ -160,8 +205,8 @@ class Module(ModuleBase):
 
         repeat: int, optional
             The number of times to repeat the measurement.
-            In total, the function will be invoked (1 + number x repeat) times,
-            where the first one is warm up and will be discarded.
+            In total, the function will be invoked (warmup + number x repeat) times,
+            where the first `warmup` calls are discarded.
             The returned result contains `repeat` costs,
             each of which is an average of `number` costs.
 
@@ -173,10 +218,24 @@ class Module(ModuleBase):
             i.e., When the run time of one `repeat` falls below this time, the `number` parameter
             will be automatically increased.
 
+        warmup: int, optional
+            The number of calls made and discarded before the measurement,
+            in case there is lazy initialization.
+
+        flush_cache: bool, optional
+            Whether to flush the host caches before every run, so that the
+            measurement reflects cold-cache behavior. Each run is then timed
+            on its own and the flush is excluded from the reported cost.
+
+        pin_thread: bool, optional
+            Whether to pin the measuring thread to its current core.
+
         Note
         ----
-        The function will be invoked  (1 + number x repeat) times,
-        with the first call discarded in case there is lazy initialization.
+        The function will be invoked  (warmup + number x repeat) times,
+        with the first `warmup` calls discarded in case there is lazy initialization.
+        Use number=1 with a larger repeat to get one sample per run, from
+        which ProfileResult can derive the median, p95 and std.
 
         Returns
         -------
@@ -186,7 +245,8 @@ class Module(ModuleBase):
         """
         try:
             feval = _RPCTimeEvaluator(
-                self, func_name, ctx.device_type, ctx.device_id, number, repeat, min_repeat_ms)
+                self, func_name, ctx.device_type, ctx.device_id, number, repeat, min_repeat_ms,
+                warmup, flush_cache, pin_thread)
 
             def evaluator(*args):
                 """Internal wrapped evaluator."""
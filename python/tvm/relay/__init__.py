@@ -112,6 +112,7 @@ fromtext = parser.fromtext
 
 # Param Serialization
 save_param_dict = param_dict.save_param_dict
+save_param_dict_to_file = param_dict.save_param_dict_to_file
 load_param_dict = param_dict.load_param_dict
 
 # Pass manager
@@ -122,6 +122,23 @@ class CompileEngine(NodeBase):
         """clear the existing cached functions"""
         _backend._CompileEngineClear(self)
 
+    def set_disk_cache(self, path):
+        """Set the directory of the persistent kernel cache.
+
+        Kernels compiled by jit and the llvm modules built by relay.build
+        are stored in the directory as LLVM bitcode and reused across
+        processes. Entries are keyed by the lowered code and the target,
+        so a change of schedule or tuning config yields a new entry.
+        Multiple processes can share the same directory. The setting is
+        process wide, it can also be set by TVM_KERNEL_CACHE_DIR.
+
+        Parameters
+        ----------
+        path : str or None
+            The cache directory, None to disable the persistent cache.
+        """
+        _backend._CompileEngineSetDiskCache(self, path if path else "")
+
     def items(self):
         """List items in the cache.
 
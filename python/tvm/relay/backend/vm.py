@@ -105,6 +105,104 @@ def _eval_vm(mod, ctx, *args):
     result = _vm._evaluate_vm(mod, ctx.device_type, ctx.device_id, *cargs)
     return result
 
+def save_executable(mod, path):
+    """
+    Compile a module for the Relay VM and save the executable to a file.
+
+    The executable holds the bytecode, the constant pool and the names
+    of the compiled operators. The operators themselves are returned as
+    a library, which should be exported next to it.
+
+    Parameters
+    ----------
+    mod: relay.Module
+        The module to compile.
+
+    path: str
+        The file to write the executable to.
+
+    Returns
+    -------
+    lib: tvm.module.Module or None
+        The compiled operators, None if the module calls none.
+    """
+    mod = optimize(mod)
+    return _vm._save_vm(mod, path)
+
+def get_bytecode(mod):
+    """
+    Compile a module for the Relay VM and print its bytecode.
+
+    Parameters
+    ----------
+    mod: relay.Module
+        The module to compile.
+
+    Returns
+    -------
+    bytecode: str
+        The instructions of every compiled function.
+    """
+    mod = optimize(mod)
+    return _vm._get_bytecode(mod)
+
+class VMModule(object):
+    """
+    A loaded Relay VM executable.
+
+    Parameters
+    ----------
+    module : tvm.module.Module
+        The module returned by _vm._load_executable.
+    """
+    def __init__(self, module):
+        self.module = module
+        self._invoke = module["invoke"]
+
+    def invoke(self, func_name, *args):
+        """
+        Invoke a function of the executable.
+
+        Parameters
+        ----------
+        func_name: str
+            The name of the function, e.g. "main".
+
+        args: List[tvm.NDArray, np.ndarray]
+            The arguments to the function.
+
+        Returns
+        -------
+        result: tvm.NDArray or Object
+            The result, an NDArray if the function returns a tensor.
+        """
+        return self._invoke(func_name, *convert(list(args)))
+
+def load_executable(path, lib=None, ctx=tvm.cpu()):
+    """
+    Load an executable written by save_executable.
+
+    The constants are memory mapped rather than read into memory.
+
+    Parameters
+    ----------
+    path: str
+        The executable file.
+
+    lib: tvm.module.Module, optional
+        The compiled operators returned by save_executable, or loaded
+        back from the exported library.
+
+    ctx: tvm.Context
+        The TVM context to execute on.
+
+    Returns
+    -------
+    module: VMModule
+        The loaded executable.
+    """
+    return VMModule(_vm._load_executable(path, lib, ctx.device_type, ctx.device_id))
+
 class VMExecutor(Executor):
     """
     An implementation of the executor interface for
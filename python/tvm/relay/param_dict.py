@@ -19,6 +19,7 @@
 import tvm
 
 _save_param_dict = tvm.get_global_func("tvm.relay._save_param_dict")
+_save_param_dict_to_file = tvm.get_global_func("tvm.relay._save_param_dict_to_file")
 _load_param_dict = tvm.get_global_func("tvm.relay._load_param_dict")
 
 def save_param_dict(params):
@@ -57,6 +58,37 @@ def save_param_dict(params):
     return _save_param_dict(*args)
 
 
+def save_param_dict_to_file(params, path):
+    """Save parameter dictionary to a file with a page aligned layout.
+
+    The file can be loaded by the GraphModule with API
+    "load_params_from_file", which memory maps it instead of
+    copying the parameters that live on the CPU.
+
+    Parameters
+    ----------
+    params : dict of str to NDArray
+        The parameter dictionary.
+
+    path : str
+        The file to write.
+
+    Examples
+    --------
+    .. code-block:: python
+
+       graph, lib, params = tvm.relay.build(func, target=target, params=params)
+       tvm.relay.save_param_dict_to_file(params, "deploy.params")
+       module = graph_runtime.create(graph, lib, tvm.cpu(0))
+       module.load_params_from_file("deploy.params")
+    """
+    args = [path]
+    for k, v in params.items():
+        args.append(k)
+        args.append(tvm.nd.array(v))
+    _save_param_dict_to_file(*args)
+
+
 def load_param_dict(param_bytes):
     """Load parameter dictionary to binary bytes.
 
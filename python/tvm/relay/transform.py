@@ -69,12 +69,22 @@ class PassContext(RelayNode):
 
     disabled_pass : Optional[Union[List[str], Set[str], Tuple[str]]]
         The list of passes that are disabled.
+
+    num_threads : Optional[int]
+        The number of threads used to run thread-safe function passes,
+        non-positive for all cores.
+
+    instrument : Optional[bool]
+        Whether to record the wall time, expression node counts and memory
+        growth of every pass executed under this context.
     """
     def __init__(self,
                  opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
-                 disabled_pass=None):
+                 disabled_pass=None,
+                 num_threads=1,
+                 instrument=False):
         if isinstance(fallback_device, str):
             fallback_device = _nd.context(fallback_device).device_type
         elif isinstance(fallback_device, TVMContext):
@@ -95,7 +105,7 @@ class PassContext(RelayNode):
 
         self.__init_handle_by_constructor__(_transform.PassContext, opt_level,
                                             fallback_device, required,
-                                            disabled)
+                                            disabled, num_threads, instrument)
 
     def __enter__(self):
         _transform.EnterPassContext(self)
@@ -109,11 +119,39 @@ class PassContext(RelayNode):
         """Return the current pass context."""
         return _transform.GetCurrentPassContext()
 
+    def profile_summary(self):
+        """Summarize the passes recorded under instrumentation.
+
+        Returns
+        -------
+        summary : str
+            A table with the number of calls, total time, node count change,
+            maximum node count and memory growth of every pass.
+        """
+        return _transform.PassProfileSummary(self)
+
+    def dump_trace(self, path):
+        """Write the passes recorded under instrumentation to a trace file
+        in the Chrome trace event format, viewable in chrome://tracing.
+
+        Parameters
+        ----------
+        path : str
+            The file to write to.
+        """
+        _transform.PassProfileDumpTrace(self, path)
+
+    def clear_profile(self):
+        """Drop the passes recorded so far."""
+        _transform.PassProfileClear(self)
+
 
 def build_config(opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
-                 disabled_pass=None):
+                 disabled_pass=None,
+                 num_threads=1,
+                 instrument=False):
     """Configure the build behavior by setting config variables.
 
     Parameters
@@ -145,13 +183,21 @@ def build_config(opt_level=2,
     disabled_pass: set of str, optional
         Optimization passes to be disabled during optimization.
 
+    num_threads: int, optional
+        The number of threads used to run thread-safe function passes over
+        the functions of a module, non-positive for all cores.
+
+    instrument: bool, optional
+        Whether to record per-pass timing, node counts and memory growth,
+        see PassContext.profile_summary and PassContext.dump_trace.
+
     Returns
     -------
     pass_context: PassContext
         The pass context for optimizations.
     """
     return PassContext(opt_level, fallback_device, required_pass,
-                       disabled_pass)
+                       disabled_pass, num_threads, instrument)
 
 
 @register_relay_node
@@ -76,6 +76,59 @@ class RPCSession(object):
         ctx._rpc_sess = self
         return ctx
 
+    def config_copy(self, chunk_size=4 << 20, window=4):
+        """Configure how array copies are transferred.
+
+        Copies larger than chunk_size are split into chunks, and up to
+        window chunks are in flight at the same time.
+
+        Parameters
+        ----------
+        chunk_size : int, optional
+            The number of bytes per chunk, 0 sends each copy as a whole.
+
+        window : int, optional
+            The maximum number of chunks in flight.
+        """
+        base._SessConfigCopy(self._sess, chunk_size, window)
+
+    def async_call(self, func, *args):
+        """Call a remote function without waiting for its result.
+
+        Several calls can be in flight over the session, along with
+        synchronous calls and array copies. The server runs them on a
+        worker pool, see :any:`config_async_workers`. A server that does
+        not support asynchronous calls runs the call before this returns.
+
+        Parameters
+        ----------
+        func : Function
+            A function obtained from this session.
+
+        args : list
+            The arguments to the function.
+
+        Returns
+        -------
+        future : RPCFuture
+            The handle to the result of the call.
+        """
+        return RPCFuture(self, base._AsyncCall(func, *args))
+
+    def config_async_workers(self, num_workers):
+        """Set the number of workers that run asynchronous calls on the server.
+
+        This takes effect if called before the first asynchronous call
+        of the session. With zero workers the server runs the calls in order
+        on the thread that handles the session.
+
+        Parameters
+        ----------
+        num_workers : int
+            The number of workers.
+        """
+        self.get_function("rpc._ConfigAsyncWorkers")(num_workers)
+
     def upload(self, data, target=None):
         """Upload file to remote runtime temp folder
 
@@ -176,6 +229,39 @@ class RPCSession(object):
         return self.context(12, dev_id)
 
 
+class RPCFuture(object):
+    """The result of an asynchronous remote call.
+
+    Do not directly create the object, call RPCSession.async_call
+    """
+    def __init__(self, sess, call_id):
+        self._sess = sess
+        self._id = call_id
+        self._waited = False
+        self._result = None
+
+    def done(self):
+        """Whether the result has been received.
+
+        Takes the replies that already arrived on the channel, this
+        never blocks on the call itself.
+        """
+        return self._waited or base._AsyncDone(self._sess._sess, self._id)
+
+    def wait(self):
+        """Wait for the call to complete and get its result.
+
+        Returns
+        -------
+        result : object
+            The return value of the remote function.
+        """
+        if not self._waited:
+            self._result = base._AsyncWait(self._sess._sess, self._id)
+            self._waited = True
+        return self._result
+
+
 class LocalSession(RPCSession):
     """RPCSession interface backed by local environment.
 
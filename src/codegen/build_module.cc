@@ -645,7 +645,8 @@ TVM_STATIC_IR_FUNCTOR(IRPrinter, vtable)
   p->stream << "dump_pass_ir=" << op->dump_pass_ir << ", ";
   p->stream << "instrument_bound_checkers=" << op->instrument_bound_checkers << ", ";
   p->stream << "disable_select_rewriting=" << op->disable_select_rewriting;
-  p->stream << "disable_vectorize=" << op->disable_vectorize;
+  p->stream << "disable_vectorize=" << op->disable_vectorize << ", ";
+  p->stream << "build_threads=" << op->build_threads;
   p->stream << ")";
 });
 
@@ -29,6 +29,7 @@
 #include <dmlc/memory_io.h>
 #include <sstream>
 #include <iostream>
+#include "../runtime/module_util.h"
 
 namespace tvm {
 namespace codegen {
@@ -53,6 +54,9 @@ std::string PackImportsToC(const runtime::Module& mod, bool system_lib) {
   std::string bin;
   dmlc::MemoryStringStream ms(&bin);
   dmlc::Stream* stream = &ms;
+  // Write an indexed blob so that the runtime can defer loading
+  // each imported module until one of its functions is requested.
+  stream->Write(runtime::kModuleBlobIndexMagic);
   uint64_t sz = static_cast<uint64_t>(mod->imports().size());
   stream->Write(sz);
   for (runtime::Module im : mod->imports()) {
@@ -60,7 +64,11 @@ std::string PackImportsToC(const runtime::Module& mod, bool system_lib) {
         << "Only support simply one-level hierarchy";
     std::string tkey = im->type_key();
     stream->Write(tkey);
-    im->SaveToBinary(stream);
+    stream->Write(im->GetFunctionNames());
+    std::string payload;
+    dmlc::MemoryStringStream payload_stream(&payload);
+    im->SaveToBinary(&payload_stream);
+    stream->Write(payload);
   }
   // translate to C program
   std::ostringstream os;
@@ -23,6 +23,7 @@
  */
 #ifdef TVM_LLVM_VERSION
 
+#include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/ir_pass.h>
 #include <unordered_map>
@@ -402,10 +403,10 @@ void CodeGenCPU::CreateParallelLaunch(const Stmt& body, int num_task) {
   Array<Var> vfields = ir::UndefinedVars(body, {});
   uint64_t nbytes;
   llvm::Value* cdata = PackClosureData(vfields, &nbytes);
-  BasicBlock* par_launch_end = CheckCallSuccess(
-      builder_->CreateCall(
-          RuntimeTVMParallelLaunch(),
-          {f, builder_->CreatePointerCast(cdata, t_void_p_), ConstInt32(num_task)}));
+  llvm::CallInst* launch = builder_->CreateCall(
+      RuntimeTVMParallelLaunch(),
+      {f, builder_->CreatePointerCast(cdata, t_void_p_), ConstInt32(num_task)});
+  BasicBlock* par_launch_end = CheckCallSuccess(launch);
   // Setup the closure function.
   BasicBlock *lambda_entry = BasicBlock::Create(*ctx_, "entry", f);
   builder_->SetInsertPoint(lambda_entry);
@@ -436,6 +437,11 @@ void CodeGenCPU::CreateParallelLaunch(const Stmt& body, int num_task) {
   std::swap(function_, f);
   CHECK_NE(par_env.parallel_loop_count, 0)
       << "Cannot find parallel loop within parallel launch";
+  // The loops partition by num_task, so without a barrier the runtime
+  // can run the lambda as more tasks than threads.
+  if (num_task == 0 && !par_env.has_barrier) {
+    launch->setArgOperand(2, ConstInt32(TVM_PARALLEL_NUM_TASK_SPLITTABLE));
+  }
   builder_->SetInsertPoint(par_launch_end);
 }
 
@@ -767,6 +773,7 @@ void CodeGenCPU::VisitStmt_(const AttrStmt* op) {
           << "Cannot not place within parallel loop as the workload may differ, "
           << " place it between parallel and parallel_launch_point";
       this->VisitStmt(op->body);
+      parallel_env_.has_barrier = true;
       builder_->CreateCall(
           RuntimeTVMParallelBarrier(),
           {MakeValue(parallel_env_.task_id),  parallel_env_.penv});
@@ -81,6 +81,7 @@ class CodeGenCPU : public CodeGenLLVM {
     bool stride_pattern{false};
     bool in_parallel_loop{false};
     int parallel_loop_count{0};
+    bool has_barrier{false};
     llvm::Value* penv{nullptr};
   };
   // Get runtime functions
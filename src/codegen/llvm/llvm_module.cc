@@ -25,11 +25,14 @@
 #ifdef TVM_LLVM_VERSION
 #include <tvm/runtime/packed_func.h>
 #include <tvm/codegen.h>
+#include <tvm/build_module.h>
+#include <algorithm>
 #include <mutex>
 #include "llvm_common.h"
 #include "codegen_llvm.h"
 #include "../../runtime/file_util.h"
 #include "../../runtime/module_util.h"
+#include "../../common/parallel_for.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolSize.h"
 #include "llvm/ADT/STLExtras.h"
@@ -307,14 +310,47 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     bool system_lib = (target.find("-system-lib") != std::string::npos);
     CHECK_NE(funcs.size(), 0U);
     ctx_ = std::make_shared<llvm::LLVMContext>();
-    std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm_.get());
     entry_func_ = funcs[0]->name;
-    cg->Init(funcs[0]->name, tm_.get(), ctx_.get(), system_lib, system_lib);
-    for (LoweredFunc f :  funcs) {
-      cg->AddFunction(f);
+    size_t num_parts = std::min(
+        static_cast<size_t>(common::ResolveNumThreads(BuildConfig::Current()->build_threads)),
+        funcs.size());
+    if (num_parts <= 1) {
+      module_ = CodeGenPart(funcs, entry_func_, tm_.get(), ctx_.get(), system_lib);
+    } else {
+      // Generate and optimize the functions in independent parts, each with
+      // its own context, then link the parts back through bitcode.
+      std::vector<std::string> bitcode(num_parts);
+      common::ParallelFor(num_parts, num_parts, [&](size_t i) {
+          Array<LoweredFunc> part;
+          for (size_t j = i; j < funcs.size(); j += num_parts) {
+            part.push_back(funcs[j]);
+          }
+          llvm::LLVMContext ctx;
+          std::unique_ptr<llvm::TargetMachine> tm = GetLLVMTargetMachine(target);
+          std::unique_ptr<llvm::Module> m = CodeGenPart(
+              part, i == 0 ? entry_func_ : "", tm.get(), &ctx, system_lib);
+          llvm::raw_string_ostream os(bitcode[i]);
+#if TVM_LLVM_VERSION <= 60
+          llvm::WriteBitcodeToFile(m.get(), os);
+#else
+          llvm::WriteBitcodeToFile(*m, os);
+#endif
+          os.flush();
+        });
+      for (size_t i = 0; i < num_parts; ++i) {
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::MemoryBuffer> buf =
+            llvm::MemoryBuffer::getMemBuffer(bitcode[i], "", false);
+        std::unique_ptr<llvm::Module> m = llvm::parseIR(*buf, err, *ctx_);
+        CHECK(m != nullptr) << "Cannot read back generated code: " << err.getMessage().str();
+        if (i == 0) {
+          module_ = std::move(m);
+        } else {
+          CHECK(!llvm::Linker::linkModules(*module_, std::move(m)))
+              << "Failed to link modules";
+        }
+      }
     }
-    cg->AddMainFunction(funcs[0]->name);
-    module_ = cg->Finish();
     std::string verify_errors_storage;
     llvm::raw_string_ostream verify_errors(verify_errors_storage);
     LOG_IF(FATAL, llvm::verifyModule(*module_, &verify_errors))
@@ -356,7 +392,59 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     tm_ = GetLLVMTargetMachine(target_);
   }
 
+  /*!
+   * \brief Rename functions of the module before it is JIT compiled.
+   * \param renames Pairs of the old and the new name.
+   * \return Whether every function was renamed, the module must not be used
+   *  otherwise.
+   */
+  bool RenameFunctions(const std::vector<std::pair<std::string, std::string> >& renames) {
+    CHECK(ee_ == nullptr) << "Cannot rename the functions of a JIT compiled module";
+    // The system library registers its functions under names held in constants.
+    if (mptr_->getFunction("__tvm_module_startup") != nullptr) return false;
+    std::vector<llvm::Function*> funcs;
+    for (const auto& kv : renames) {
+      llvm::Function* f = mptr_->getFunction(kv.first);
+      if (f == nullptr || f->isDeclaration()) return false;
+      funcs.push_back(f);
+    }
+    // A new name can be the old name of another function, free them all first.
+    for (size_t i = 0; i < funcs.size(); ++i) {
+      funcs[i]->setName("__tvm_rename_" + std::to_string(i));
+    }
+    for (size_t i = 0; i < funcs.size(); ++i) {
+      funcs[i]->setName(renames[i].second);
+      if (funcs[i]->getName() != renames[i].second) return false;
+    }
+    return true;
+  }
+
  private:
+  /*!
+   * \brief Generate and optimize code for a set of functions.
+   * \param funcs The functions.
+   * \param entry_func The entry function, empty if it is not among funcs.
+   * \param tm The target machine.
+   * \param ctx The context to create the module in.
+   * \param system_lib Whether to register the functions in the system library.
+   * \return The optimized module.
+   */
+  static std::unique_ptr<llvm::Module> CodeGenPart(const Array<LoweredFunc>& funcs,
+                                                   const std::string& entry_func,
+                                                   llvm::TargetMachine* tm,
+                                                   llvm::LLVMContext* ctx,
+                                                   bool system_lib) {
+    std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm);
+    cg->Init(funcs[0]->name, tm, ctx, system_lib, system_lib);
+    for (LoweredFunc f :  funcs) {
+      cg->AddFunction(f);
+    }
+    if (!entry_func.empty()) {
+      cg->AddMainFunction(entry_func);
+    }
+    return cg->Finish();
+  }
+
   void processPerfMap(const std::vector<PerfMapEntry>& perf_map) {
     std::stringstream ss_perf_map;
     ss_perf_map << "/tmp/perf-" << getpid() << ".map";
@@ -489,6 +577,24 @@ TVM_REGISTER_API("module.loadfile_ll")
     *rv = runtime::Module(n);
   });
 
+TVM_REGISTER_API("module.loadfile_bc")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    std::shared_ptr<LLVMModuleNode> n = std::make_shared<LLVMModuleNode>();
+    n->LoadIR(args[0]);
+    *rv = runtime::Module(n);
+  });
+
+TVM_REGISTER_API("codegen.llvm_rename_funcs")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    runtime::Module mod = args[0];
+    CHECK_EQ(std::string(mod->type_key()), "llvm");
+    std::vector<std::pair<std::string, std::string> > renames;
+    for (int i = 1; i + 1 < args.num_args; i += 2) {
+      renames.emplace_back(args[i].operator std::string(), args[i + 1].operator std::string());
+    }
+    *rv = static_cast<LLVMModuleNode*>(mod.operator->())->RenameFunctions(renames);
+  });
+
 TVM_REGISTER_API("codegen.llvm_target_enabled")
 .set_body([](TVMArgs args, TVMRetValue* rv) {
     InitializeLLVM();
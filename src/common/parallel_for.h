@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file parallel_for.h
+ * \brief Minimum parallel loop for the compiler, on plain threads.
+ */
+#ifndef TVM_COMMON_PARALLEL_FOR_H_
+#define TVM_COMMON_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace common {
+/*!
+ * \brief Resolve a requested number of threads.
+ * \param num_threads The requested number, non-positive for all cores.
+ * \return The number of threads to use.
+ */
+inline int ResolveNumThreads(int num_threads) {
+  if (num_threads > 0) return num_threads;
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+/*!
+ * \brief Call fwork(i) for every i in [0, n) on up to num_threads threads.
+ *
+ *  The calling thread takes part in the work, tasks are handed out in order.
+ *  Once a task throws, no further tasks are started, and the first
+ *  exception is rethrown on the calling thread after all threads finish.
+ *
+ * \param n The number of tasks.
+ * \param num_threads The number of threads, non-positive for all cores.
+ * \param fwork The task body.
+ */
+inline void ParallelFor(size_t n,
+                        int num_threads,
+                        const std::function<void(size_t)>& fwork) {
+  size_t nthreads = std::min(static_cast<size_t>(ResolveNumThreads(num_threads)), n);
+  if (nthreads <= 1) {
+    for (size_t i = 0; i < n; ++i) fwork(i);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&]() {
+    for (size_t i = next++; i < n && !failed; i = next++) {
+      try {
+        fwork(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!failed) error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < nthreads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace common
+}  // namespace tvm
+#endif  // TVM_COMMON_PARALLEL_FOR_H_
@@ -23,10 +23,17 @@
  */
 #include <tvm/build_module.h>
 #include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
 #include <tvm/relay/expr.h>
 #include <tvm/relay/transform.h>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
 
+#include "kernel_disk_cache.h"
 #include "utils.h"
 
 namespace tvm {
@@ -442,8 +449,94 @@ class RelayBuildModule : public runtime::ModuleNode {
     ret_.graph_json = graph_codegen_->GetJSON();
     ret_.params = graph_codegen_->GetParams();
 
-    ret_.mod = tvm::build(graph_codegen_->GetLoweredFunc(), target_host_,
-                          BuildConfig::Current());
+    ret_.mod = BuildLoweredFunc(graph_codegen_->GetLoweredFunc());
+  }
+
+  /*!
+   * \brief Build the lowered functions into a runtime module, going through
+   *  the persistent kernel cache when it is enabled.
+   *
+   * \param lowered_funcs The lowered functions of each target.
+   * \return The runtime module.
+   */
+  runtime::Module BuildLoweredFunc(
+      const Map<std::string, Array<LoweredFunc> >& lowered_funcs) {
+    BuildConfig config = BuildConfig::Current();
+    std::shared_ptr<KernelDiskCache> disk_cache = KernelDiskCache::Global();
+    std::string disk_key;
+    std::vector<std::string> names;
+    if (disk_cache != nullptr && lowered_funcs.size() != 0) {
+      // The lowered code already reflects the build config. The unique
+      // function names depend on what the process compiled before, so they
+      // are masked in the key and the cached functions are renamed on load.
+      std::vector<std::pair<std::string, Array<LoweredFunc> > > targets(
+          lowered_funcs.begin(), lowered_funcs.end());
+      std::sort(targets.begin(), targets.end(),
+                [](const std::pair<std::string, Array<LoweredFunc> >& a,
+                   const std::pair<std::string, Array<LoweredFunc> >& b) {
+                  return a.first < b.first;
+                });
+      std::ostringstream os;
+      os << "version " << TVM_VERSION << '\n'
+         << "target_host " << (target_host_.defined() ? target_host_->str() : "") << '\n';
+      for (const auto& kv : targets) {
+        os << "target " << kv.first << '\n';
+        for (const LoweredFunc& f : kv.second) {
+          names.push_back(f->name);
+          KernelDiskCache::PrintLoweredFunc(f, os);
+          os << '\n';
+        }
+      }
+      disk_key = KernelDiskCache::MaskNames(os.str(), names);
+      runtime::Module mod;
+      std::string stored_names;
+      if (disk_cache->Load(disk_key, &mod, &stored_names) &&
+          RenameFunctions(mod, stored_names, names)) {
+        return mod;
+      }
+    }
+    runtime::Module mod = tvm::build(lowered_funcs, target_host_, config);
+    if (!disk_key.empty()) {
+      std::ostringstream os;
+      for (const std::string& name : names) {
+        os << name << ' ';
+      }
+      disk_cache->Save(disk_key, mod, os.str());
+    }
+    return mod;
+  }
+
+  /*!
+   * \brief Give the functions of a module loaded from the disk cache the
+   *  names used by the current build.
+   *
+   * \param mod The module.
+   * \param stored_names The space separated names the module was saved with.
+   * \param names The names of the current build, in the same order.
+   * \return Whether the module has the current names.
+   */
+  static bool RenameFunctions(runtime::Module mod,
+                              const std::string& stored_names,
+                              const std::vector<std::string>& names) {
+    std::istringstream is(stored_names);
+    std::vector<std::string> old_names{std::istream_iterator<std::string>(is),
+                                       std::istream_iterator<std::string>()};
+    if (old_names.size() != names.size()) return false;
+    if (old_names == names) return true;
+    const runtime::PackedFunc* frename = runtime::Registry::Get("codegen.llvm_rename_funcs");
+    if (frename == nullptr) return false;
+    std::vector<TVMValue> values(names.size() * 2 + 1);
+    std::vector<int> type_codes(names.size() * 2 + 1);
+    runtime::TVMArgsSetter setter(values.data(), type_codes.data());
+    setter(0, mod);
+    for (size_t i = 0; i < names.size(); ++i) {
+      setter(i * 2 + 1, old_names[i]);
+      setter(i * 2 + 2, names[i]);
+    }
+    runtime::TVMRetValue rv;
+    frename->CallPacked(
+        runtime::TVMArgs(values.data(), type_codes.data(), static_cast<int>(values.size())), &rv);
+    return rv;
   }
 
  protected:
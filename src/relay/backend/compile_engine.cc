@@ -35,7 +35,10 @@
 #include <mutex>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include "compile_engine.h"
+#include "kernel_disk_cache.h"
+#include "../../common/parallel_for.h"
 
 namespace tvm {
 namespace relay {
@@ -294,10 +297,24 @@ class CompileEngineImpl : public CompileEngineNode {
   PackedFunc JIT(const CCacheKey& key) final {
     CCacheValue value = LowerInternal(key);
     if (value->packed_func != nullptr) return value->packed_func;
+    std::shared_ptr<KernelDiskCache> disk_cache = KernelDiskCache::Global();
+    std::string disk_key;
+    if (disk_cache != nullptr && value->cached_func->funcs.size() != 0) {
+      disk_key = DiskCacheKey(key, value->cached_func);
+      runtime::Module m;
+      std::string func_name;
+      if (disk_cache->Load(disk_key, &m, &func_name)) {
+        value->packed_func = m.GetFunction(func_name);
+        if (value->packed_func != nullptr) return value->packed_func;
+      }
+    }
     // build the function.
     if (const auto* f = runtime::Registry::Get("relay.backend.build")) {
       tvm::runtime::Module m = (*f)(value->cached_func->funcs, key->target);
       value->packed_func = m.GetFunction(value->cached_func->func_name);
+      if (!disk_key.empty()) {
+        disk_cache->Save(disk_key, m, value->cached_func->func_name);
+      }
     } else {
       LOG(FATAL) << "relay.backend.build is not registered";
     }
@@ -305,6 +322,41 @@ class CompileEngineImpl : public CompileEngineNode {
   }
   void Clear() final {
     cache_.clear();
+    batch_lowered_.clear();
+  }
+  // Lower the functions of keys not cached yet.
+  void LowerBatch(const Array<CCacheKey>& keys, int num_threads) final {
+    BuildConfig config = BuildConfig::Current();
+    // Custom lowering passes live in the frontend, which cannot be
+    // entered from the worker threads; leave everything to Lower.
+    if (!config->add_lower_pass.empty() || config->dump_pass_ir) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Schedules are created in order on the calling thread. They call into
+    // the frontend, and this keeps the unique names as in serial lowering.
+    std::vector<LowerJob> jobs;
+    std::unordered_map<CCacheKey, size_t> index;
+    for (const CCacheKey& key : keys) {
+      if (cache_.count(key) || index.count(key)) continue;
+      index[key] = jobs.size();
+      jobs.push_back(CreateLowerJob(key));
+    }
+    std::vector<char> done(jobs.size(), 0);
+    common::ParallelFor(jobs.size(), num_threads, [&](size_t i) {
+        // Failures are reported again when Lower retries the function.
+        try {
+          RunLowerJob(&jobs[i], config);
+          done[i] = 1;
+        } catch (const dmlc::Error&) {
+        }
+      });
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      if (!done[i]) continue;
+      CCacheValue value(make_node<CCacheValueNode>());
+      value->use_count = 0;
+      value->cached_func = CachedFunc(jobs[i].cache_node);
+      cache_[jobs[i].key] = value;
+      batch_lowered_.insert(jobs[i].key);
+    }
   }
   // List all items in the cache.
   Array<NodeRef> ListItems() {
@@ -329,13 +381,26 @@ class CompileEngineImpl : public CompileEngineNode {
   }
 
  private:
+  /*! \brief A function on its way through lowering. */
+  struct LowerJob {
+    /*! \brief The key of the function. */
+    CCacheKey key;
+    /*! \brief The schedule, undefined when no lowering is needed. */
+    Schedule schedule;
+    /*! \brief The cached function being populated. */
+    NodePtr<CachedFuncNode> cache_node;
+  };
   // implement lowered func
   CCacheValue LowerInternal(const CCacheKey& key)  {
     std::lock_guard<std::mutex> lock(mutex_);
     CCacheValue value;
     auto it = cache_.find(key);
     if (it != cache_.end()) {
-      it->second->use_count += 1;
+      // The first lookup of a batch lowered function is the one that
+      // would have lowered it, it is not a reuse.
+      if (batch_lowered_.erase(key) == 0) {
+        it->second->use_count += 1;
+      }
       if (it->second->cached_func.defined()) return it->second;
       value = it->second;
     } else {
@@ -343,40 +408,84 @@ class CompileEngineImpl : public CompileEngineNode {
       value->use_count = 0;
       cache_[key] = value;
     }
+    CHECK(!value->cached_func.defined());
+    LowerJob job = CreateLowerJob(key);
+    if (job.schedule.defined()) {
+      // Enforce use the target.
+      With<Target> target_scope(key->target);
+      Array<Tensor> all_args = job.cache_node->inputs;
+      for (Tensor arg : job.cache_node->outputs) {
+        all_args.push_back(arg);
+      }
+      // lower the function
+      if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
+        job.cache_node->funcs = (*f)(
+            job.schedule, all_args, job.cache_node->func_name, key->source_func);
+      } else {
+        RunLowerJob(&job, BuildConfig::Create());
+      }
+    }
+    value->cached_func = CachedFunc(job.cache_node);
+    return value;
+  }
+  /*!
+   * \brief Create the schedule of a function and assign its unique name.
+   * \param key The key of the function.
+   * \return The job to be lowered.
+   */
+  LowerJob CreateLowerJob(const CCacheKey& key) {
     // Enforce use the target.
     With<Target> target_scope(key->target);
-
-    CHECK(!value->cached_func.defined());
+    LowerJob job;
+    job.key = key;
     auto spair = CreateSchedule(key->source_func, key->target);
-    auto cache_node = make_node<CachedFuncNode>(
-        *(spair.second.operator->()));
-
+    job.cache_node = make_node<CachedFuncNode>(*(spair.second.operator->()));
     // Skip lowering for device copy node.
     const Expr body = (key->source_func)->body;
     if (const CallNode* call_node = body.as<CallNode>()) {
-      if (call_node->attrs.as<DeviceCopyAttrs>()) {
-        value->cached_func = CachedFunc(cache_node);
-        return value;
-      }
+      if (call_node->attrs.as<DeviceCopyAttrs>()) return job;
     }
-
-    cache_node->func_name = GetUniqueName(cache_node->func_name);
+    job.schedule = spair.first;
+    job.cache_node->func_name = GetUniqueName(job.cache_node->func_name);
+    return job;
+  }
+  /*!
+   * \brief Lower a scheduled function without entering the frontend,
+   *  safe to call concurrently for different jobs.
+   * \param job The job.
+   * \param config The build config to lower with.
+   */
+  static void RunLowerJob(LowerJob* job, const BuildConfig& config) {
+    if (!job->schedule.defined()) return;
+    With<Target> target_scope(job->key->target);
     // NOTE: array will copy on write.
-    Array<Tensor> all_args = cache_node->inputs;
-    for (Tensor arg : cache_node->outputs) {
+    Array<Tensor> all_args = job->cache_node->inputs;
+    for (Tensor arg : job->cache_node->outputs) {
       all_args.push_back(arg);
     }
-    // lower the function
-    if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
-      cache_node->funcs = (*f)(
-          spair.first, all_args, cache_node->func_name, key->source_func);
-    } else {
-      tvm::BuildConfig bcfg = BuildConfig::Create();
-      std::unordered_map<Tensor, Buffer> binds;
-      cache_node->funcs = tvm::lower(spair.first, all_args, cache_node->func_name, binds, bcfg);
+    std::unordered_map<Tensor, Buffer> binds;
+    job->cache_node->funcs = tvm::lower(
+        job->schedule, all_args, job->cache_node->func_name, binds, config);
+  }
+  /*!
+   * \brief Get the persistent cache key of a lowered function.
+   *  The lowered code reflects the schedule and tuning config in use,
+   *  so it is part of the key along with the source and the target.
+   *  The unique function name depends on the order of compilation and
+   *  is masked, each JIT module holds a single kernel anyway.
+   * \param key The in memory cache key.
+   * \param cfunc The lowered function.
+   * \return The key.
+   */
+  static std::string DiskCacheKey(const CCacheKey& key, const CachedFunc& cfunc) {
+    std::ostringstream os;
+    os << "version " << TVM_VERSION << '\n'
+       << "target " << key->target->str() << '\n'
+       << AsText(key->source_func, true) << '\n';
+    for (const LoweredFunc& f : cfunc->funcs) {
+      KernelDiskCache::PrintLoweredFunc(f, os);
     }
-    value->cached_func = CachedFunc(cache_node);
-    return value;
+    return KernelDiskCache::MaskNames(os.str(), {cfunc->func_name});
   }
   /*!
    * \brief Get unique name from name.
@@ -407,6 +516,8 @@ class CompileEngineImpl : public CompileEngineNode {
   std::unordered_map<std::string, int> name_map_;
   /*! \brief internal compiler cache */
   std::unordered_map<CCacheKey, CCacheValue> cache_;
+  /*! \brief keys lowered by LowerBatch and not looked up since */
+  std::unordered_set<CCacheKey> batch_lowered_;
 };
 
 /*! \brief The global compile engine */
@@ -444,6 +555,12 @@ TVM_REGISTER_GLOBAL("relay.backend._CompileEngineJIT")
       return self->JIT(key);
     });
 
+TVM_REGISTER_GLOBAL("relay.backend._CompileEngineSetDiskCache")
+.set_body_typed<void(CompileEngine, std::string)>(
+    [](CompileEngine self, std::string dir) {
+      KernelDiskCache::SetGlobal(dir);
+    });
+
 TVM_REGISTER_GLOBAL("relay.backend._CompileEngineListItems")
 .set_body_typed<Array<NodeRef>(CompileEngine)>(
     [](CompileEngine self){
@@ -169,8 +169,16 @@ class CompileEngineNode : public Node {
    * \return The result.
    */
   virtual PackedFunc JIT(const CCacheKey& key) = 0;
-  /*! \brief clear the cache. */
+  /*! \brief clear the cache and the unique function names. */
   virtual void Clear() = 0;
+  /*!
+   * \brief Lower the functions that are not cached yet, in parallel.
+   *  Schedules are still created in order on the calling thread,
+   *  so later calls to Lower return the same results as without it.
+   * \param keys The keys to the functions.
+   * \param num_threads The number of threads, non-positive for all cores.
+   */
+  virtual void LowerBatch(const Array<CCacheKey>& keys, int num_threads) = 0;
 
   // VisitAttrs
   void VisitAttrs(AttrVisitor*) final {}
@@ -25,6 +25,7 @@
 
 #include <dmlc/any.h>
 #include <dmlc/json.h>
+#include <tvm/build_module.h>
 #include <tvm/node/ir_functor.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/runtime/device_api.h>
@@ -189,6 +190,21 @@ class GraphOpNode : public GraphNode {
   const std::string op_type_name_{"tvm_op"};
 };
 
+/*! \brief Collect the primitive calls in the order graph codegen lowers them. */
+class PrimitiveCallCollector : public ExprVisitor {
+ public:
+  void VisitExpr_(const CallNode* op) final {
+    if (const auto* func = op->op.as<FunctionNode>()) {
+      if (func->IsPrimitive()) calls.push_back(GetRef<Call>(op));
+    }
+    for (const Expr& arg : op->args) {
+      VisitExpr(arg);
+    }
+  }
+  /*! \brief The collected calls. */
+  std::vector<Call> calls;
+};
+
 /*! \brief Code generator for graph runtime */
 class GraphRuntimeCodegen
     : public ::tvm::relay::ExprFunctor<std::vector<GraphNodeRef>(const Expr&)> {
@@ -202,6 +218,18 @@ class GraphRuntimeCodegen
   LoweredOutput Codegen(relay::Function func) {
     auto pf = GetPackedFunc("relay.backend.GraphPlanMemory");
     storage_device_map_ = (*pf)(func);
+    int num_threads = BuildConfig::Current()->build_threads;
+    if (num_threads != 1) {
+      // Lower the primitive functions up front on multiple threads,
+      // the traversal below then finds them in the cache.
+      PrimitiveCallCollector collector;
+      collector.VisitExpr(func->body);
+      Array<CCacheKey> keys;
+      for (const Call& call : collector.calls) {
+        keys.push_back(CCacheKeyNode::make(Downcast<Function>(call->op), GetTarget(call)));
+      }
+      compile_engine_->LowerBatch(keys, num_threads);
+    }
     // First we convert all the parameters into input nodes.
     for (auto param : func->params) {
       auto node_ptr = GraphInputNode::make_node_ptr(param->name_hint(), GraphAttrs());
@@ -382,27 +410,12 @@ class GraphRuntimeCodegen
     }
     return fields;
   }
-  std::vector<GraphNodeRef> VisitExpr_(const CallNode* op) override {
-    Expr expr = GetRef<Expr>(op);
-    Function func;
-    if (op->op.as<OpNode>()) {
-      LOG(FATAL) << "Operators should be transformed away; try applying"
-                 << "the fuse_ops transformation to the expression.";
-    } else if (op->op.as<GlobalVarNode>()) {
-      LOG(FATAL) << "Not implemented";
-    } else if (op->op.as<FunctionNode>()) {
-      func = GetRef<Function>(op->op.as<FunctionNode>());
-    } else {
-      LOG(FATAL) << "TVM runtime does not support calls to " << op->op->type_key();
-    }
-    if (!func->IsPrimitive()) {
-      LOG(FATAL) << "TVM only support calls to primitive functions "
-                 << "(i.e functions composed of fusable operator invocations)";
-    }
-
-    CHECK_GE(storage_device_map_.count(expr), 0);
-    auto pf0 = GetPackedFunc("relay.backend._make_CCacheKey");
-    auto pf1 = GetPackedFunc("relay.backend._CompileEngineLower");
+  /*!
+   * \brief Get the target a call runs on.
+   * \param expr The call.
+   * \return The target.
+   */
+  Target GetTarget(const Expr& expr) {
     auto &device_type = storage_device_map_[expr][1];
     auto call_dev_type = device_type[0]->value;
     Target target;
@@ -425,6 +438,31 @@ class GraphRuntimeCodegen
       }
       target = targets_[call_dev_type];
     }
+    return target;
+  }
+
+  std::vector<GraphNodeRef> VisitExpr_(const CallNode* op) override {
+    Expr expr = GetRef<Expr>(op);
+    Function func;
+    if (op->op.as<OpNode>()) {
+      LOG(FATAL) << "Operators should be transformed away; try applying"
+                 << "the fuse_ops transformation to the expression.";
+    } else if (op->op.as<GlobalVarNode>()) {
+      LOG(FATAL) << "Not implemented";
+    } else if (op->op.as<FunctionNode>()) {
+      func = GetRef<Function>(op->op.as<FunctionNode>());
+    } else {
+      LOG(FATAL) << "TVM runtime does not support calls to " << op->op->type_key();
+    }
+    if (!func->IsPrimitive()) {
+      LOG(FATAL) << "TVM only support calls to primitive functions "
+                 << "(i.e functions composed of fusable operator invocations)";
+    }
+
+    CHECK_GE(storage_device_map_.count(expr), 0);
+    auto pf0 = GetPackedFunc("relay.backend._make_CCacheKey");
+    auto pf1 = GetPackedFunc("relay.backend._CompileEngineLower");
+    Target target = GetTarget(expr);
     CCacheKey key = (*pf0)(func, target);
     CachedFunc lowerd_func = (*pf1)(compile_engine_, key);
     if (!lowered_funcs_.count(target->str())) {
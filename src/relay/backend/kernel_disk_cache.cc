@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file relay/backend/kernel_disk_cache.cc
+ * \brief Persistent cache of compiled kernels.
+ */
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include "kernel_disk_cache.h"
+#include "../../runtime/file_util.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace tvm {
+namespace relay {
+
+namespace {
+
+// Create the directory and its parents, existing ones are left alone.
+// Errors surface when the entry is written.
+void MakeDirs(const std::string& dir) {
+  for (size_t pos = 1; pos <= dir.length(); ++pos) {
+    if (pos != dir.length() && dir[pos] != '/') continue;
+    std::string path = dir.substr(0, pos);
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+  }
+}
+
+std::string TempSuffix() {
+  std::ostringstream os;
+  os << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id())
+     << std::chrono::steady_clock::now().time_since_epoch().count();
+  return os.str();
+}
+
+void Commit(const std::string& from, const std::string& to) {
+  if (std::rename(from.c_str(), to.c_str()) != 0) {
+    // Another build may have committed the same entry first.
+    runtime::RemoveFile(from);
+  }
+}
+
+}  // namespace
+
+KernelDiskCache::KernelDiskCache(std::string dir) : dir_(std::move(dir)) {}
+
+bool KernelDiskCache::Load(const std::string& key,
+                           runtime::Module* mod,
+                           std::string* func_name) const {
+  std::string prefix = EntryPrefix(key);
+  std::ifstream fs(prefix + ".key", std::ios::in | std::ios::binary);
+  if (fs.fail()) return false;
+  std::string name;
+  std::getline(fs, name);
+  std::string stored((std::istreambuf_iterator<char>(fs)),
+                     std::istreambuf_iterator<char>());
+  if (stored != key) return false;
+  try {
+    *mod = runtime::Module::LoadFromFile(prefix + ".bc");
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Cannot load cached module " << prefix << ".bc: " << e.what();
+    return false;
+  }
+  if (func_name != nullptr) *func_name = name;
+  return true;
+}
+
+void KernelDiskCache::Save(const std::string& key,
+                           runtime::Module mod,
+                           const std::string& func_name) const {
+  if (std::string(mod->type_key()) != "llvm" || !mod->imports().empty()) return;
+  MakeDirs(dir_);
+  std::string prefix = EntryPrefix(key);
+  std::string suffix = TempSuffix();
+  try {
+    mod->SaveToFile(prefix + ".bc" + suffix, "bc");
+    runtime::SaveBinaryToFile(prefix + ".key" + suffix, func_name + "\n" + key);
+  } catch (const dmlc::Error& e) {
+    LOG(WARNING) << "Cannot save module to " << dir_ << ": " << e.what();
+    runtime::RemoveFile(prefix + ".bc" + suffix);
+    return;
+  }
+  Commit(prefix + ".bc" + suffix, prefix + ".bc");
+  Commit(prefix + ".key" + suffix, prefix + ".key");
+}
+
+void KernelDiskCache::PrintLoweredFunc(const LoweredFunc& f, std::ostream& os) {
+  os << "func " << f->name << ' ' << f->func_type << ' '
+     << f->is_packed_func << ' ' << f->is_restricted << '\n';
+  for (const tvm::Var& arg : f->args) {
+    os << arg << ':' << arg.type() << ' ';
+  }
+  os << '\n' << f->thread_axis << '\n' << f->handle_data_type << '\n' << f->body;
+}
+
+std::string KernelDiskCache::MaskNames(const std::string& text,
+                                       const std::vector<std::string>& names) {
+  std::unordered_map<std::string, size_t> index;
+  size_t max_len = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    index.emplace(names[i], i);
+    max_len = std::max(max_len, names[i].length());
+  }
+  auto is_ident = [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  };
+  std::string masked;
+  size_t pos = 0;
+  while (pos < text.length()) {
+    size_t end = pos;
+    while (end < text.length() && is_ident(text[end])) ++end;
+    if (end == pos) {
+      masked.push_back(text[pos++]);
+      continue;
+    }
+    // the names are prefixes of the identifiers using them,
+    // e.g. the compute scope of f is f_compute_.
+    for (size_t len = std::min(end - pos, max_len); len != 0; --len) {
+      auto it = index.find(text.substr(pos, len));
+      if (it != index.end()) {
+        masked.append("{func_").append(std::to_string(it->second)).append("}");
+        pos += len;
+        break;
+      }
+    }
+    masked.append(text, pos, end - pos);
+    pos = end;
+  }
+  return masked;
+}
+
+std::string KernelDiskCache::EntryPrefix(const std::string& key) const {
+  // 64 bit FNV-1a, which unlike std::hash is stable across builds.
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : key) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+  }
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));  // NOLINT(*)
+  return dir_ + "/" + name;
+}
+
+// The process wide cache and its lock.
+static std::mutex global_mutex;
+static std::shared_ptr<KernelDiskCache>* GlobalCache() {
+  // intentionally allocate raw pointer to avoid
+  // free during destruction.
+  static std::shared_ptr<KernelDiskCache>* inst = []() {
+    auto* cache = new std::shared_ptr<KernelDiskCache>();
+    if (const char* dir = getenv("TVM_KERNEL_CACHE_DIR")) {
+      if (*dir != '\0') *cache = std::make_shared<KernelDiskCache>(dir);
+    }
+    return cache;
+  }();
+  return inst;
+}
+
+std::shared_ptr<KernelDiskCache> KernelDiskCache::Global() {
+  std::lock_guard<std::mutex> lock(global_mutex);
+  return *GlobalCache();
+}
+
+void KernelDiskCache::SetGlobal(const std::string& dir) {
+  std::lock_guard<std::mutex> lock(global_mutex);
+  if (dir.empty()) {
+    GlobalCache()->reset();
+  } else {
+    *GlobalCache() = std::make_shared<KernelDiskCache>(dir);
+  }
+}
+
+}  // namespace relay
+}  // namespace tvm
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file relay/backend/kernel_disk_cache.h
+ * \brief Persistent cache of compiled kernels shared by the
+ *  compile engine and relay.build.
+ */
+#ifndef TVM_RELAY_BACKEND_KERNEL_DISK_CACHE_H_
+#define TVM_RELAY_BACKEND_KERNEL_DISK_CACHE_H_
+
+#include <tvm/lowered_func.h>
+#include <tvm/runtime/module.h>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace relay {
+
+/*!
+ * \brief Persistent, content-addressed store of compiled modules.
+ *
+ *  Every entry is the LLVM bitcode of a module named after the hash of its
+ *  key, along with a key file holding the function names and
+ *  the full key, the latter to rule out hash collisions. The bitcode is
+ *  written in process, storing an entry neither links nor forks a compiler.
+ *  Both files are written under temporary names and renamed into place,
+ *  the key file last, so concurrent builds never observe partial entries.
+ *
+ *  Only self-contained llvm modules are stored, modules of other targets
+ *  or with imported device modules are always rebuilt.
+ */
+class KernelDiskCache {
+ public:
+  explicit KernelDiskCache(std::string dir);
+  /*!
+   * \brief Look up a module.
+   * \param key The content key of the module.
+   * \param mod The loaded module.
+   * \param func_name The function names stored with the module.
+   * \return Whether the module was found.
+   */
+  bool Load(const std::string& key,
+            runtime::Module* mod,
+            std::string* func_name = nullptr) const;
+  /*!
+   * \brief Store a module, failures only produce a warning.
+   * \param key The content key of the module.
+   * \param mod The module.
+   * \param func_name The function names to store with the module.
+   */
+  void Save(const std::string& key,
+            runtime::Module mod,
+            const std::string& func_name = "") const;
+  /*!
+   * \brief Print everything about a lowered function that affects the
+   *  generated code, for use in keys.
+   * \param f The function.
+   * \param os The output stream.
+   */
+  static void PrintLoweredFunc(const LoweredFunc& f, std::ostream& os);
+  /*!
+   * \brief Replace the function names in a key by placeholders, so that the
+   *  key does not depend on the unique names given out by the process.
+   *
+   *  An identifier starting with names[i] has that prefix replaced by
+   *  "{func_i}", the longest matching name wins.
+   * \param text The key.
+   * \param names The function names.
+   * \return The masked key.
+   */
+  static std::string MaskNames(const std::string& text,
+                               const std::vector<std::string>& names);
+  /*! \return The process wide cache, nullptr when it is disabled. */
+  static std::shared_ptr<KernelDiskCache> Global();
+  /*!
+   * \brief Set the directory of the process wide cache.
+   *  It defaults to TVM_KERNEL_CACHE_DIR.
+   * \param dir The directory, empty to disable the cache.
+   */
+  static void SetGlobal(const std::string& dir);
+
+ private:
+  std::string EntryPrefix(const std::string& key) const;
+
+  std::string dir_;
+};
+
+}  // namespace relay
+}  // namespace tvm
+#endif  // TVM_RELAY_BACKEND_KERNEL_DISK_CACHE_H_
@@ -26,7 +26,9 @@
 #include "param_dict.h"
 
 #include <dmlc/memory_io.h>
+#include <tvm/runtime/device_api.h>
 
+#include <fstream>
 #include <string>
 #include <vector>
 #include <utility>
@@ -69,6 +71,74 @@ TVM_REGISTER_GLOBAL("tvm.relay._save_param_dict")
     *rv = arr;
   });
 
+/*
+ * The aligned layout stores a table of dtypes, shapes, offsets and sizes
+ * ahead of the data, which starts on a page boundary with every array
+ * aligned to kAllocAlignment. Offsets are relative to the data section,
+ * so that a loader can point the arrays straight into a mapping.
+ */
+TVM_REGISTER_GLOBAL("tvm.relay._save_param_dict_to_file")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+    CHECK_EQ(args.size() % 2, 1);
+    std::string file_name = args[0];
+    // `args` is in the form "file_name, key, value, key, value, ..."
+    size_t num_params = args.size() / 2;
+    std::vector<std::string> names;
+    std::vector<NDArray> arrays;
+    DLContext cpu_ctx;
+    cpu_ctx.device_type = kDLCPU;
+    cpu_ctx.device_id = 0;
+    for (size_t i = 1; i < num_params * 2; i += 2) {
+      names.emplace_back(args[i].operator std::string());
+      NDArray array = args[i + 1];
+      if (array->ctx.device_type != kDLCPU || array->strides != nullptr) {
+        NDArray copy = NDArray::Empty(
+            std::vector<int64_t>(array->shape, array->shape + array->ndim),
+            array->dtype, cpu_ctx);
+        copy.CopyFrom(array);
+        array = copy;
+      }
+      arrays.push_back(array);
+    }
+
+    std::string bytes;
+    dmlc::MemoryStringStream strm(&bytes);
+    dmlc::Stream* fo = &strm;
+    uint64_t header = kTVMNDArrayListAlignedMagic, alignment = kTVMNDArrayListDataAlign;
+    fo->Write(header);
+    fo->Write(alignment);
+    fo->Write(names);
+    uint64_t sz = static_cast<uint64_t>(arrays.size());
+    fo->Write(sz);
+    std::vector<uint64_t> offsets;
+    uint64_t offset = 0;
+    for (const NDArray& array : arrays) {
+      uint64_t nbytes = GetDataSize(*array.operator->());
+      offset = (offset + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment;
+      offsets.push_back(offset);
+      fo->Write(array->dtype);
+      fo->Write(std::vector<int64_t>(array->shape, array->shape + array->ndim));
+      fo->Write(offset);
+      fo->Write(nbytes);
+      offset += nbytes;
+    }
+
+    std::ofstream fs(file_name, std::ios::out | std::ios::binary);
+    CHECK(!fs.fail()) << "Cannot open " << file_name;
+    fs.write(bytes.data(), bytes.size());
+    size_t data_start = (bytes.size() + alignment - 1) / alignment * alignment;
+    std::string padding(alignment, '\0');
+    fs.write(padding.data(), data_start - bytes.size());
+    size_t pos = 0;
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      fs.write(padding.data(), offsets[i] - pos);
+      size_t nbytes = GetDataSize(*arrays[i].operator->());
+      fs.write(static_cast<const char*>(arrays[i]->data) + arrays[i]->byte_offset, nbytes);
+      pos = offsets[i] + nbytes;
+    }
+    CHECK(!fs.fail()) << "Failed to write " << file_name;
+  });
+
 TVM_REGISTER_GLOBAL("tvm.relay._load_param_dict")
 .set_body([](TVMArgs args, TVMRetValue *rv) {
     std::string bytes = args[0];
@@ -37,6 +37,10 @@ namespace relay {
 
 /*! \brief Magic number for NDArray list file  */
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*! \brief Magic number for NDArray list file with aligned data */
+constexpr uint64_t kTVMNDArrayListAlignedMagic = 0xF7E58D4F05049CB8;
+/*! \brief Alignment of the data section of an aligned NDArray list file */
+constexpr uint64_t kTVMNDArrayListDataAlign = 4096;
 
 /*!
  * \brief Wrapper node for naming `NDArray`s.
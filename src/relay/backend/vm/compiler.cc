@@ -30,6 +30,7 @@
 #include <tvm/relay/transform.h>
 #include <tvm/runtime/vm.h>
 #include <iostream>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -221,6 +222,7 @@ struct VMCompiler : ExprFunctor<void(const Expr& expr)> {
       case Opcode::If:
       case Opcode::Ret:
       case Opcode::Goto:
+      case Opcode::KillRegister:
         break;
     }
     instructions.push_back(instr);
@@ -514,7 +516,7 @@ struct VMCompiler : ExprFunctor<void(const Expr& expr)> {
 };
 
 void PopulatePackedFuncMap(const std::vector<LoweredFunc>& lowered_funcs,
-                           std::vector<PackedFunc>* packed_funcs) {
+                           VirtualMachine* vm) {
   runtime::Module mod;
   if (lowered_funcs.size() > 0) {
     // TODO(@jroesch): we need to read target from build config
@@ -526,11 +528,193 @@ void PopulatePackedFuncMap(const std::vector<LoweredFunc>& lowered_funcs,
     }
     CHECK(mod.operator->());
     for (auto lfunc : lowered_funcs) {
-      packed_funcs->push_back(mod.GetFunction(lfunc->name));
+      vm->packed_funcs.push_back(mod.GetFunction(lfunc->name));
+      vm->packed_func_names.push_back(lfunc->name);
     }
+    vm->lib = mod;
   }
 }
 
+/*! \brief The registers an instruction reads and writes. */
+struct RegisterUseDef {
+  std::vector<RegName> uses;
+  std::vector<RegName> defs;
+};
+
+RegisterUseDef GetUseDef(const Instruction& instr) {
+  RegisterUseDef ud;
+  switch (instr.op) {
+    case Opcode::Move:
+      ud.uses.push_back(instr.from);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::Ret:
+      ud.uses.push_back(instr.result);
+      break;
+    case Opcode::Invoke:
+      ud.uses.assign(instr.invoke_args_registers,
+                     instr.invoke_args_registers + instr.num_args);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::InvokeClosure:
+      ud.uses.push_back(instr.closure);
+      ud.uses.insert(ud.uses.end(), instr.closure_args,
+                     instr.closure_args + instr.closure_args_num);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::InvokePacked:
+      // The output tensors are allocated beforehand, so they are read as well.
+      ud.uses.assign(instr.packed_args, instr.packed_args + instr.arity);
+      ud.defs.assign(instr.packed_args + instr.arity - instr.output_size,
+                     instr.packed_args + instr.arity);
+      break;
+    case Opcode::AllocTensor:
+      ud.uses.push_back(instr.shape_register);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::AllocDatatype:
+      ud.uses.assign(instr.datatype_fields, instr.datatype_fields + instr.num_fields);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::AllocClosure:
+      ud.uses.assign(instr.free_vars, instr.free_vars + instr.num_freevar);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::GetField:
+      ud.uses.push_back(instr.object);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::If:
+      ud.uses.push_back(instr.if_cond);
+      break;
+    case Opcode::Select:
+      ud.uses.push_back(instr.select_cond);
+      ud.uses.push_back(instr.select_op1);
+      ud.uses.push_back(instr.select_op2);
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::LoadConst:
+      ud.defs.push_back(instr.dst);
+      break;
+    case Opcode::Goto:
+    case Opcode::KillRegister:
+      break;
+  }
+  return ud;
+}
+
+/*!
+ * \brief Release registers as soon as their value is dead.
+ *
+ * Registers otherwise hold their object until the frame exits, so the peak
+ * memory of a function is the sum of all of its intermediates. This runs a
+ * backward liveness analysis over the function's control flow and inserts a
+ * KillRegister after the last use of each register, and on the edge of an
+ * If for registers only read by the other branch. Once dropped, a tensor's
+ * buffer returns to the allocator and is reused by later allocations, much
+ * like the storage sharing graph_plan_memory does for the graph runtime.
+ *
+ * \param instructions The function body, ending with its Ret.
+ * \param num_params The number of parameter registers.
+ * \return The instructions with kills inserted and jump offsets patched.
+ */
+std::vector<Instruction> InsertRegisterKills(const std::vector<Instruction>& instructions,
+                                             Index num_params) {
+  size_t n = instructions.size();
+  std::vector<RegisterUseDef> use_def;
+  std::vector<std::vector<size_t>> succs(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto& instr = instructions[i];
+    use_def.push_back(GetUseDef(instr));
+    if (instr.op == Opcode::If) {
+      succs[i].push_back(i + instr.true_offset);
+      succs[i].push_back(i + instr.false_offset);
+    } else if (instr.op == Opcode::Goto) {
+      succs[i].push_back(i + instr.pc_offset);
+    } else if (instr.op != Opcode::Ret) {
+      succs[i].push_back(i + 1);
+    }
+    for (size_t s : succs[i]) {
+      CHECK_LT(s, n) << "jump out of the function body at instruction " << i;
+    }
+  }
+
+  // Jumps only go forward, so a single backward sweep reaches the fixed point.
+  std::vector<std::set<RegName>> live_in(n), live_out(n);
+  for (size_t k = n; k-- > 0;) {
+    for (size_t s : succs[k]) {
+      live_out[k].insert(live_in[s].begin(), live_in[s].end());
+    }
+    live_in[k] = live_out[k];
+    for (RegName r : use_def[k].defs) live_in[k].erase(r);
+    for (RegName r : use_def[k].uses) live_in[k].insert(r);
+  }
+
+  // The first definition of each register, to skip registers an If sees as
+  // live only because the other branch has not written them yet.
+  std::unordered_map<RegName, size_t> first_def;
+  for (size_t i = n; i-- > 0;) {
+    for (RegName r : use_def[i].defs) first_def[r] = i;
+  }
+
+  // Kills placed ahead of an instruction (jump targets and the entry), and
+  // right after it.
+  std::vector<std::set<RegName>> pre_kills(n), post_kills(n);
+  for (Index p = 0; p < num_params && n != 0; ++p) {
+    if (!live_in[0].count(p)) pre_kills[0].insert(p);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    const auto& instr = instructions[i];
+    if (instr.op == Opcode::Ret) continue;
+    if (instr.op == Opcode::If) {
+      // Only killing registers dead at the target keeps this sound when the
+      // target is also reached from another path.
+      for (size_t s : succs[i]) {
+        for (RegName r : live_in[i]) {
+          auto it = first_def.find(r);
+          bool defined = r < num_params || (it != first_def.end() && it->second < i);
+          if (defined && !live_in[s].count(r)) pre_kills[s].insert(r);
+        }
+      }
+      continue;
+    }
+    std::set<RegName> touched(use_def[i].uses.begin(), use_def[i].uses.end());
+    touched.insert(use_def[i].defs.begin(), use_def[i].defs.end());
+    for (RegName r : touched) {
+      if (!live_out[i].count(r)) post_kills[i].insert(r);
+    }
+  }
+
+  // Lay out the new body, then patch the relative jumps so they land on the
+  // kills placed ahead of their target.
+  std::vector<size_t> start(n), pos(n);
+  size_t next = 0;
+  for (size_t i = 0; i < n; ++i) {
+    start[i] = next;
+    pos[i] = next + pre_kills[i].size();
+    next = pos[i] + 1 + post_kills[i].size();
+  }
+  std::vector<Instruction> result;
+  result.reserve(next);
+  for (size_t i = 0; i < n; ++i) {
+    for (RegName r : pre_kills[i]) {
+      result.push_back(Instruction::KillRegister(r));
+    }
+    Instruction instr = instructions[i];
+    if (instr.op == Opcode::If) {
+      instr.true_offset = start[i + instr.true_offset] - pos[i];
+      instr.false_offset = start[i + instr.false_offset] - pos[i];
+    } else if (instr.op == Opcode::Goto) {
+      instr.pc_offset = start[i + instr.pc_offset] - pos[i];
+    }
+    result.push_back(instr);
+    for (RegName r : post_kills[i]) {
+      result.push_back(Instruction::KillRegister(r));
+    }
+  }
+  return result;
+}
+
 VMFunction CompileFunc(VMCompilerContext* context, const GlobalVar& var, const Function& func) {
   DLOG(INFO) << "CompileFunc: " << var << std::endl << AsText(func, false) << std::endl;
   size_t params = func->params.size();
@@ -542,10 +726,12 @@ VMFunction CompileFunc(VMCompilerContext* context, const GlobalVar& var, const F
   // Would like to refactor this so we only check if closure once.
   if (IsClosure(func)) {
     auto inner_params = Downcast<Function>(func->body)->params.size();
-    return VMFunction(var->name_hint, params + inner_params, compiler.instructions,
+    auto instructions = InsertRegisterKills(compiler.instructions, params + inner_params);
+    return VMFunction(var->name_hint, params + inner_params, instructions,
                       compiler.registers_num);
   } else {
-    return VMFunction(var->name_hint, params, compiler.instructions, compiler.registers_num);
+    auto instructions = InsertRegisterKills(compiler.instructions, params);
+    return VMFunction(var->name_hint, params, instructions, compiler.registers_num);
   }
 }
 
@@ -621,7 +807,7 @@ VirtualMachine CompileModule(const Module& mod_ref) {
   }
 #endif  // USE_RELAY_DEBUG
 
-  PopulatePackedFuncMap(context.lowered_funcs, &vm.packed_funcs);
+  PopulatePackedFuncMap(context.lowered_funcs, &vm);
 
   for (auto gv : context.global_map) {
     vm.global_map_.insert({gv.first->name_hint, gv.second});
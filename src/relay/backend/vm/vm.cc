@@ -29,6 +29,8 @@
 #include <tvm/relay/module.h>
 #include <tvm/runtime/vm.h>
 #include <tvm/relay/pass.h>
+#include <sstream>
+#include <string>
 
 namespace tvm {
 namespace relay {
@@ -149,6 +151,26 @@ TVM_REGISTER_API("relay._vm._evaluate_vm").set_body([](TVMArgs args, TVMRetValue
   *ret = VMToValue(module, result);
 });
 
+TVM_REGISTER_API("relay._vm._save_vm").set_body([](TVMArgs args, TVMRetValue* ret) {
+  Module module = args[0];
+  std::string file_name = args[1];
+  VirtualMachine vm = CompileModule(module);
+  vm.Save(file_name);
+  if (vm.lib.operator->() != nullptr) {
+    *ret = vm.lib;
+  }
+});
+
+TVM_REGISTER_API("relay._vm._get_bytecode")
+.set_body_typed<std::string(Module)>([](Module module) {
+  VirtualMachine vm = CompileModule(module);
+  std::ostringstream os;
+  for (const auto& func : vm.functions) {
+    os << func;
+  }
+  return os.str();
+});
+
 }  // namespace vm
 }  // namespace relay
 }  // namespace tvm
@@ -158,7 +158,7 @@ Pass DeadCodeElimination() {
     [=](Function f, Module m, PassContext pc) {
     return Downcast<Function>(DeadCodeElimination(f));
   };
-  return CreateFunctionPass(pass_func, 1, "DeadCodeElimination", {});
+  return CreateFunctionPass(pass_func, 1, "DeadCodeElimination", {}, true);
 }
 
 TVM_REGISTER_API("relay._transform.DeadCodeElimination")
@@ -22,14 +22,28 @@
  * \file src/relay/pass/pass_manager.cc
  * \brief Relay pass manager implementation.
  */
+#include <dmlc/json.h>
 #include <dmlc/thread_local.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/transform.h>
 #include <tvm/runtime/device_api.h>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <stack>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../../common/parallel_for.h"
 
 namespace tvm {
 namespace relay {
@@ -77,6 +91,72 @@ PassContext PassContext::Current() {
   }
 }
 
+/*! \brief Count the distinct expression nodes of all functions in a module. */
+class ModuleNodeCounter : public ExprVisitor {
+ public:
+  int64_t Count(const Module& mod) {
+    for (const auto& it : mod->functions) {
+      this->VisitExpr(it.second);
+    }
+    return static_cast<int64_t>(visit_counter_.size());
+  }
+};
+
+/*! \brief Get the peak resident memory of the process in KB. */
+inline int64_t PeakMemoryKB() {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return static_cast<int64_t>(usage.ru_maxrss) / 1024;
+#else
+  return static_cast<int64_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+/*!
+ * \brief Measure one pass execution and append the result to the pass
+ *  context, if the context has instrumentation enabled.
+ */
+class PassProfileScope {
+ public:
+  PassProfileScope(const PassInfo& pass_info,
+                   const Module& mod,
+                   const PassContext& pass_ctx)
+      : pass_ctx_(pass_ctx) {
+    if (!pass_ctx_->instrument) return;
+    record_.name = pass_info->name;
+    record_.nodes_before = ModuleNodeCounter().Count(mod);
+    record_.peak_memory_kb = PeakMemoryKB();
+    start_ = std::chrono::steady_clock::now();
+  }
+  /*!
+   * \brief Finish the measurement.
+   * \param mod The module produced by the pass.
+   */
+  void Finish(const Module& mod) {
+    if (!pass_ctx_->instrument) return;
+    auto end = std::chrono::steady_clock::now();
+    record_.start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        start_.time_since_epoch()).count();
+    record_.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        end - start_).count();
+    record_.peak_memory_kb = PeakMemoryKB() - record_.peak_memory_kb;
+    record_.nodes_after = ModuleNodeCounter().Count(mod);
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    pass_ctx_->profile_records.push_back(record_);
+  }
+
+ private:
+  PassContext pass_ctx_;
+  PassProfileRecord record_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 PassContext PassContext::Create() {
   return PassContext(make_node<PassContextNode>());
 }
@@ -155,10 +235,22 @@ class FunctionPassNode : public PassNode {
    */
   runtime::TypedPackedFunc<Function(Function, Module, PassContext)> pass_func;
 
+  /*!
+   * \brief Whether `pass_func` can run on several functions concurrently.
+   *
+   * A thread-safe pass function only reads the module it is given, does not
+   * call back into the frontend (e.g. Python), and its result depends on
+   * nothing but the function, the module and the pass context. Such passes
+   * are run concurrently when PassContext::num_threads allows it; the
+   * results are still merged back into the module in the serial order.
+   */
+  bool thread_safe{false};
+
   FunctionPassNode() = default;
 
   void VisitAttrs(tvm::AttrVisitor* v) final {
     v->Visit("pass_info", &pass_info);
+    v->Visit("thread_safe", &thread_safe);
   }
 
   /*!
@@ -290,8 +382,10 @@ Module ModulePassNode::operator()(const Module& mod,
              << " with opt level: "
              << pass_info->opt_level;
   CHECK(mod.defined());
+  PassProfileScope profile(pass_info, mod, pass_ctx);
   Module updated_mod = pass_func(mod, pass_ctx);
   CHECK(updated_mod.defined());
+  profile.Finish(updated_mod);
   return updated_mod;
 }
 
@@ -313,20 +407,28 @@ Module FunctionPassNode::operator()(const Module& mod,
              << pass_info->name
              << " with opt level: "
              << pass_info->opt_level;
+  PassProfileScope profile(pass_info, mod, pass_ctx);
   Module updated_mod = mod;
   // Execute the pass function and return a new module.
   std::vector<std::pair<GlobalVar, Function> > updates;
   auto original = mod->functions;
   for (const auto& it : original) {
-    auto updated_func = SkipFunction(it.second)
-                            ? it.second
-                            : pass_func(it.second, updated_mod, pass_ctx);
-    updates.push_back({it.first, updated_func});
+    updates.push_back({it.first, it.second});
   }
+  int num_threads = thread_safe ? pass_ctx->num_threads : 1;
+  common::ParallelFor(updates.size(), num_threads, [&](size_t i) {
+      // Make the context current on worker threads as well.
+      With<PassContext> scope(pass_ctx);
+      Function func = updates[i].second;
+      if (!SkipFunction(func)) {
+        updates[i].second = pass_func(func, updated_mod, pass_ctx);
+      }
+    });
 
   for (const auto& pair : updates) {
     updated_mod->Add(pair.first, pair.second, true);
   }
+  profile.Finish(updated_mod);
   return updated_mod;
 }
 
@@ -405,6 +507,7 @@ Pass GetPass(const std::string& pass_name) {
 // ordering problem needs to be handled in the future.
 Module SequentialNode::operator()(const Module& module,
                                   const PassContext& pass_ctx) const {
+  PassProfileScope profile(pass_info, module, pass_ctx);
   Module mod = module;
   for (const Pass& pass : passes) {
     CHECK(pass.defined()) << "Found undefined pass for optimization.";
@@ -418,6 +521,7 @@ Module SequentialNode::operator()(const Module& module,
     }
     mod = pass(mod, pass_ctx);
   }
+  profile.Finish(mod);
   return mod;
 }
 
@@ -434,9 +538,13 @@ Pass CreateFunctionPass(
     const runtime::TypedPackedFunc<Function(Function, Module, PassContext)>& pass_func,
     int opt_level,
     const std::string& name,
-    const tvm::Array<tvm::Expr>& required) {
-  PassInfo pass_info = PassInfoNode::make(opt_level, name, required);
-  return FunctionPassNode::make(pass_func, pass_info);
+    const tvm::Array<tvm::Expr>& required,
+    bool thread_safe) {
+  auto n = make_node<FunctionPassNode>();
+  n->pass_func = pass_func;
+  n->pass_info = PassInfoNode::make(opt_level, name, required);
+  n->thread_safe = thread_safe;
+  return FunctionPass(n);
 }
 
 TVM_REGISTER_NODE_TYPE(PassInfoNode);
@@ -536,6 +644,12 @@ TVM_REGISTER_API("relay._transform.PassContext")
   pctx->fallback_device = fallback_device;
   pctx->required_pass = std::move(required);
   pctx->disabled_pass = std::move(disabled);
+  if (args.size() > 4) {
+    pctx->num_threads = args[4];
+  }
+  if (args.size() > 5) {
+    pctx->instrument = args[5];
+  }
   *ret = pctx;
 });
 
@@ -558,7 +672,117 @@ TVM_STATIC_IR_FUNCTOR_REGISTER(IRPrinter, vtable)
   for (const auto& it : node->disabled_pass) {
     p->stream << it << " ";
   }
-  p->stream << "]";
+  p->stream << "]\n";
+
+  p->stream << "\tnum threads: " << node->num_threads << "\n";
+  p->stream << "\tinstrument: " << node->instrument;
+});
+
+/*!
+ * \brief Summarize the profile records of a pass context as a table, one row
+ *  per pass name, ordered by total time.
+ * \param pass_ctx The pass context.
+ * \return The table.
+ */
+std::string PassProfileSummary(const PassContext& pass_ctx) {
+  struct Row {
+    std::string name;
+    int64_t calls{0};
+    int64_t duration_us{0};
+    int64_t node_delta{0};
+    int64_t max_nodes{0};
+    int64_t peak_memory_kb{0};
+  };
+  std::vector<Row> rows;
+  std::unordered_map<std::string, size_t> index;
+  int64_t begin = 0, end = 0;
+  for (const PassProfileRecord& r : pass_ctx->profile_records) {
+    if (rows.empty()) {
+      begin = r.start_us;
+      end = r.start_us + r.duration_us;
+    }
+    begin = std::min(begin, r.start_us);
+    end = std::max(end, r.start_us + r.duration_us);
+    auto it = index.find(r.name);
+    if (it == index.end()) {
+      it = index.emplace(r.name, rows.size()).first;
+      rows.emplace_back();
+      rows.back().name = r.name;
+    }
+    Row& row = rows[it->second];
+    row.calls += 1;
+    row.duration_us += r.duration_us;
+    row.node_delta += r.nodes_after - r.nodes_before;
+    row.max_nodes = std::max(row.max_nodes, std::max(r.nodes_before, r.nodes_after));
+    row.peak_memory_kb += r.peak_memory_kb;
+  }
+  std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+      return a.duration_us > b.duration_us;
+    });
+  double total_us = static_cast<double>(std::max<int64_t>(end - begin, 1));
+  std::ostringstream os;
+  os << std::left << std::setw(32) << "Pass" << std::right
+     << std::setw(8) << "Calls"
+     << std::setw(12) << "Time(ms)"
+     << std::setw(10) << "Time(%)"
+     << std::setw(14) << "Node delta"
+     << std::setw(12) << "Max nodes"
+     << std::setw(14) << "Peak mem(KB)" << "\n";
+  os << std::fixed;
+  for (const Row& row : rows) {
+    os << std::left << std::setw(32) << row.name << std::right
+       << std::setw(8) << row.calls
+       << std::setw(12) << std::setprecision(3) << row.duration_us / 1000.0
+       << std::setw(10) << std::setprecision(2) << row.duration_us * 100.0 / total_us
+       << std::setw(14) << row.node_delta
+       << std::setw(12) << row.max_nodes
+       << std::setw(14) << row.peak_memory_kb << "\n";
+  }
+  os << "Wall time: " << std::setprecision(3) << total_us / 1000.0 << " ms "
+     << "(nested passes are counted in their parents as well)\n";
+  return os.str();
+}
+
+/*!
+ * \brief Write the profile records of a pass context as a trace in the
+ *  Chrome trace event format, viewable in chrome://tracing.
+ * \param pass_ctx The pass context.
+ * \param path The file to write to.
+ */
+void PassProfileDumpTrace(const PassContext& pass_ctx, const std::string& path) {
+  std::ofstream fs(path);
+  CHECK(fs) << "Cannot open " << path << " to write the pass trace";
+  dmlc::JSONWriter writer(&fs);
+  writer.BeginArray();
+  for (const PassProfileRecord& r : pass_ctx->profile_records) {
+    std::map<std::string, int64_t> counters = {
+      {"nodes_before", r.nodes_before},
+      {"nodes_after", r.nodes_after},
+      {"peak_memory_kb", r.peak_memory_kb}};
+    writer.WriteArraySeperator();
+    writer.BeginObject(false);
+    writer.WriteObjectKeyValue("name", r.name);
+    writer.WriteObjectKeyValue("cat", std::string("relay.pass"));
+    writer.WriteObjectKeyValue("ph", std::string("X"));
+    writer.WriteObjectKeyValue("ts", r.start_us);
+    writer.WriteObjectKeyValue("dur", r.duration_us);
+    writer.WriteObjectKeyValue("pid", 0);
+    writer.WriteObjectKeyValue("tid", 0);
+    writer.WriteObjectKeyValue("args", counters);
+    writer.EndObject();
+  }
+  writer.EndArray();
+}
+
+TVM_REGISTER_API("relay._transform.PassProfileSummary")
+.set_body_typed(PassProfileSummary);
+
+TVM_REGISTER_API("relay._transform.PassProfileDumpTrace")
+.set_body_typed(PassProfileDumpTrace);
+
+TVM_REGISTER_API("relay._transform.PassProfileClear")
+.set_body_typed<void(PassContext)>([](PassContext pass_ctx) {
+  pass_ctx->profile_records.clear();
 });
 
 class PassContext::Internal {
@@ -114,7 +114,7 @@ Pass SimplifyInference() {
     return Downcast<Function>(SimplifyInference(f));
   };
   return CreateFunctionPass(pass_func, 0, "SimplifyInference",
-                            {ir::StringImm::make("InferType")});
+                            {ir::StringImm::make("InferType")}, true);
 }
 
 TVM_REGISTER_API("relay._transform.SimplifyInference")
@@ -86,7 +86,7 @@ Pass ToGraphNormalForm() {
     [=](Function f, Module m, PassContext pc) {
     return Downcast<Function>(ToGraphNormalForm(f));
   };
-  return CreateFunctionPass(pass_func, 1, "ToGraphNormalForm", {});
+  return CreateFunctionPass(pass_func, 1, "ToGraphNormalForm", {}, true);
 }
 
 TVM_REGISTER_API("relay._transform.ToGraphNormalForm")
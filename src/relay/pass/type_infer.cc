@@ -37,6 +37,16 @@
  *
  * If we can not infer a type or there are conflicting typing
  * constraints we will trigger an error.
+ *
+ * Inference is incremental: a call to a primitive operator that already
+ * carries a concrete checked_type_ keeps it without re-solving its type
+ * relation, as long as its argument types are known when the call is
+ * visited and still match the ones it was checked with (recorded in
+ * type_args). Passes typically rewrite a small part of the program between
+ * two inferences, so the unchanged calls that only depend on inputs and
+ * other unchanged calls are not solved again. Set the
+ * environment variable TVM_RELAY_INCREMENTAL_TYPE_INFER=0 to re-solve
+ * everything.
  */
 
 #include <tvm/relay/error.h>
@@ -44,6 +54,8 @@
 #include <tvm/relay/pattern_functor.h>
 #include <tvm/relay/pass.h>
 #include <tvm/relay/transform.h>
+#include <cstdlib>
+#include <cstring>
 #include "./pass_util.h"
 #include "type_solver.h"
 #include "../ir/type_functor.h"
@@ -109,6 +121,8 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
   explicit TypeInferencer(Module mod, GlobalVar current_func)
       : mod_(mod), current_func_(current_func),
         err_reporter(), solver_(current_func, &this->err_reporter) {
+    const char* val = getenv("TVM_RELAY_INCREMENTAL_TYPE_INFER");
+    incremental_ = val == nullptr || strcmp(val, "0") != 0;
   }
 
   // inference the type of expr.
@@ -132,6 +146,8 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
 
   // The solver used by the inferencer.
   TypeSolver solver_;
+  // whether to reuse the checked types of unchanged primitive calls
+  bool incremental_{true};
   // relation function
   TypeRelationFn tuple_getitem_rel_;
   TypeRelationFn make_tuple_rel_;
@@ -329,6 +345,53 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
     return this->Unify(checked_true, checked_false, GetRef<If>(ite));
   }
 
+  // Whether the operator type is a single relation over its
+  // arguments and result, the style defined in src/relay/op/*.
+  static const TypeRelationNode* PrimitiveRelation(const FuncTypeNode* op,
+                                                   size_t num_args) {
+    if (op->type_params.size() != num_args + 1) return nullptr;
+    if (op->type_constraints.size() != 1) return nullptr;
+    const TypeRelationNode* rel = op->type_constraints[0].as<TypeRelationNode>();
+    if (rel == nullptr) return nullptr;
+    // validate if the type parameter matches up
+    for (size_t i = 0; i < op->type_params.size(); ++i) {
+      if (!op->type_params[i].same_as(rel->args[i])) return nullptr;
+    }
+    return rel;
+  }
+
+  // Whether the type is fully known, i.e. made of tensor types only.
+  static bool IsConcrete(const Type& t) {
+    if (t.as<TensorTypeNode>()) return true;
+    if (const auto* tuple = t.as<TupleTypeNode>()) {
+      for (const Type& field : tuple->fields) {
+        if (!IsConcrete(field)) return false;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // Reuse the checked type of a primitive call if the call was already
+  // checked with the same argument types, return an undefined type otherwise.
+  Type ReuseCheckedType(const CallNode* call, const Array<Type>& arg_types) {
+    if (!call->checked_type_.defined() ||
+        call->type_args.size() != arg_types.size() ||
+        !IsConcrete(call->checked_type_)) {
+      return Type();
+    }
+    for (size_t i = 0; i < arg_types.size(); ++i) {
+      // Only argument types known without solving are compared, a call
+      // that consumes a rewritten expression is solved again.
+      const Type& t = arg_types[i];
+      if (!IsConcrete(t)) return Type();
+      if (!t.same_as(call->type_args[i]) && !AlphaEqual(t, call->type_args[i])) {
+        return Type();
+      }
+    }
+    return call->checked_type_;
+  }
+
   // This code is special-cased for primitive operators,
   // which are registered in the style defined in src/relay/op/*.
   //
@@ -337,14 +400,8 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
                      Array<Type> arg_types,
                      const Attrs& attrs,
                      const NodeRef& loc) {
-    if (op->type_params.size() != arg_types.size() + 1) return Type();
-    if (op->type_constraints.size() != 1) return Type();
-    const TypeRelationNode* rel = op->type_constraints[0].as<TypeRelationNode>();
+    const TypeRelationNode* rel = PrimitiveRelation(op, arg_types.size());
     if (rel == nullptr) return Type();
-    // validate if the type parameter matches up
-    for (size_t i = 0; i < op->type_params.size(); ++i) {
-      if (!op->type_params[i].same_as(rel->args[i])) return Type();
-    }
     Type rtype = IncompleteTypeNode::make(Kind::kType);
     arg_types.push_back(rtype);
     // we can do simple replacement here
@@ -488,6 +545,14 @@ class TypeInferencer : private ExprFunctor<Type(const Expr&)>,
     }
 
     if (const OpNode* opnode = call->op.as<OpNode>()) {
+      if (incremental_ &&
+          PrimitiveRelation(opnode->op_type.as<FuncTypeNode>(), arg_types.size())) {
+        Type rtype = ReuseCheckedType(call, arg_types);
+        if (rtype.defined()) {
+          AddTypeArgs(GetRef<Call>(call), call->type_args);
+          return rtype;
+        }
+      }
       Type rtype = PrimitiveCall(opnode->op_type.as<FuncTypeNode>(),
                                  arg_types,
                                  call->attrs,
@@ -25,16 +25,162 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/device_api.h>
+#include <tvm/runtime/threading_backend.h>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "workspace_pool.h"
 
 #ifdef __ANDROID__
 #include <android/api-level.h>
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TVM_CPU_HUGE_PAGES 1
+#else
+#define TVM_CPU_HUGE_PAGES 0
+#endif
+
 namespace tvm {
 namespace runtime {
+/*!
+ * \brief Prefer the NUMA node set for the calling thread for the pages of
+ *  an allocation. Untouched pages are placed when first touched, pages the
+ *  heap already touched are migrated.
+ */
+static void PlaceOnNumaNode(void* ptr, size_t nbytes) {
+  int node = threading::GetNumaNode();
+  if (node < 0) return;
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind)
+  // mbind works on whole pages, only the pages inside the allocation are
+  // bound so that neighbouring allocations keep their policy.
+  const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + page - 1) & ~(page - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + nbytes) & ~(page - 1);
+  if (end <= begin) return;
+  // MPOL_PREFERRED from numaif.h, falls back to other nodes when full.
+  const int kMpolPreferred = 1;
+  // MPOL_MF_MOVE from numaif.h. A policy only applies to future faults,
+  // memory reused from the heap must be moved to follow it.
+  const unsigned kMpolMfMove = 2;
+  const size_t kBitsPerWord = sizeof(unsigned long) * 8;  // NOLINT(*)
+  std::vector<unsigned long> nodemask(node / kBitsPerWord + 1, 0);  // NOLINT(*)
+  nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  // Failing to bind only costs locality, the default policy still applies.
+  syscall(SYS_mbind, begin, end - begin, kMpolPreferred, nodemask.data(),
+          nodemask.size() * kBitsPerWord + 1, kMpolMfMove);
+#endif
+}
+
+/*!
+ * \brief Backs large CPU allocations with 2MB pages to relieve the TLB.
+ *
+ *  Allocations of at least the threshold are mapped directly, 2MB aligned.
+ *  In transparent mode the mapping is marked MADV_HUGEPAGE, in hugetlb mode
+ *  it comes from the pages reserved for hugetlbfs, falling back to the
+ *  transparent mode when none are left. The mode defaults to
+ *  TVM_HUGE_PAGES (0 off, 1 transparent, 2 hugetlb), the threshold to
+ *  TVM_HUGE_PAGE_THRESHOLD bytes, and runtime.config_huge_pages changes them.
+ */
+class HugePageAllocator {
+ public:
+  enum Mode : int {
+    kOff = 0,
+    kTransparent = 1,
+    kHugetlb = 2
+  };
+  static constexpr size_t kHugePageSize = 2 << 20;
+
+  HugePageAllocator() {
+    const char* mode = getenv("TVM_HUGE_PAGES");
+    if (mode != nullptr) mode_ = atoi(mode);
+    const char* threshold = getenv("TVM_HUGE_PAGE_THRESHOLD");
+    if (threshold != nullptr) threshold_ = strtoull(threshold, nullptr, 10);
+  }
+
+  static HugePageAllocator* Global() {
+    static HugePageAllocator inst;
+    return &inst;
+  }
+
+  void Configure(int mode, size_t threshold) {
+    CHECK(mode >= kOff && mode <= kHugetlb) << "Invalid huge page mode " << mode;
+    mode_ = mode;
+    threshold_ = threshold;
+  }
+
+  /*! \return The allocation, or nullptr if it should not use huge pages. */
+  void* Alloc(size_t nbytes, size_t alignment) {
+#if TVM_CPU_HUGE_PAGES
+    int mode = mode_.load(std::memory_order_relaxed);
+    if (mode == kOff || nbytes < threshold_.load(std::memory_order_relaxed) ||
+        alignment > kHugePageSize) {
+      return nullptr;
+    }
+    size_t size = (nbytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (mode == kHugetlb) {
+      ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      // Over-map by one huge page and trim both ends to align the mapping.
+      void* raw = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) return nullptr;
+      uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+      uintptr_t aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+      if (aligned != begin) munmap(raw, aligned - begin);
+      size_t tail = begin + size + kHugePageSize - (aligned + size);
+      if (tail != 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+      ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+      madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    mapped_[ptr] = size;
+    return ptr;
+#else
+    return nullptr;
+#endif
+  }
+
+  /*! \return Whether ptr was allocated here, it is released if so. */
+  bool Free(void* ptr) {
+#if TVM_CPU_HUGE_PAGES
+    if (reinterpret_cast<uintptr_t>(ptr) % kHugePageSize != 0) return false;
+    size_t size;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = mapped_.find(ptr);
+      if (it == mapped_.end()) return false;
+      size = it->second;
+      mapped_.erase(it);
+    }
+    munmap(ptr, size);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+  std::atomic<int> mode_{kOff};
+  std::atomic<size_t> threshold_{16 << 20};
+  std::mutex mutex_;
+  /*! \brief The size of each mapping. */
+  std::unordered_map<void*, size_t> mapped_;
+};
+
 class CPUDeviceAPI final : public DeviceAPI {
  public:
   void SetDevice(TVMContext ctx) final {}
@@ -47,7 +193,11 @@ class CPUDeviceAPI final : public DeviceAPI {
                        size_t nbytes,
                        size_t alignment,
                        TVMType type_hint) final {
-    void* ptr;
+    void* ptr = HugePageAllocator::Global()->Alloc(nbytes, alignment);
+    if (ptr != nullptr) {
+      PlaceOnNumaNode(ptr, nbytes);
+      return ptr;
+    }
 #if _MSC_VER
     ptr = _aligned_malloc(nbytes, alignment);
     if (ptr == nullptr) throw std::bad_alloc();
@@ -59,10 +209,12 @@ class CPUDeviceAPI final : public DeviceAPI {
     int ret = posix_memalign(&ptr, alignment, nbytes);
     if (ret != 0) throw std::bad_alloc();
 #endif
+    PlaceOnNumaNode(ptr, nbytes);
     return ptr;
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    if (HugePageAllocator::Global()->Free(ptr)) return;
 #if _MSC_VER
     _aligned_free(ptr);
 #else
@@ -113,6 +265,15 @@ void CPUDeviceAPI::FreeWorkspace(TVMContext ctx, void* data) {
   dmlc::ThreadLocalStore<CPUWorkspacePool>::Get()->FreeWorkspace(ctx, data);
 }
 
+// Arguments: mode (0 off, 1 transparent, 2 hugetlb) and the threshold in bytes.
+TVM_REGISTER_GLOBAL("runtime.config_huge_pages")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int mode = args[0];
+    int64_t threshold = args.num_args > 1 ? args[1].operator int64_t() : 16 << 20;
+    CHECK_GE(threshold, 0);
+    HugePageAllocator::Global()->Configure(mode, static_cast<size_t>(threshold));
+  });
+
 TVM_REGISTER_GLOBAL("device_api.cpu")
 .set_body([](TVMArgs args, TVMRetValue* rv) {
     DeviceAPI* ptr = CPUDeviceAPI::Global().get();
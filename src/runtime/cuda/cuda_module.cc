@@ -93,6 +93,10 @@ class CUDAModuleNode : public runtime::ModuleNode {
     stream->Write(data_);
   }
 
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
+
   std::string GetSource(const std::string& format) final {
     if (format == fmt_) return data_;
     if (cuda_source_.length() != 0) {
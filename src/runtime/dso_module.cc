@@ -40,9 +40,8 @@ namespace runtime {
 // This is the default module TVM used for host-side AOT
 class DSOModuleNode final : public ModuleNode {
  public:
-  ~DSOModuleNode() {
-    if (lib_handle_) Unload();
-  }
+  // The library is unloaded once the module and all the imported
+  // modules that still reference its module blob are released.
 
   const char* type_key() const final {
     return "dso";
@@ -67,6 +66,7 @@ class DSOModuleNode final : public ModuleNode {
 
   void Init(const std::string& name) {
     Load(name);
+    lib_ref_ = std::shared_ptr<void>(lib_handle_, Unload);
     if (auto *ctx_addr =
         reinterpret_cast<void**>(GetSymbol(runtime::symbol::tvm_module_ctx))) {
       *ctx_addr = this;
@@ -79,11 +79,13 @@ class DSOModuleNode final : public ModuleNode {
         reinterpret_cast<const char*>(
             GetSymbol(runtime::symbol::tvm_dev_mblob));
     if (dev_mblob != nullptr) {
-      ImportModuleBlob(dev_mblob, &imports_);
+      ImportModuleBlob(dev_mblob, &imports_, lib_ref_);
     }
   }
 
  private:
+  // Shared ownership of the library handle.
+  std::shared_ptr<void> lib_ref_;
   // Platform dependent handling.
 #if defined(_WIN32)
   // library handle
@@ -100,8 +102,8 @@ class DSOModuleNode final : public ModuleNode {
     return reinterpret_cast<void*>(
         GetProcAddress(lib_handle_, (LPCSTR)name)); // NOLINT(*)
   }
-  void Unload() {
-    FreeLibrary(lib_handle_);
+  static void Unload(void* handle) {
+    FreeLibrary(static_cast<HMODULE>(handle));
   }
 #else
   // Library handle
@@ -116,8 +118,8 @@ class DSOModuleNode final : public ModuleNode {
   void* GetSymbol(const char* name) {
     return dlsym(lib_handle_, name);
   }
-  void Unload() {
-    dlclose(lib_handle_);
+  static void Unload(void* handle) {
+    dlclose(handle);
   }
 #endif
 };
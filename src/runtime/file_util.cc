@@ -24,11 +24,19 @@
 #include <dmlc/json.h>
 #include <dmlc/logging.h>
 #include <tvm/runtime/serializer.h>
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <unordered_map>
 #include "file_util.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace tvm {
 namespace runtime {
 
@@ -165,5 +173,71 @@ void RemoveFile(const std::string& file_name) {
   std::remove(file_name.c_str());
 }
 
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string& file_name) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+#ifndef _WIN32
+  int fd = open(file_name.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "Cannot open " << file_name;
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat " << file_name;
+  file->size_ = static_cast<size_t>(st.st_size);
+  if (file->size_ != 0) {
+    void* ptr = mmap(nullptr, file->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    CHECK(ptr != MAP_FAILED) << "Cannot mmap " << file_name;
+    file->data_ = static_cast<char*>(ptr);
+    file->mapped_ = true;
+  }
+  close(fd);
+#else
+  std::string data;
+  LoadBinaryFromFile(file_name, &data);
+  file->size_ = data.size();
+  // Keep the same alignment guarantee as a mapping.
+  file->data_ = static_cast<char*>(_aligned_malloc(std::max<size_t>(data.size(), 1), 4096));
+  std::copy(data.begin(), data.end(), file->data_);
+#endif
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (mapped_) munmap(data_, size_);
+#else
+  _aligned_free(data_);
+#endif
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+#ifndef _WIN32
+  if (!mapped_ || offset >= size_) return;
+  size = std::min(size, size_ - offset);
+  // madvise takes a page aligned start, and the mapping starts on a page.
+  size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t start = offset / page * page;
+  madvise(data_ + start, size + (offset - start), MADV_WILLNEED);
+#endif
+}
+
+NDArray MappedNDArray(const std::shared_ptr<MappedFile>& file,
+                      size_t offset,
+                      std::vector<int64_t> shape,
+                      DLDataType dtype) {
+  DLContext ctx;
+  ctx.device_type = kDLCPU;
+  ctx.device_id = 0;
+  NDArray::Container* container =
+      new NDArray::Container(file->data() + offset, std::move(shape), dtype, ctx);
+  container->manager_ctx = new std::shared_ptr<MappedFile>(file);
+  container->deleter = [](NDArray::Container* self) {
+    delete static_cast<std::shared_ptr<MappedFile>*>(self->manager_ctx);
+    delete self;
+  };
+  NDArray ret(container);
+  CHECK_LE(offset + GetDataSize(*ret.operator->()), file->size())
+      << "array exceeds the mapped file";
+  return ret;
+}
+
 }  // namespace runtime
 }  // namespace tvm
@@ -25,8 +25,11 @@
 #ifndef TVM_RUNTIME_FILE_UTIL_H_
 #define TVM_RUNTIME_FILE_UTIL_H_
 
+#include <tvm/runtime/ndarray.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "meta_data.h"
 
 namespace tvm {
@@ -97,6 +100,58 @@ void LoadMetaDataFromFile(
  * \param file_name The file name.
  */
 void RemoveFile(const std::string& file_name);
+
+/*!
+ * \brief A read-only file mapped into memory.
+ *
+ *  The mapping is private and copy-on-write, so pages stay shared
+ *  between processes mapping the same file until one writes to them.
+ *  Platforms without mmap read the file into memory instead.
+ */
+class MappedFile {
+ public:
+  /*!
+   * \brief Map a file.
+   * \param file_name The file name.
+   * \return The mapping, unmapped once the last reference is dropped.
+   */
+  static std::shared_ptr<MappedFile> Open(const std::string& file_name);
+  ~MappedFile();
+  /*! \return The start of the mapping, aligned to a page. */
+  char* data() const { return data_; }
+  /*! \return The size of the file. */
+  size_t size() const { return size_; }
+  /*!
+   * \brief Ask the OS to start reading a region ahead of its first use.
+   * \param offset The start of the region.
+   * \param size The size of the region.
+   */
+  void Prefetch(size_t offset, size_t size) const;
+
+ private:
+  MappedFile() {}
+  /*! \brief The start of the mapping. */
+  char* data_{nullptr};
+  /*! \brief The file size. */
+  size_t size_{0};
+  /*! \brief Whether data_ was mapped, rather than read into memory. */
+  bool mapped_{false};
+};
+
+/*!
+ * \brief Create a CPU NDArray viewing a region of a mapped file.
+ *
+ *  The array keeps the mapping alive, and no data is copied.
+ * \param file The mapped file.
+ * \param offset The byte offset of the data, must be suitably aligned.
+ * \param shape The shape of the array.
+ * \param dtype The data type of the array.
+ * \return The array.
+ */
+NDArray MappedNDArray(const std::shared_ptr<MappedFile>& file,
+                      size_t offset,
+                      std::vector<int64_t> shape,
+                      DLDataType dtype);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTIL_H_
@@ -0,0 +1,510 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file batching_runtime.cc
+ * \brief Dynamic batching front-end on top of graph runtime and executor functions.
+ */
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Dynamic batching runtime.
+ *
+ *  Requests submitted from several threads are queued and coalesced along
+ *  the leading (batch) dimension, until either the largest batch bucket is
+ *  full or the oldest request waited for max_delay_us microseconds.
+ *  The batch is then dispatched to the smallest bucket that can host it,
+ *  and the outputs are scattered back to the requests.
+ *
+ *  A bucket executor is either a graph runtime module, which is driven
+ *  through its get_input/run/get_output functions, or a PackedFunc which
+ *  takes the batched inputs and returns the batched output, e.g. a function
+ *  wrapping a Relay VM invocation.
+ */
+class BatchingRuntime : public ModuleNode {
+ public:
+  ~BatchingRuntime() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_now_ = true;
+    }
+    queue_cv_.notify_all();
+    if (dispatcher_.joinable()) dispatcher_.join();
+  }
+
+  const char* type_key() const final {
+    return "BatchingRuntime";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const std::shared_ptr<ModuleNode>& sptr_to_self) final;
+
+  /*!
+   * \brief Initialize the runtime.
+   * \param input_names The names of the inputs of the graph.
+   * \param max_delay_us The maximum time a request waits for a batch to fill.
+   * \param batch_sizes The batch size of each bucket.
+   * \param executors The executor of each bucket, either a Module or a PackedFunc.
+   */
+  void Init(const std::vector<std::string>& input_names,
+            int64_t max_delay_us,
+            const std::vector<int64_t>& batch_sizes,
+            const std::vector<TVMRetValue>& executors) {
+    CHECK_EQ(batch_sizes.size(), executors.size());
+    CHECK(!batch_sizes.empty()) << "At least one batch bucket is required";
+    input_names_ = input_names;
+    max_delay_ = std::chrono::microseconds(max_delay_us);
+    for (size_t i = 0; i < batch_sizes.size(); ++i) {
+      Bucket bucket;
+      bucket.batch_size = batch_sizes[i];
+      CHECK_GT(bucket.batch_size, 0);
+      if (executors[i].type_code() == kModuleHandle) {
+        Module mod = executors[i];
+        bucket.fget_input = mod.GetFunction("get_input");
+        bucket.frun = mod.GetFunction("run");
+        bucket.fget_output = mod.GetFunction("get_output");
+        CHECK(bucket.fget_input != nullptr && bucket.frun != nullptr &&
+              bucket.fget_output != nullptr)
+            << "Bucket module must provide get_input, run and get_output";
+        int num_outputs = mod.GetFunction("get_num_outputs")();
+        bucket.num_outputs = num_outputs;
+        bucket.module = mod;
+      } else {
+        bucket.fexec = executors[i];
+        bucket.num_outputs = 1;
+      }
+      buckets_.push_back(bucket);
+    }
+    std::sort(buckets_.begin(), buckets_.end(), [](const Bucket& a, const Bucket& b) {
+        return a.batch_size < b.batch_size;
+      });
+    num_outputs_ = buckets_[0].num_outputs;
+    for (const Bucket& bucket : buckets_) {
+      CHECK_EQ(bucket.num_outputs, num_outputs_)
+          << "All buckets must have the same number of outputs";
+    }
+    // The rows of graph executors are known up front, those of function
+    // executors are taken from the first request.
+    for (Bucket& bucket : buckets_) {
+      if (bucket.fexec != nullptr) continue;
+      for (const std::string& name : input_names_) {
+        NDArray arr = bucket.fget_input(name);
+        input_rows_.push_back(RowSpec(arr.operator->()));
+      }
+      for (int i = 0; i < num_outputs_; ++i) {
+        NDArray arr = bucket.fget_output(i);
+        output_rows_.push_back(RowSpec(arr.operator->()));
+      }
+      break;
+    }
+    dispatcher_ = std::thread([this]() { this->DispatchLoop(); });
+  }
+
+  /*!
+   * \brief Run one request, block until its batch finishes.
+   * \param inputs The inputs, their leading dimension is the number of rows.
+   * \param outputs The outputs to be filled, with the same number of rows.
+   */
+  void Run(const std::vector<DLTensor*>& inputs,
+           const std::vector<DLTensor*>& outputs) {
+    CHECK_EQ(inputs.size(), input_names_.size());
+    CHECK_EQ(outputs.size(), static_cast<size_t>(num_outputs_));
+    Request req;
+    req.inputs = inputs;
+    req.outputs = outputs;
+    CHECK_GE(inputs[0]->ndim, 1) << "Batched inputs need a leading batch dimension";
+    req.rows = inputs[0]->shape[0];
+    CHECK_LE(req.rows, buckets_.back().batch_size)
+        << "Request larger than the largest batch bucket";
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (input_rows_.empty()) {
+      for (const DLTensor* t : inputs) {
+        input_rows_.push_back(RowSpec(t));
+      }
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      CheckRows(inputs[i], req.rows, input_rows_[i], "input", i);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (output_rows_.empty()) {
+        CheckRows(outputs[i], req.rows, RowSpec(outputs[i]), "output", i);
+      } else {
+        CheckRows(outputs[i], req.rows, output_rows_[i], "output", i);
+      }
+    }
+    req.enqueue_time = Clock::now();
+    queue_.push_back(&req);
+    max_queue_depth_ = std::max(max_queue_depth_, static_cast<int64_t>(queue_.size()));
+    queue_cv_.notify_all();
+    done_cv_.wait(lock, [&req]() { return req.done; });
+    if (!req.error.empty()) {
+      LOG(FATAL) << req.error;
+    }
+  }
+
+  /*! \return The statistics of the runtime in json format. */
+  std::string GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream os;
+    double fill_rate = total_capacity_ == 0 ? 0.0 :
+        static_cast<double>(total_rows_) / total_capacity_;
+    double avg_wait_us = num_requests_ == 0 ? 0.0 :
+        static_cast<double>(total_wait_us_) / num_requests_;
+    os << "{\"queue_depth\": " << queue_.size()
+       << ", \"max_queue_depth\": " << max_queue_depth_
+       << ", \"num_requests\": " << num_requests_
+       << ", \"num_batches\": " << num_batches_
+       << ", \"batch_fill_rate\": " << fill_rate
+       << ", \"avg_wait_us\": " << avg_wait_us
+       << ", \"max_wait_us\": " << max_wait_us_ << "}";
+    return os.str();
+  }
+
+  /*! \brief Reset the statistics counters. */
+  void ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_queue_depth_ = static_cast<int64_t>(queue_.size());
+    num_requests_ = 0;
+    num_batches_ = 0;
+    total_rows_ = 0;
+    total_capacity_ = 0;
+    total_wait_us_ = 0;
+    max_wait_us_ = 0;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  /*! \brief A pending request, owned by the submitting thread. */
+  struct Request {
+    std::vector<DLTensor*> inputs;
+    std::vector<DLTensor*> outputs;
+    int64_t rows;
+    Clock::time_point enqueue_time;
+    bool done{false};
+    std::string error;
+  };
+  /*! \brief The shape of a batched tensor without the batch dimension. */
+  struct RowSpec {
+    std::vector<int64_t> shape;
+    DLDataType dtype;
+    explicit RowSpec(const DLTensor* t)
+        : shape(t->shape + std::min(t->ndim, 1), t->shape + t->ndim),
+          dtype(t->dtype) {}
+  };
+  /*! \brief An executor compiled for a fixed batch size. */
+  struct Bucket {
+    int64_t batch_size;
+    int num_outputs;
+    Module module;
+    PackedFunc fget_input;
+    PackedFunc frun;
+    PackedFunc fget_output;
+    PackedFunc fexec;
+    // batched inputs of function executors, allocated on first use.
+    std::vector<NDArray> inputs;
+  };
+
+  void DispatchLoop() {
+    const int64_t max_rows = buckets_.back().batch_size;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queue_cv_.wait(lock, [this]() { return exit_now_ || !queue_.empty(); });
+      if (exit_now_) break;
+      // wait until the batch is full or the oldest request hits its deadline.
+      Clock::time_point deadline = queue_.front()->enqueue_time + max_delay_;
+      queue_cv_.wait_until(lock, deadline, [this, max_rows]() {
+          return exit_now_ || QueuedRows() >= max_rows;
+        });
+      if (exit_now_) break;
+      std::vector<Request*> batch;
+      int64_t rows = 0;
+      while (!queue_.empty() && rows + queue_.front()->rows <= max_rows) {
+        rows += queue_.front()->rows;
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+      Bucket* bucket = &buckets_.back();
+      for (Bucket& b : buckets_) {
+        if (b.batch_size >= rows) {
+          bucket = &b;
+          break;
+        }
+      }
+      Clock::time_point now = Clock::now();
+      for (Request* req : batch) {
+        int64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - req->enqueue_time).count();
+        total_wait_us_ += wait_us;
+        max_wait_us_ = std::max(max_wait_us_, wait_us);
+      }
+      num_requests_ += static_cast<int64_t>(batch.size());
+      num_batches_ += 1;
+      total_rows_ += rows;
+      total_capacity_ += bucket->batch_size;
+      lock.unlock();
+      // any failure is forwarded to the requests, the dispatcher keeps running.
+      std::string error;
+      try {
+        RunBatch(bucket, batch);
+      } catch (const std::exception& e) {
+        error = e.what();
+        if (error.empty()) error = "Exception while running a batch";
+      } catch (...) {
+        error = "Unknown exception while running a batch";
+      }
+      lock.lock();
+      for (Request* req : batch) {
+        req->error = error;
+        req->done = true;
+      }
+      done_cv_.notify_all();
+    }
+    // fail the remaining requests so that no caller blocks forever.
+    for (Request* req : queue_) {
+      req->error = "BatchingRuntime is destroyed";
+      req->done = true;
+    }
+    queue_.clear();
+    done_cv_.notify_all();
+  }
+
+  /*!
+   * \brief Check a request tensor against the rows of the batched tensor.
+   * \param t The request tensor.
+   * \param rows The number of rows of the request.
+   * \param spec The rows of the batched tensor.
+   * \param kind The kind of the tensor, for the error message.
+   * \param index The index of the tensor, for the error message.
+   */
+  static void CheckRows(const DLTensor* t, int64_t rows, const RowSpec& spec,
+                        const char* kind, size_t index) {
+    CHECK(t->ndim >= 1 && t->shape[0] == rows)
+        << "The leading dimension of " << kind << " " << index
+        << " must be the number of rows of the request, " << rows;
+    CHECK(static_cast<size_t>(t->ndim) == spec.shape.size() + 1 &&
+          std::equal(spec.shape.begin(), spec.shape.end(), t->shape + 1))
+        << "The row shape of " << kind << " " << index << " does not match the graph";
+    CHECK(t->dtype.code == spec.dtype.code && t->dtype.bits == spec.dtype.bits &&
+          t->dtype.lanes == spec.dtype.lanes)
+        << "The dtype of " << kind << " " << index << " does not match the graph";
+  }
+
+  int64_t QueuedRows() const {
+    int64_t rows = 0;
+    for (const Request* req : queue_) {
+      rows += req->rows;
+    }
+    return rows;
+  }
+
+  /*!
+   * \brief Copy rows between a request tensor and a slice of a batched tensor.
+   * \param req The request tensor.
+   * \param batched The batched tensor.
+   * \param row_offset The first row of the slice in the batched tensor.
+   * \param to_batched Whether to copy from the request to the batched tensor.
+   */
+  static void CopyRows(DLTensor* req, DLTensor* batched,
+                       int64_t row_offset, bool to_batched) {
+    CHECK_EQ(req->ndim, batched->ndim);
+    CHECK_GE(batched->ndim, 1);
+    CHECK(row_offset >= 0 && row_offset + req->shape[0] <= batched->shape[0])
+        << "Rows [" << row_offset << ", " << row_offset + req->shape[0]
+        << ") are out of the batched tensor of " << batched->shape[0] << " rows";
+    CHECK(req->dtype.code == batched->dtype.code && req->dtype.bits == batched->dtype.bits &&
+          req->dtype.lanes == batched->dtype.lanes) << "Request dtype mismatch";
+    size_t row_bytes = (batched->dtype.bits * batched->dtype.lanes + 7) / 8;
+    for (int i = 1; i < batched->ndim; ++i) {
+      CHECK_EQ(req->shape[i], batched->shape[i]) << "Request shape mismatch";
+      row_bytes *= static_cast<size_t>(batched->shape[i]);
+    }
+    DLTensor slice = *batched;
+    slice.shape = req->shape;
+    slice.byte_offset = batched->byte_offset + row_offset * row_bytes;
+    if (to_batched) {
+      CHECK_EQ(TVMArrayCopyFromTo(req, &slice, nullptr), 0) << TVMGetLastError();
+    } else {
+      CHECK_EQ(TVMArrayCopyFromTo(&slice, req, nullptr), 0) << TVMGetLastError();
+    }
+  }
+
+  void RunBatch(Bucket* bucket, const std::vector<Request*>& batch) {
+    // gather the inputs
+    std::vector<NDArray> inputs(input_names_.size());
+    for (size_t i = 0; i < input_names_.size(); ++i) {
+      if (bucket->fexec == nullptr) {
+        inputs[i] = bucket->fget_input(input_names_[i]);
+      } else {
+        if (bucket->inputs.size() != input_names_.size()) {
+          bucket->inputs.resize(input_names_.size());
+        }
+        if (!bucket->inputs[i].defined()) {
+          const DLTensor* proto = batch[0]->inputs[i];
+          std::vector<int64_t> shape(proto->shape, proto->shape + proto->ndim);
+          shape[0] = bucket->batch_size;
+          bucket->inputs[i] = NDArray::Empty(shape, proto->dtype, proto->ctx);
+        }
+        inputs[i] = bucket->inputs[i];
+      }
+      int64_t row = 0;
+      for (Request* req : batch) {
+        CopyRows(req->inputs[i], const_cast<DLTensor*>(inputs[i].operator->()), row, true);
+        row += req->rows;
+      }
+    }
+    // execute
+    std::vector<NDArray> outputs(num_outputs_);
+    if (bucket->fexec == nullptr) {
+      bucket->frun();
+      for (int i = 0; i < num_outputs_; ++i) {
+        outputs[i] = bucket->fget_output(i);
+      }
+    } else {
+      std::vector<TVMValue> values(inputs.size());
+      std::vector<int> codes(inputs.size());
+      TVMArgsSetter setter(values.data(), codes.data());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        setter(i, inputs[i]);
+      }
+      TVMRetValue rv;
+      bucket->fexec.CallPacked(
+          TVMArgs(values.data(), codes.data(), static_cast<int>(values.size())), &rv);
+      outputs[0] = rv;
+    }
+    // scatter the outputs
+    for (int i = 0; i < num_outputs_; ++i) {
+      int64_t row = 0;
+      for (Request* req : batch) {
+        CopyRows(req->outputs[i], const_cast<DLTensor*>(outputs[i].operator->()), row, false);
+        row += req->rows;
+      }
+    }
+  }
+
+  /*! \brief The names of the inputs. */
+  std::vector<std::string> input_names_;
+  /*! \brief The number of outputs. */
+  int num_outputs_{0};
+  /*! \brief The rows of each batched input, empty until known. */
+  std::vector<RowSpec> input_rows_;
+  /*! \brief The rows of each batched output, empty until known. */
+  std::vector<RowSpec> output_rows_;
+  /*! \brief The maximum time a request waits for the batch to fill. */
+  std::chrono::microseconds max_delay_{0};
+  /*! \brief The buckets, sorted by batch size. */
+  std::vector<Bucket> buckets_;
+  /*! \brief The queue of pending requests. */
+  std::deque<Request*> queue_;
+  /*! \brief The mutex protecting the queue and the statistics. */
+  std::mutex mutex_;
+  /*! \brief Notified when a request is queued or the runtime exits. */
+  std::condition_variable queue_cv_;
+  /*! \brief Notified when a batch finishes. */
+  std::condition_variable done_cv_;
+  /*! \brief The dispatcher thread. */
+  std::thread dispatcher_;
+  /*! \brief Whether the dispatcher should exit. */
+  bool exit_now_{false};
+  // statistics
+  int64_t max_queue_depth_{0};
+  int64_t num_requests_{0};
+  int64_t num_batches_{0};
+  int64_t total_rows_{0};
+  int64_t total_capacity_{0};
+  int64_t total_wait_us_{0};
+  int64_t max_wait_us_{0};
+};
+
+PackedFunc BatchingRuntime::GetFunction(
+    const std::string& name,
+    const std::shared_ptr<ModuleNode>& sptr_to_self) {
+  if (name == "run") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        size_t num_inputs = input_names_.size();
+        CHECK_EQ(static_cast<size_t>(args.num_args), num_inputs + num_outputs_)
+            << "run expects the inputs followed by the outputs";
+        std::vector<DLTensor*> inputs, outputs;
+        for (size_t i = 0; i < num_inputs; ++i) {
+          inputs.push_back(args[i]);
+        }
+        for (int i = 0; i < num_outputs_; ++i) {
+          outputs.push_back(args[num_inputs + i]);
+        }
+        this->Run(inputs, outputs);
+      });
+  } else if (name == "get_num_outputs") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = num_outputs_;
+      });
+  } else if (name == "get_stats") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->GetStats();
+      });
+  } else if (name == "reset_stats") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->ResetStats();
+      });
+  } else {
+    return PackedFunc();
+  }
+}
+
+// Arguments: num_inputs, input names, max_delay_us, then pairs of
+// (batch_size, executor) where executor is a Module or a PackedFunc.
+TVM_REGISTER_GLOBAL("tvm.batching_runtime.create")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int num_inputs = args[0];
+    CHECK_GE(args.num_args, num_inputs + 4);
+    std::vector<std::string> input_names;
+    for (int i = 0; i < num_inputs; ++i) {
+      input_names.push_back(args[1 + i].operator std::string());
+    }
+    int64_t max_delay_us = args[1 + num_inputs];
+    std::vector<int64_t> batch_sizes;
+    std::vector<TVMRetValue> executors;
+    for (int i = 2 + num_inputs; i + 1 < args.num_args; i += 2) {
+      batch_sizes.push_back(args[i].operator int64_t());
+      TVMRetValue executor;
+      executor = args[i + 1];
+      executors.push_back(executor);
+    }
+    std::shared_ptr<BatchingRuntime> exec = std::make_shared<BatchingRuntime>();
+    exec->Init(input_names, max_delay_us, batch_sizes, executors);
+    *rv = Module(exec);
+  });
+}  // namespace runtime
+}  // namespace tvm
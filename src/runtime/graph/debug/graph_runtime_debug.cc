@@ -28,6 +28,7 @@
 #include <chrono>
 #include <sstream>
 #include "../graph_runtime.h"
+#include "perf_counters.h"
 
 namespace tvm {
 namespace runtime {
@@ -106,6 +107,81 @@ class GraphRuntimeDebug : public GraphRuntime {
     return os.str();
   }
 
+  /*!
+   * \brief Run each operation and collect its hardware counters.
+   *
+   *  The counters are summed over all threads of the process, including the
+   *  thread pool workers. When counters are unavailable only the time is
+   *  reported.
+   * \param number The number of times to run each op, the results are averaged.
+   * \return JSON with, for each op, the time, the counters, the instructions
+   *  per cycle, the bandwidth implied by the last level cache misses and by
+   *  the bytes of its arguments.
+   */
+  std::string RunIndividualCounters(int number) {
+    // warmup run, which also starts the thread pool
+    GraphRuntime::Run();
+    PerfCounters counters;
+    bool available = counters.Open();
+    std::ostringstream os;
+    os << "{\"counters_available\": " << (available ? "true" : "false")
+       << ", \"ops\": [";
+    bool first = true;
+    for (size_t index = 0; index < op_execs_.size(); ++index) {
+      if (!op_execs_[index]) continue;
+      const TVMContext& ctx = data_entry_[entry_id(index, 0)]->ctx;
+      double time_us = 0;
+      std::vector<double> totals(PerfCounters::kNumEvents, 0);
+      for (int k = 0; k < number; ++k) {
+        std::vector<double> before = counters.Read();
+        auto op_tbegin = std::chrono::high_resolution_clock::now();
+        op_execs_[index]();
+        TVMSynchronize(ctx.device_type, ctx.device_id, nullptr);
+        auto op_tend = std::chrono::high_resolution_clock::now();
+        std::vector<double> after = counters.Read();
+        time_us += std::chrono::duration_cast<
+            std::chrono::duration<double> >(op_tend - op_tbegin).count() * 1e6;
+        for (int e = 0; e < PerfCounters::kNumEvents; ++e) {
+          totals[e] += after[e] - before[e];
+        }
+      }
+      time_us /= number;
+      size_t io_bytes = 0;
+      for (const auto& e : nodes_[index].inputs) {
+        io_bytes += GetDataSize(*data_entry_[entry_id(e)].operator->());
+      }
+      for (uint32_t i = 0; i < nodes_[index].param.num_outputs; ++i) {
+        io_bytes += GetDataSize(*data_entry_[entry_id(index, i)].operator->());
+      }
+      // bytes per us is MB/s, 1e-3 turns it into GB/s.
+      double to_gbps = time_us > 0 ? 1e-3 / time_us : 0;
+      os << (first ? "" : ", ") << "{\"name\": \"" << GetNodeName(index) << "\""
+         << ", \"time_us\": " << time_us
+         << ", \"io_bytes\": " << io_bytes
+         << ", \"io_bandwidth_gbps\": " << io_bytes * to_gbps;
+      first = false;
+      for (int e = 0; e < PerfCounters::kNumEvents; ++e) {
+        PerfCounters::Event event = static_cast<PerfCounters::Event>(e);
+        if (counters.available(event)) {
+          os << ", \"" << PerfCounters::Name(event) << "\": " << totals[e] / number;
+        }
+      }
+      if (counters.available(PerfCounters::kCycles) &&
+          counters.available(PerfCounters::kInstructions)) {
+        double cycles = totals[PerfCounters::kCycles];
+        os << ", \"ipc\": " << (cycles > 0 ? totals[PerfCounters::kInstructions] / cycles : 0);
+      }
+      if (counters.available(PerfCounters::kLLCMisses)) {
+        // every miss transfers one 64 byte cache line from memory.
+        os << ", \"llc_bandwidth_gbps\": "
+           << totals[PerfCounters::kLLCMisses] / number * 64 * to_gbps;
+      }
+      os << "}";
+    }
+    os << "]}";
+    return os.str();
+  }
+
   /*!
    * \brief Run each operation and get the output.
    * \param index The index of op which needs to be returned.
@@ -150,6 +226,7 @@ class GraphRuntimeDebug : public GraphRuntime {
  */
 void DebugGetNodeOutput(int index, DLTensor* data_out) {
   CHECK_LT(static_cast<size_t>(index), op_execs_.size());
+  this->SyncParams();
   uint32_t eid = index;
 
   for (size_t i = 0; i < op_execs_.size(); ++i) {
@@ -193,6 +270,12 @@ PackedFunc GraphRuntimeDebug::GetFunction(
       CHECK_GE(min_repeat_ms, 0);
       *rv = this->RunIndividual(number, repeat, min_repeat_ms);
     });
+  } else if (name == "run_individual_counters") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      int number = args[0];
+      CHECK_GT(number, 0);
+      *rv = this->RunIndividualCounters(number);
+    });
   } else {
     return GraphRuntime::GetFunction(name, sptr_to_self);
   }
@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file perf_counters.cc
+ */
+#include "perf_counters.h"
+
+#include <dmlc/logging.h>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tvm {
+namespace runtime {
+
+const char* PerfCounters::Name(Event event) {
+  switch (event) {
+    case kCycles: return "cycles";
+    case kInstructions: return "instructions";
+    case kLLCMisses: return "llc_misses";
+    case kBranchMisses: return "branch_misses";
+    case kFPOps: return "fp_ops";
+    default: return "unknown";
+  }
+}
+
+#if defined(__linux__)
+
+// Get the perf event attribute of an event, return false if the event has
+// no generic definition on this system.
+static bool GetEventAttr(PerfCounters::Event event, perf_event_attr* attr) {
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->type = PERF_TYPE_HARDWARE;
+  switch (event) {
+    case PerfCounters::kCycles:
+      attr->config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case PerfCounters::kInstructions:
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case PerfCounters::kLLCMisses:
+      attr->config = PERF_COUNT_HW_CACHE_MISSES; break;
+    case PerfCounters::kBranchMisses:
+      attr->config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    case PerfCounters::kFPOps: {
+      // Floating point operations have no generic event, the raw event code
+      // of the CPU, e.g. FP_ARITH_INST_RETIRED on Intel, is given in
+      // TVM_PERF_FP_OPS_EVENT as a hex number.
+      const char* val = getenv("TVM_PERF_FP_OPS_EVENT");
+      if (val == nullptr) return false;
+      attr->type = PERF_TYPE_RAW;
+      attr->config = strtoull(val, nullptr, 16);
+      break;
+    }
+    default:
+      return false;
+  }
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return true;
+}
+
+bool PerfCounters::Open() {
+  Close();
+  std::vector<int> tids;
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) return false;
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') tids.push_back(atoi(entry->d_name));
+  }
+  closedir(dir);
+  bool any = false;
+  for (int e = 0; e < kNumEvents; ++e) {
+    perf_event_attr attr;
+    if (!GetEventAttr(static_cast<Event>(e), &attr)) continue;
+    for (int tid : tids) {
+      int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+      if (fd >= 0) fds_[e].push_back(fd);
+    }
+    available_[e] = !fds_[e].empty();
+    any = any || available_[e];
+  }
+  return any;
+}
+
+void PerfCounters::Close() {
+  for (int e = 0; e < kNumEvents; ++e) {
+    for (int fd : fds_[e]) {
+      close(fd);
+    }
+    fds_[e].clear();
+    available_[e] = false;
+  }
+}
+
+std::vector<double> PerfCounters::Read() const {
+  std::vector<double> totals(kNumEvents, 0);
+  for (int e = 0; e < kNumEvents; ++e) {
+    for (int fd : fds_[e]) {
+      // value, time enabled, time running
+      uint64_t data[3];
+      if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+      if (data[2] == 0) continue;
+      totals[e] += static_cast<double>(data[0]) * data[1] / data[2];
+    }
+  }
+  return totals;
+}
+
+#else
+
+bool PerfCounters::Open() {
+  return false;
+}
+
+void PerfCounters::Close() {}
+
+std::vector<double> PerfCounters::Read() const {
+  return std::vector<double>(kNumEvents, 0);
+}
+
+#endif  // __linux__
+
+}  // namespace runtime
+}  // namespace tvm
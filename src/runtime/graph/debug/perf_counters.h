@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file perf_counters.h
+ * \brief Hardware performance counters of all threads of the process.
+ */
+#ifndef TVM_RUNTIME_GRAPH_DEBUG_PERF_COUNTERS_H_
+#define TVM_RUNTIME_GRAPH_DEBUG_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief A set of hardware counters, opened on every thread of the process.
+ *
+ *  The counters of a thread only count that thread, so the counters are
+ *  opened on all threads that exist when Open is called, which includes the
+ *  thread pool workers once the pool was started. Read returns the sums
+ *  over all threads, scaled up when the kernel multiplexed a counter.
+ *
+ *  Counters use perf_event_open and are only available on Linux, and only
+ *  when the kernel allows it (see perf_event_paranoid). The events that
+ *  cannot be opened are reported as unavailable.
+ */
+class PerfCounters {
+ public:
+  /*! \brief The counted events. */
+  enum Event {
+    kCycles = 0,
+    kInstructions,
+    kLLCMisses,
+    kBranchMisses,
+    kFPOps,
+    kNumEvents
+  };
+  PerfCounters() = default;
+  ~PerfCounters() {
+    Close();
+  }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  /*!
+   * \brief Open the counters on all threads of the process.
+   * \return Whether any event is available.
+   */
+  bool Open();
+  /*! \brief Close all counters. */
+  void Close();
+  /*!
+   * \brief Read the counters.
+   * \return The running totals of each event, zero for unavailable events.
+   */
+  std::vector<double> Read() const;
+  /*! \return Whether the event could be opened on any thread. */
+  bool available(Event event) const {
+    return available_[event];
+  }
+  /*! \return The name of the event. */
+  static const char* Name(Event event);
+
+ private:
+  /*! \brief The counter file descriptors of each event. */
+  std::vector<int> fds_[kNumEvents];
+  /*! \brief Whether each event is available. */
+  bool available_[kNumEvents] = {false};
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_DEBUG_PERF_COUNTERS_H_
@@ -23,6 +23,7 @@
  */
 #include "graph_runtime.h"
 
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
@@ -34,8 +35,13 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
+#include "../file_util.h"
+#include "../trace.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -43,9 +49,18 @@ namespace runtime {
  * \brief Run all the operations one by one.
  */
 void GraphRuntime::Run() {
+  trace::Scope trace_scope("graph", "run");
+  this->SyncParams();
+  if (inter_op_executor_) {
+    inter_op_executor_->Run(op_execs_, op_successors_, op_num_preds_, &op_names_);
+    return;
+  }
   // setup the array and requirements.
   for (size_t i = 0; i < op_execs_.size(); ++i) {
-    if (op_execs_[i]) op_execs_[i]();
+    if (op_execs_[i]) {
+      trace::Scope op_scope("op", nodes_[i].name);
+      op_execs_[i]();
+    }
   }
 }
 /*!
@@ -93,9 +108,19 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
  */
 void GraphRuntime::SetInput(int index, DLTensor* data_in) {
   CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  this->SyncParams();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   data_entry_[eid].CopyFrom(data_in);
 }
+/*!
+ * \brief set index-th input to the graph and share it with all execution contexts.
+ * \param index The input index.
+ * \param data_in The parameter data.
+ */
+void GraphRuntime::SetParam(int index, DLTensor* data_in) {
+  this->SetInput(index, data_in);
+  this->ShareParam(this->entry_id(input_nodes_[index], 0));
+}
 /*!
  * \brief set index-th input to the graph without copying the data.
  * \param index The input index.
@@ -137,8 +162,9 @@ int GraphRuntime::NumOutputs() const {
  *
  * \return NDArray corresponding to given input node index.
  */
-NDArray GraphRuntime::GetInput(int index) const {
+NDArray GraphRuntime::GetInput(int index) {
   CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  this->SyncParams();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   return data_entry_[eid];
 }
@@ -198,6 +224,7 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
   size_t size = static_cast<size_t>(sz);
   CHECK(size == names.size())
       << "Invalid parameters file format";
+  this->SyncParams();
   for (size_t i = 0; i < size; ++i) {
     int in_idx = GetInputIndex(names[i]);
     CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << names[i];
@@ -208,10 +235,177 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
     NDArray temp;
     temp.Load(strm);
     data_entry_[eid].CopyFrom(temp);
+    this->ShareParam(eid);
+  }
+}
+
+void GraphRuntime::LoadParamsFromFile(const std::string& file_name, bool prefetch) {
+  std::shared_ptr<MappedFile> file = MappedFile::Open(file_name);
+  dmlc::MemoryFixedSizeStream reader(file->data(), file->size());
+  dmlc::Stream* strm = &reader;
+  uint64_t header, alignment;
+  CHECK(strm->Read(&header))
+      << "Invalid parameters file format";
+  if (header == kTVMNDArrayListMagic) {
+    // The original layout is not aligned, copy the arrays out of the mapping.
+    reader.Seek(0);
+    this->LoadParams(strm);
+    return;
+  }
+  CHECK(header == kTVMNDArrayListAlignedMagic)
+      << "Invalid parameters file format";
+  CHECK(strm->Read(&alignment) && alignment != 0)
+      << "Invalid parameters file format";
+
+  std::vector<std::string> names;
+  CHECK(strm->Read(&names))
+      << "Invalid parameters file format";
+  uint64_t sz;
+  CHECK(strm->Read(&sz) && sz == names.size())
+      << "Invalid parameters file format";
+  std::vector<DLDataType> dtypes(sz);
+  std::vector<std::vector<int64_t> > shapes(sz);
+  std::vector<uint64_t> offsets(sz), nbytes(sz);
+  for (size_t i = 0; i < sz; ++i) {
+    CHECK(strm->Read(&dtypes[i]) && strm->Read(&shapes[i]) &&
+          strm->Read(&offsets[i]) && strm->Read(&nbytes[i]))
+        << "Invalid parameters file format";
+  }
+  size_t data_start = (reader.Tell() + alignment - 1) / alignment * alignment;
+  if (prefetch) file->Prefetch(data_start, file->size() - data_start);
+
+  this->SyncParams();
+  // Entries sharing their storage with another entry must keep it.
+  std::vector<uint32_t> storage_users(storage_pool_.size(), 0);
+  for (int sid : attrs_.storage_id) {
+    ++storage_users[sid];
+  }
+  for (size_t i = 0; i < sz; ++i) {
+    int in_idx = GetInputIndex(names[i]);
+    CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << names[i];
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    CHECK_LT(eid, data_entry_.size());
+
+    NDArray view = MappedNDArray(file, data_start + offsets[i], shapes[i], dtypes[i]);
+    CHECK_EQ(GetDataSize(*view.operator->()), nbytes[i])
+        << "Invalid parameters file format";
+    uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[eid]);
+    const DLTensor* entry = data_entry_[eid].operator->();
+    bool zero_copy =
+        entry->ctx.device_type == kDLCPU &&
+        storage_users[sid] == 1 &&
+        reinterpret_cast<uintptr_t>(view->data) % kAllocAlignment == 0 &&
+        entry->dtype.code == view->dtype.code &&
+        entry->dtype.bits == view->dtype.bits &&
+        entry->dtype.lanes == view->dtype.lanes &&
+        entry->ndim == view->ndim &&
+        std::equal(entry->shape, entry->shape + entry->ndim, view->shape);
+    if (zero_copy) {
+      storage_pool_[sid] = view;
+      data_entry_[eid] = view;
+      this->SetInputZeroCopy(in_idx, const_cast<DLTensor*>(view.operator->()));
+    } else {
+      data_entry_[eid].CopyFrom(view);
+    }
+    this->ShareParam(eid);
+  }
+}
+
+std::shared_ptr<GraphRuntime> GraphRuntime::CreateExecutionContext() const {
+  std::shared_ptr<GraphRuntime> exec = std::make_shared<GraphRuntime>();
+  exec->nodes_ = nodes_;
+  exec->input_nodes_ = input_nodes_;
+  exec->node_row_ptr_ = node_row_ptr_;
+  exec->outputs_ = outputs_;
+  exec->attrs_ = attrs_;
+  exec->module_ = module_;
+  exec->ctxs_ = ctxs_;
+  exec->params_ = params_;
+  exec->SetupStorage(true);
+  exec->SetupOpExecs();
+  return exec;
+}
+
+void GraphRuntime::ShareParam(uint32_t eid) {
+  uint32_t sid = static_cast<uint32_t>(attrs_.storage_id[eid]);
+  std::lock_guard<std::mutex> lock(params_->mutex);
+  NDArray& shared = params_->pool[sid];
+  if (!shared.same_as(storage_pool_[sid])) {
+    shared = storage_pool_[sid];
+    ++params_->version;
   }
 }
 
-void GraphRuntime::SetupStorage() {
+void GraphRuntime::SyncParams() {
+  if (params_->version.load() == params_version_) return;
+  std::vector<bool> rebound(storage_pool_.size(), false);
+  bool changed = false;
+  {
+    std::lock_guard<std::mutex> lock(params_->mutex);
+    params_version_ = params_->version.load();
+    for (const auto& kv : params_->pool) {
+      if (!storage_pool_[kv.first].same_as(kv.second)) {
+        storage_pool_[kv.first] = kv.second;
+        rebound[kv.first] = true;
+        changed = true;
+      }
+    }
+  }
+  if (!changed) return;
+  // Another context loaded a parameter into new storage, point the entries
+  // and the op arguments to it. This drops inputs set with zero copy.
+  for (size_t i = 0; i < data_entry_.size(); ++i) {
+    int storage_id = attrs_.storage_id[i];
+    if (!rebound[storage_id]) continue;
+    data_entry_[i] = storage_pool_[storage_id].CreateView(
+        attrs_.shape[i], String2TVMType(attrs_.dltype[i]));
+  }
+  this->SetupOpExecs();
+}
+
+void GraphRuntime::SetInterOpParallelism(int num_workers, int threads_per_op) {
+  inter_op_executor_.reset();
+  if (num_workers <= 1) return;
+  if (op_successors_.empty()) this->SetupOpDependencies();
+  inter_op_executor_.reset(new InterOpExecutor(num_workers, threads_per_op));
+}
+
+void GraphRuntime::SetupOpDependencies() {
+  op_successors_.assign(nodes_.size(), std::vector<uint32_t>());
+  op_num_preds_.assign(nodes_.size(), 0);
+  op_names_.clear();
+  for (const auto& node : nodes_) {
+    op_names_.push_back(node.name);
+  }
+  // The memory plan reuses storage assuming the ops run in order, so besides
+  // waiting for its inputs, an op waits for the earlier writer and readers of
+  // the storage it writes.
+  std::vector<int> last_writer(storage_pool_.size(), -1);
+  std::vector<std::vector<uint32_t> > readers(storage_pool_.size());
+  for (uint32_t nid = 0; nid < nodes_.size(); ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null") continue;
+    std::unordered_set<uint32_t> preds;
+    for (const auto& e : inode.inputs) {
+      if (nodes_[e.node_id].op_type != "null") preds.insert(e.node_id);
+      readers[attrs_.storage_id[this->entry_id(e)]].push_back(nid);
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      int sid = attrs_.storage_id[this->entry_id(nid, index)];
+      if (last_writer[sid] >= 0) preds.insert(static_cast<uint32_t>(last_writer[sid]));
+      preds.insert(readers[sid].begin(), readers[sid].end());
+      last_writer[sid] = static_cast<int>(nid);
+      readers[sid].clear();
+    }
+    preds.erase(nid);
+    for (uint32_t pred : preds) {
+      op_successors_[pred].push_back(nid);
+    }
+    op_num_preds_[nid] = static_cast<uint32_t>(preds.size());
+  }
+}
+
+void GraphRuntime::SetupStorage(bool share_params) {
   // Grab saved optimization plan from graph.
   std::vector<TVMType> vtype;
   for (const std::string& s_type : attrs_.dltype) {
@@ -250,8 +444,21 @@ void GraphRuntime::SetupStorage() {
     pool_entry[sid].device_type = device_type;
   }
 
+  std::unordered_map<uint32_t, NDArray> shared_params;
+  if (share_params) {
+    std::lock_guard<std::mutex> lock(params_->mutex);
+    shared_params = params_->pool;
+    params_version_ = params_->version.load();
+  }
+
   // Allocate the space.
-  for (const auto& pit : pool_entry) {
+  for (size_t sid = 0; sid < pool_entry.size(); ++sid) {
+    auto it = shared_params.find(static_cast<uint32_t>(sid));
+    if (it != shared_params.end()) {
+      storage_pool_.push_back(it->second);
+      continue;
+    }
+    const PoolEntry& pit = pool_entry[sid];
     std::vector<int64_t> shape;
     // This for loop is very fast since there are usually only a couple of
     // devices available on the same hardware.
@@ -376,6 +583,15 @@ PackedFunc GraphRuntime::GetFunction(
           this->SetInput(args[0], args[1]);
         }
       });
+  } else if (name == "set_param") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        if (args[0].type_code() == kStr) {
+          int in_idx = this->GetInputIndex(args[0]);
+          if (in_idx >= 0) this->SetParam(in_idx, args[1]);
+        } else {
+          this->SetParam(args[0], args[1]);
+        }
+      });
   } else if (name == "set_input_zero_copy") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       if (args[0].type_code() == kStr) {
@@ -416,6 +632,20 @@ PackedFunc GraphRuntime::GetFunction(
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         this->LoadParams(args[0].operator std::string());
       });
+  } else if (name == "load_params_from_file") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        bool prefetch = args.num_args > 1 && args[1].operator bool();
+        this->LoadParamsFromFile(args[0], prefetch);
+      });
+  } else if (name == "create_execution_context") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = Module(this->CreateExecutionContext());
+      });
+  } else if (name == "set_inter_op_parallelism") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int threads_per_op = args.num_args > 1 ? args[1].operator int() : 0;
+        this->SetInterOpParallelism(args[0], threads_per_op);
+      });
   } else {
     return PackedFunc();
   }
@@ -33,11 +33,17 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <string>
 
+#include "inter_op_executor.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -51,6 +57,8 @@ namespace runtime {
 
 /*! \brief Magic number for NDArray list file  */
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*! \brief Magic number for NDArray list file with aligned data */
+constexpr uint64_t kTVMNDArrayListAlignedMagic = 0xF7E58D4F05049CB8;
 
 /*! \brief operator attributes about tvm op */
 struct TVMOpParam {
@@ -72,6 +80,18 @@ namespace {
   };
 }
 
+/*!
+ * \brief Parameter storage shared by a graph runtime and its execution contexts.
+ */
+struct SharedParamStorage {
+  /*! \brief Protects pool. */
+  std::mutex mutex;
+  /*! \brief The storage pool entries that hold parameters, by storage id. */
+  std::unordered_map<uint32_t, NDArray> pool;
+  /*! \brief Bumped whenever an entry of pool is added or replaced. */
+  std::atomic<uint64_t> version{0};
+};
+
 /*!
  * \brief Tiny graph runtime.
  *
@@ -123,6 +143,15 @@ class GraphRuntime : public ModuleNode {
    * \param data_in The input data.
    */
   void SetInput(int index, DLTensor* data_in);
+  /*!
+   * \brief set index-th input to the graph and mark it as a parameter.
+   *
+   *  The input is then shared with all execution contexts of the graph,
+   *  like the parameters loaded with LoadParams.
+   * \param index The input index.
+   * \param data_in The parameter data.
+   */
+  void SetParam(int index, DLTensor* data_in);
   /*!
    * \brief set index-th input to the graph without copying the data
    * \param index The input index.
@@ -141,7 +170,7 @@ class GraphRuntime : public ModuleNode {
    *
    * \return NDArray corresponding to given input node index.
    */
-  NDArray GetInput(int index) const;
+  NDArray GetInput(int index);
   /*!
    * \brief Return NDArray for given output index.
    * \param index The output index.
@@ -165,6 +194,46 @@ class GraphRuntime : public ModuleNode {
    * \param param_blob A binary blob of parameter.
    */
   void LoadParams(const std::string& param_blob);
+  /*!
+   * \brief Load parameters from a file by memory mapping it.
+   *
+   *  For files written with the aligned layout, parameters that live on
+   *  the CPU point straight into the mapping instead of being copied, so
+   *  processes loading the same file share its pages. Other parameters,
+   *  and files in the original layout, are copied out of the mapping.
+   *  The parameters are visible to all execution contexts of the graph.
+   * \param file_name The parameter file.
+   * \param prefetch Whether to ask the OS to read the whole file ahead.
+   */
+  void LoadParamsFromFile(const std::string& file_name, bool prefetch);
+  /*!
+   * \brief Create a lightweight execution context of this graph.
+   *
+   *  The context shares the graph, the code module and the loaded parameters
+   *  with this runtime, and only owns the storage of the remaining entries.
+   *  Different contexts can run concurrently on different threads.
+   *  Parameters loaded or set with SetParam on any of them, before or after
+   *  the context is created, are visible to all, and SetInput on such a
+   *  parameter updates it for all. Other inputs are private to a context.
+   *  Parameters must not be updated while another context runs.
+   *
+   * \return The created execution context.
+   */
+  std::shared_ptr<GraphRuntime> CreateExecutionContext() const;
+  /*!
+   * \brief Run independent ops of the graph concurrently.
+   *
+   *  Run then dispatches each op as soon as the ops producing its inputs,
+   *  and the earlier ops using the memory it overwrites, finished. Every op
+   *  runs on a partition of the cores, of threads_per_op threads, and at
+   *  most num_workers ops run at the same time. Execution contexts created
+   *  from this runtime run their ops one by one until configured as well.
+   * \param num_workers The number of concurrent ops, 1 to run the ops one
+   *  by one again.
+   * \param threads_per_op The intra-op threads of each op, 0 to split the
+   *  cores evenly between the workers.
+   */
+  void SetInterOpParallelism(int num_workers, int threads_per_op);
  /*!
   * \brief Get total number of nodes.
   * \return Total number of nodes.
@@ -363,10 +432,27 @@ class GraphRuntime : public ModuleNode {
       }
       CHECK_EQ(bitmask, 1|2|4|8|16) << "invalid format";
   }
-  /*! \brief Setup the temporal storage */
-  void SetupStorage();
+  /*!
+   * \brief Setup the temporal storage
+   * \param share_params Whether to use the entries of params_ instead of
+   *  allocating the parameter storage.
+   */
+  void SetupStorage(bool share_params = false);
+  /*!
+   * \brief Record the storage of the entry eid as a parameter shared with
+   *  all execution contexts.
+   * \param eid The data entry id.
+   */
+  void ShareParam(uint32_t eid);
+  /*!
+   * \brief Bind the parameters added or replaced in params_ by another
+   *  execution context since the last call.
+   */
+  void SyncParams();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*! \brief Setup the dependencies between ops for inter-op parallel runs. */
+  void SetupOpDependencies();
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -404,12 +490,24 @@ class GraphRuntime : public ModuleNode {
   std::vector<TVMContext> ctxs_;
   /*! \brief Common storage pool for all devices. */
   std::vector<NDArray> storage_pool_;
+  /*! \brief The parameter storage shared with the execution contexts. */
+  std::shared_ptr<SharedParamStorage> params_{std::make_shared<SharedParamStorage>()};
+  /*! \brief The version of params_ bound to storage_pool_. */
+  uint64_t params_version_{0};
   /*! \brief Data entry of each node. */
   std::vector<NDArray> data_entry_;
   /*! \brief Operator on each node. */
   std::vector<std::function<void()> > op_execs_;
   /*! \brief Arg info of TVM ops */
   std::vector<std::shared_ptr<OpArgs> > op_args_;
+  /*! \brief The nodes that wait for each node in inter-op parallel runs. */
+  std::vector<std::vector<uint32_t> > op_successors_;
+  /*! \brief The number of nodes each node waits for in inter-op parallel runs. */
+  std::vector<uint32_t> op_num_preds_;
+  /*! \brief The name of each node, for tracing inter-op parallel runs. */
+  std::vector<std::string> op_names_;
+  /*! \brief The inter-op parallel executor, null when ops run one by one. */
+  std::unique_ptr<InterOpExecutor> inter_op_executor_;
 };
 
 std::vector<TVMContext> GetAllContext(const TVMArgs& args);
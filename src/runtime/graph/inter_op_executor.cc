@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file inter_op_executor.cc
+ */
+#include <dmlc/logging.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <algorithm>
+#include <exception>
+
+#include "inter_op_executor.h"
+#include "../trace.h"
+
+namespace tvm {
+namespace runtime {
+
+InterOpExecutor::InterOpExecutor(int num_workers, int threads_per_worker) {
+  CHECK_GE(num_workers, 1);
+  int max_concurrency = threading::MaxConcurrency();
+  if (threads_per_worker <= 0) {
+    threads_per_worker = std::max(max_concurrency / num_workers, 1);
+  }
+  threads_per_worker_ = threads_per_worker;
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this, i]() { this->WorkerLoop(i); });
+  }
+}
+
+InterOpExecutor::~InterOpExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_now_ = true;
+  }
+  ready_cv_.notify_all();
+  for (std::thread& t : workers_) {
+    t.join();
+  }
+}
+
+void InterOpExecutor::Run(const std::vector<std::function<void()> >& tasks,
+                          const std::vector<std::vector<uint32_t> >& successors,
+                          const std::vector<uint32_t>& num_preds,
+                          const std::vector<std::string>* names) {
+  CHECK_EQ(tasks.size(), successors.size());
+  CHECK_EQ(tasks.size(), num_preds.size());
+  if (tasks.empty()) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  tasks_ = &tasks;
+  names_ = names;
+  successors_ = &successors;
+  pending_preds_ = num_preds;
+  num_unfinished_ = tasks.size();
+  error_.clear();
+  for (uint32_t i = 0; i < tasks.size(); ++i) {
+    if (pending_preds_[i] == 0) ready_.push_back(i);
+  }
+  CHECK(!ready_.empty()) << "The task graph has a cycle";
+  ready_cv_.notify_all();
+  finish_cv_.wait(lock, [this]() { return num_unfinished_ == 0; });
+  tasks_ = nullptr;
+  names_ = nullptr;
+  successors_ = nullptr;
+  if (!error_.empty()) {
+    std::string error = error_;
+    lock.unlock();
+    LOG(FATAL) << error;
+  }
+}
+
+void InterOpExecutor::MarkFinished(uint32_t task) {
+  --num_unfinished_;
+  for (uint32_t succ : (*successors_)[task]) {
+    if (--pending_preds_[succ] == 0) ready_.push_back(succ);
+  }
+}
+
+void InterOpExecutor::WorkerLoop(int worker_id) {
+  // Create the thread pool of this thread with threads_per_worker threads,
+  // so that the workers do not oversubscribe the machine, and restrict it
+  // to its own cores.
+  const PackedFunc* fsize = Registry::Get("runtime.config_threadpool_size");
+  const PackedFunc* fconfig = Registry::Get("runtime.config_threadpool");
+  CHECK(fsize != nullptr && fconfig != nullptr);
+  (*fsize)(threads_per_worker_);
+  (*fconfig)(static_cast<int>(threading::ThreadGroup::kBig), threads_per_worker_,
+             worker_id * threads_per_worker_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    ready_cv_.wait(lock, [this]() { return exit_now_ || !ready_.empty(); });
+    if (exit_now_) break;
+    uint32_t task = ready_.front();
+    ready_.pop_front();
+    const std::function<void()>& ftask = (*tasks_)[task];
+    if (ftask && error_.empty()) {
+      lock.unlock();
+      std::string error;
+      try {
+        trace::Scope trace_scope("op", names_ != nullptr ? (*names_)[task].c_str() : "task");
+        ftask();
+      } catch (const std::exception& e) {
+        // Nothing may escape the worker, Run reports the error instead.
+        error = e.what();
+        if (error.empty()) error = "Exception in an inter-op task";
+      } catch (...) {
+        error = "Unknown exception in an inter-op task";
+      }
+      lock.lock();
+      if (!error.empty() && error_.empty()) error_ = error;
+    }
+    size_t num_ready = ready_.size();
+    MarkFinished(task);
+    if (ready_.size() > num_ready + 1) {
+      ready_cv_.notify_all();
+    } else if (ready_.size() > num_ready) {
+      ready_cv_.notify_one();
+    }
+    if (num_unfinished_ == 0) finish_cv_.notify_all();
+  }
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file inter_op_executor.h
+ * \brief Dependency driven executor running independent graph ops concurrently.
+ */
+#ifndef TVM_RUNTIME_GRAPH_INTER_OP_EXECUTOR_H_
+#define TVM_RUNTIME_GRAPH_INTER_OP_EXECUTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Executor of a task DAG on a fixed set of inter-op workers.
+ *
+ *  Each worker owns a partition of the cores: the intra-op thread pool of
+ *  the worker thread is created with threads_per_worker threads bound to
+ *  cores of its own, so that concurrent ops neither oversubscribe the
+ *  machine nor compete for the same cores. A task becomes ready once all
+ *  of its predecessors finished, ready tasks are picked in the order they
+ *  became ready.
+ */
+class InterOpExecutor {
+ public:
+  /*!
+   * \brief Start the workers.
+   * \param num_workers The number of ops that run at the same time.
+   * \param threads_per_worker The intra-op threads of each worker, 0 to
+   *  split the maximum concurrency of the machine evenly.
+   */
+  InterOpExecutor(int num_workers, int threads_per_worker);
+  ~InterOpExecutor();
+  /*! \return The number of workers. */
+  int num_workers() const {
+    return static_cast<int>(workers_.size());
+  }
+  /*! \return The intra-op threads of each worker. */
+  int threads_per_worker() const {
+    return threads_per_worker_;
+  }
+  /*!
+   * \brief Run all tasks, blocks until they finished.
+   *
+   *  Raises the error of the first failed task, no task is started after
+   *  a failure.
+   * \param tasks The tasks, an empty function stands for a no-op.
+   * \param successors The tasks that depend on each task.
+   * \param num_preds The number of tasks each task depends on.
+   * \param names The names of the tasks in the trace, optional.
+   */
+  void Run(const std::vector<std::function<void()> >& tasks,
+           const std::vector<std::vector<uint32_t> >& successors,
+           const std::vector<uint32_t>& num_preds,
+           const std::vector<std::string>* names = nullptr);
+
+ private:
+  void WorkerLoop(int worker_id);
+  // Requires mutex_ to be held.
+  void MarkFinished(uint32_t task);
+
+  /*! \brief The tasks of the current run. */
+  const std::vector<std::function<void()> >* tasks_{nullptr};
+  /*! \brief The names of the tasks of the current run, may be null. */
+  const std::vector<std::string>* names_{nullptr};
+  /*! \brief The successors of the tasks of the current run. */
+  const std::vector<std::vector<uint32_t> >* successors_{nullptr};
+  /*! \brief The number of unfinished predecessors of each task. */
+  std::vector<uint32_t> pending_preds_;
+  /*! \brief The tasks ready to run. */
+  std::deque<uint32_t> ready_;
+  /*! \brief The number of tasks of the current run that did not finish. */
+  size_t num_unfinished_{0};
+  /*! \brief The error of the first failed task. */
+  std::string error_;
+  /*! \brief Protects the run state. */
+  std::mutex mutex_;
+  /*! \brief Signals the workers about ready tasks. */
+  std::condition_variable ready_cv_;
+  /*! \brief Signals the caller that the run finished. */
+  std::condition_variable finish_cv_;
+  /*! \brief Whether the workers should exit. */
+  bool exit_now_{false};
+  /*! \brief The intra-op threads of each worker. */
+  int threads_per_worker_;
+  /*! \brief The worker threads. */
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_INTER_OP_EXECUTOR_H_
@@ -0,0 +1,393 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file pipelined_runtime.cc
+ * \brief Asynchronous, double-buffered front-end of graph runtime.
+ */
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief The requests and execution contexts of a pipelined graph runtime.
+ *
+ *  Owns a few execution contexts of one graph runtime module, the buffers
+ *  of the pipeline. A request fills the inputs of a free buffer on the
+ *  submitting thread and is queued, a single executor thread runs the
+ *  queued buffers in order, and the caller copies the outputs out and
+ *  releases the buffer. Filling request N+1 and reading request N back
+ *  thus overlap with running other requests, while only one graph
+ *  computes at a time and keeps the whole thread pool.
+ *
+ *  A request is identified by the id returned by submit. Its outputs stay
+ *  valid until it is released. The callback of a request may read its
+ *  outputs, and the request counts as done once the callback returned.
+ *
+ *  The executor thread shares the ownership of the pipeline, so that it
+ *  can outlive the module while it finishes a callback, see Shutdown.
+ */
+class GraphPipeline : public std::enable_shared_from_this<GraphPipeline> {
+ public:
+  /*!
+   * \brief Initialize the runtime.
+   * \param graph The graph runtime module, its parameters already loaded.
+   * \param num_buffers The number of requests in flight.
+   */
+  void Init(Module graph, int num_buffers) {
+    CHECK_GE(num_buffers, 1);
+    PackedFunc fcreate = graph.GetFunction("create_execution_context");
+    CHECK(fcreate != nullptr) << "The module must be a graph runtime";
+    for (int i = 0; i < num_buffers; ++i) {
+      Buffer buf;
+      buf.module = fcreate();
+      buf.fset_input = buf.module.GetFunction("set_input");
+      buf.frun = buf.module.GetFunction("run");
+      buf.fget_output = buf.module.GetFunction("get_output");
+      buffers_.push_back(buf);
+    }
+    num_outputs_ = graph.GetFunction("get_num_outputs")();
+    std::shared_ptr<GraphPipeline> self = shared_from_this();
+    executor_ = std::thread([self]() { self->ExecLoop(); });
+  }
+
+  /*!
+   * \brief Stop the executor, called when the module is destroyed.
+   *
+   *  Queued requests are dropped without running their callbacks, nobody
+   *  can wait for them anymore. A callback may be blocked on a lock the
+   *  destroying thread holds, e.g. the Python GIL, so an executor inside a
+   *  callback is detached rather than joined, and releases the pipeline
+   *  when it returns.
+   */
+  void Shutdown() {
+    bool in_callback = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_now_ = true;
+      for (size_t index : queue_) {
+        buffers_[index].state = kFree;
+        buffers_[index].callback = PackedFunc();
+      }
+      queue_.clear();
+      for (const Buffer& buf : buffers_) {
+        in_callback = in_callback || buf.in_callback;
+      }
+    }
+    queue_cv_.notify_all();
+    if (!executor_.joinable()) return;
+    if (in_callback) {
+      executor_.detach();
+    } else {
+      executor_.join();
+    }
+  }
+
+  /*! \return The number of outputs of the graph. */
+  int num_outputs() const {
+    return num_outputs_;
+  }
+
+  /*!
+   * \brief Fill a free buffer and queue it, block while all buffers are busy.
+   * \param args The inputs as name, value pairs, optionally followed by a
+   *  callback invoked on the executor thread as callback(id, error), where
+   *  error is empty on success.
+   * \return The request id.
+   */
+  int64_t Submit(const TVMArgs& args) {
+    int num_pairs = args.num_args / 2;
+    PackedFunc callback;
+    if (args.num_args % 2 == 1) {
+      callback = args[args.num_args - 1];
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t index = 0;
+    done_cv_.wait(lock, [this, &index]() {
+        for (index = 0; index < buffers_.size(); ++index) {
+          if (buffers_[index].state == kFree) return true;
+        }
+        return false;
+      });
+    Buffer& buf = buffers_[index];
+    int64_t id = next_id_++;
+    buf.state = kFilling;
+    buf.id = id;
+    buf.error.clear();
+    buf.callback = callback;
+    id_to_buffer_[id] = index;
+    lock.unlock();
+    std::string error;
+    try {
+      for (int i = 0; i < num_pairs; ++i) {
+        buf.fset_input(args[2 * i].operator std::string(), args[2 * i + 1]);
+      }
+    } catch (const std::exception& e) {
+      // Release the buffer before reporting, whatever the failure.
+      error = e.what();
+      if (error.empty()) error = "Exception while setting the inputs";
+    } catch (...) {
+      error = "Unknown exception while setting the inputs";
+    }
+    lock.lock();
+    if (!error.empty()) {
+      ReleaseBuffer(id);
+      lock.unlock();
+      LOG(FATAL) << error;
+    }
+    buf.state = kQueued;
+    queue_.push_back(index);
+    queue_cv_.notify_all();
+    return id;
+  }
+
+  /*!
+   * \brief Block until a request finished running.
+   *
+   *  A request that failed is released and its error is raised.
+   * \param id The request id.
+   */
+  void Wait(int64_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Buffer& buf = buffers_[FindBuffer(id)];
+    done_cv_.wait(lock, [&buf]() { return buf.state == kDone && !buf.in_callback; });
+    if (!buf.error.empty()) {
+      std::string error = buf.error;
+      ReleaseBuffer(id);
+      lock.unlock();
+      LOG(FATAL) << error;
+    }
+  }
+
+  /*! \return Whether the request finished running. */
+  bool IsDone(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Buffer& buf = buffers_[FindBuffer(id)];
+    return buf.state == kDone && !buf.in_callback;
+  }
+
+  /*!
+   * \brief Get an output of a finished request.
+   * \param id The request id.
+   * \return The output function of its buffer.
+   */
+  PackedFunc GetOutputFunc(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Buffer& buf = buffers_[FindBuffer(id)];
+    CHECK(buf.state == kDone) << "Request " << id << " has not finished, wait for it first";
+    return buf.fget_output;
+  }
+
+  /*! \brief Return the buffer of a finished request to the pipeline. */
+  void Release(int64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Buffer& buf = buffers_[FindBuffer(id)];
+    CHECK(buf.state == kDone && !buf.in_callback)
+        << "Request " << id << " has not finished, wait for it first";
+    ReleaseBuffer(id);
+  }
+
+ private:
+  enum BufferState {
+    kFree,
+    kFilling,
+    kQueued,
+    kRunning,
+    kDone
+  };
+  /*! \brief An execution context and the request it holds. */
+  struct Buffer {
+    Module module;
+    PackedFunc fset_input;
+    PackedFunc frun;
+    PackedFunc fget_output;
+    BufferState state{kFree};
+    int64_t id{-1};
+    std::string error;
+    PackedFunc callback;
+    /*! \brief Whether the callback is running, the request is not done before it returns. */
+    bool in_callback{false};
+  };
+
+  size_t FindBuffer(int64_t id) const {
+    auto it = id_to_buffer_.find(id);
+    CHECK(it != id_to_buffer_.end()) << "Unknown or released request " << id;
+    return it->second;
+  }
+
+  // Requires mutex_ to be held.
+  void ReleaseBuffer(int64_t id) {
+    size_t index = FindBuffer(id);
+    buffers_[index].state = kFree;
+    buffers_[index].callback = PackedFunc();
+    id_to_buffer_.erase(id);
+    done_cv_.notify_all();
+  }
+
+  void ExecLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queue_cv_.wait(lock, [this]() { return exit_now_ || !queue_.empty(); });
+      if (exit_now_) break;
+      Buffer& buf = buffers_[queue_.front()];
+      queue_.pop_front();
+      buf.state = kRunning;
+      int64_t id = buf.id;
+      PackedFunc callback = buf.callback;
+      lock.unlock();
+      std::string error;
+      try {
+        buf.frun();
+      } catch (const std::exception& e) {
+        error = e.what();
+        if (error.empty()) error = "Pipelined runtime request failed";
+      } catch (...) {
+        error = "Pipelined runtime request failed with an unknown exception";
+      }
+      lock.lock();
+      buf.error = error;
+      buf.state = kDone;
+      // Once the module is gone nobody can read the outputs, skip the callback.
+      if (callback != nullptr && !exit_now_) {
+        buf.in_callback = true;
+        lock.unlock();
+        try {
+          callback(id, error);
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "Pipelined runtime callback of request " << id
+                       << " failed: " << e.what();
+        } catch (...) {
+          LOG(WARNING) << "Pipelined runtime callback of request " << id
+                       << " failed with an unknown exception";
+        }
+        lock.lock();
+        buf.in_callback = false;
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+  /*! \brief The buffers of the pipeline. */
+  std::vector<Buffer> buffers_;
+  /*! \brief The queued buffers, in submission order. */
+  std::deque<size_t> queue_;
+  /*! \brief The buffer held by each live request. */
+  std::unordered_map<int64_t, size_t> id_to_buffer_;
+  /*! \brief The id of the next request. */
+  int64_t next_id_{0};
+  /*! \brief The number of outputs of the graph. */
+  int num_outputs_{0};
+  /*! \brief Protects everything above. */
+  std::mutex mutex_;
+  /*! \brief Signals the executor about queued buffers. */
+  std::condition_variable queue_cv_;
+  /*! \brief Signals finished and released buffers. */
+  std::condition_variable done_cv_;
+  /*! \brief Whether the executor should exit. */
+  bool exit_now_{false};
+  /*! \brief The executor thread. */
+  std::thread executor_;
+};
+
+/*!
+ * \brief Pipelined graph runtime, the module front-end of GraphPipeline.
+ */
+class PipelinedGraphRuntime : public ModuleNode {
+ public:
+  explicit PipelinedGraphRuntime(std::shared_ptr<GraphPipeline> pipeline)
+      : pipeline_(pipeline) {}
+
+  ~PipelinedGraphRuntime() {
+    pipeline_->Shutdown();
+  }
+
+  const char* type_key() const final {
+    return "PipelinedGraphRuntime";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const std::shared_ptr<ModuleNode>& sptr_to_self) final;
+
+ private:
+  std::shared_ptr<GraphPipeline> pipeline_;
+};
+
+PackedFunc PipelinedGraphRuntime::GetFunction(
+    const std::string& name,
+    const std::shared_ptr<ModuleNode>& sptr_to_self) {
+  if (name == "submit") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = pipeline_->Submit(args);
+      });
+  } else if (name == "wait") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        pipeline_->Wait(args[0]);
+      });
+  } else if (name == "is_done") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = pipeline_->IsDone(args[0]);
+      });
+  } else if (name == "get_output") {
+    // get_output(id, index) or get_output(id, index, out)
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        PackedFunc fget_output = pipeline_->GetOutputFunc(args[0]);
+        if (args.num_args == 3) {
+          fget_output(args[1], args[2]);
+        } else {
+          *rv = fget_output(args[1]);
+        }
+      });
+  } else if (name == "release") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        pipeline_->Release(args[0]);
+      });
+  } else if (name == "get_num_outputs") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = pipeline_->num_outputs();
+      });
+  } else {
+    return PackedFunc();
+  }
+}
+
+// Arguments: the graph runtime module and the number of buffers.
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_pipelined")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    Module graph = args[0];
+    int num_buffers = args.num_args > 1 ? args[1].operator int() : 2;
+    std::shared_ptr<GraphPipeline> pipeline = std::make_shared<GraphPipeline>();
+    pipeline->Init(graph, num_buffers);
+    *rv = Module(std::make_shared<PipelinedGraphRuntime>(pipeline));
+  });
+}  // namespace runtime
+}  // namespace tvm
@@ -29,6 +29,7 @@
 #include <dmlc/io.h>
 #include <tvm/runtime/packed_func.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "runtime_base.h"
 
@@ -46,6 +47,21 @@ struct FunctionInfo {
   void Save(dmlc::Stream *writer) const;
   bool Load(dmlc::Stream *reader);
 };
+
+/*!
+ * \brief Get the function names in a function information table.
+ * \param fmap The function information table.
+ * \return The function names.
+ */
+inline std::vector<std::string> FunctionInfoNames(
+    const std::unordered_map<std::string, FunctionInfo>& fmap) {
+  std::vector<std::string> names;
+  names.reserve(fmap.size());
+  for (const auto& kv : fmap) {
+    names.push_back(kv.first);
+  }
+  return names;
+}
 }  // namespace runtime
 }  // namespace tvm
 
@@ -71,6 +71,10 @@ class MetalModuleNode final :public runtime::ModuleNode {
     stream->Write(fmap_);
     stream->Write(data_);
   }
+
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
   std::string GetSource(const std::string& format) final {
     if (format == fmt_) return data_;
     if (source_.length() != 0) {
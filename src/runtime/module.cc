@@ -98,6 +98,10 @@ std::string ModuleNode::GetSource(const std::string& format) {
   return "";
 }
 
+std::vector<std::string> ModuleNode::GetFunctionNames() {
+  return {};
+}
+
 const PackedFunc* ModuleNode::GetFuncFromEnv(const std::string& name) {
   auto it = import_cache_.find(name);
   if (it != import_cache_.end()) return it->second.get();
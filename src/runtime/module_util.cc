@@ -29,12 +29,98 @@
 #include <tvm/runtime/registry.h>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 #include "module_util.h"
 
 namespace tvm {
 namespace runtime {
 
-void ImportModuleBlob(const char* mblob, std::vector<Module>* mlist) {
+#ifndef _LIBCPP_SGX_CONFIG
+/*!
+ * \brief Placeholder of an imported module in an indexed module blob.
+ *
+ *  Keeps a reference to the serialized payload and only invokes the
+ *  module loader the first time one of the indexed functions is requested.
+ */
+class LazyImportModuleNode final : public ModuleNode {
+ public:
+  LazyImportModuleNode(std::string type_key,
+                       std::vector<std::string> func_names,
+                       const char* payload,
+                       size_t payload_size,
+                       std::shared_ptr<void> blob_owner)
+      : type_key_(std::move(type_key)),
+        func_names_(std::move(func_names)),
+        func_index_(func_names_.begin(), func_names_.end()),
+        payload_(payload),
+        payload_size_(payload_size),
+        blob_owner_(std::move(blob_owner)) {}
+
+  const char* type_key() const final {
+    return type_key_.c_str();
+  }
+
+  PackedFunc GetFunction(
+      const std::string& name,
+      const std::shared_ptr<ModuleNode>& sptr_to_self) final {
+    // An empty index means the module could not enumerate its functions,
+    // in which case any lookup has to load it.
+    if (!func_index_.empty() && !func_index_.count(name)) {
+      return PackedFunc();
+    }
+    return Materialize().GetFunction(name, false);
+  }
+
+  void SaveToFile(const std::string& file_name,
+                  const std::string& format) final {
+    Materialize()->SaveToFile(file_name, format);
+  }
+
+  void SaveToBinary(dmlc::Stream* stream) final {
+    // The payload is exactly what the module wrote, no need to load it.
+    stream->Write(payload_, payload_size_);
+  }
+
+  std::string GetSource(const std::string& format) final {
+    return Materialize()->GetSource(format);
+  }
+
+  std::vector<std::string> GetFunctionNames() final {
+    return func_names_;
+  }
+
+ private:
+  Module Materialize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!loaded_) {
+      std::string fkey = "module.loadbinary_" + type_key_;
+      const PackedFunc* f = Registry::Get(fkey);
+      CHECK(f != nullptr)
+          << "Loader of " << type_key_ << "("
+          << fkey << ") is not presented.";
+      dmlc::MemoryFixedSizeStream fs(const_cast<char*>(payload_), payload_size_);
+      dmlc::Stream* stream = &fs;
+      module_ = (*f)(static_cast<void*>(stream));
+      loaded_ = true;
+    }
+    return module_;
+  }
+
+  std::string type_key_;
+  std::vector<std::string> func_names_;
+  std::unordered_set<std::string> func_index_;
+  const char* payload_;
+  size_t payload_size_;
+  std::shared_ptr<void> blob_owner_;
+  std::mutex mutex_;
+  bool loaded_{false};
+  Module module_;
+};
+#endif
+
+void ImportModuleBlob(const char* mblob, std::vector<Module>* mlist,
+                      std::shared_ptr<void> blob_owner) {
 #ifndef _LIBCPP_SGX_CONFIG
   CHECK(mblob != nullptr);
   uint64_t nbytes = 0;
@@ -42,11 +128,35 @@ void ImportModuleBlob(const char* mblob, std::vector<Module>* mlist) {
     uint64_t c = mblob[i];
     nbytes |=  (c & 0xffUL) << (i * 8);
   }
+  const char* data = mblob + sizeof(nbytes);
   dmlc::MemoryFixedSizeStream fs(
-      const_cast<char*>(mblob + sizeof(nbytes)), static_cast<size_t>(nbytes));
+      const_cast<char*>(data), static_cast<size_t>(nbytes));
   dmlc::Stream* stream = &fs;
   uint64_t size;
   CHECK(stream->Read(&size));
+  if (size == kModuleBlobIndexMagic) {
+    CHECK(stream->Read(&size));
+    for (uint64_t i = 0; i < size; ++i) {
+      std::string tkey;
+      std::vector<std::string> func_names;
+      uint64_t payload_size;
+      CHECK(stream->Read(&tkey));
+      CHECK(stream->Read(&func_names));
+      CHECK(stream->Read(&payload_size));
+      size_t offset = fs.Tell();
+      CHECK_LE(offset + payload_size, nbytes)
+          << "Module blob of " << tkey << " is truncated";
+      fs.Seek(offset + static_cast<size_t>(payload_size));
+      std::string fkey = "module.loadbinary_" + tkey;
+      CHECK(Registry::Get(fkey) != nullptr)
+          << "Loader of " << tkey << "("
+          << fkey << ") is not presented.";
+      mlist->push_back(Module(std::make_shared<LazyImportModuleNode>(
+          tkey, std::move(func_names), data + offset,
+          static_cast<size_t>(payload_size), blob_owner)));
+    }
+    return;
+  }
   for (uint64_t i = 0; i < size; ++i) {
     std::string tkey;
     CHECK(stream->Read(&tkey));
@@ -46,12 +46,28 @@ namespace runtime {
  * \param mptr The module pointer node.
  */
 PackedFunc WrapPackedFunc(BackendPackedCFunc faddr, const std::shared_ptr<ModuleNode>& mptr);
+/*!
+ * \brief Magic number that marks an indexed module blob.
+ *
+ *  An indexed blob records, for each imported module, its type key,
+ *  the function names it exposes and the size of its serialized payload.
+ *  This allows the payload to stay in place and be deserialized only when
+ *  one of its functions is first requested.
+ */
+constexpr uint64_t kModuleBlobIndexMagic = 0xFF7E5A4C4D565454UL;
 /*!
  * \brief Load and append module blob to module list
+ *
+ *  Modules in an indexed blob are appended as lazy placeholders that
+ *  are deserialized on their first function lookup.
+ *
  * \param mblob The module blob.
  * \param module_list The module list to append to
+ * \param blob_owner Reference that keeps the blob memory alive,
+ *        nullptr if the blob has static lifetime.
  */
-void ImportModuleBlob(const char* mblob, std::vector<Module>* module_list);
+void ImportModuleBlob(const char* mblob, std::vector<Module>* module_list,
+                      std::shared_ptr<void> blob_owner = nullptr);
 
 /*!
  * \brief Utility to initialize conext function symbols during startup
@@ -283,6 +283,9 @@ class OpenCLModuleNode : public ModuleNode {
                   const std::string& format) final;
   void SaveToBinary(dmlc::Stream* stream) final;
   std::string GetSource(const std::string& format) final;
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
   // Initialize the programs
   void Init();
   // install a new kernel to thread local entry
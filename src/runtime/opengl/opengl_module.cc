@@ -53,6 +53,10 @@ class OpenGLModuleNode final : public ModuleNode {
 
   void SaveToBinary(dmlc::Stream* stream) final;
 
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
+
   const gl::Program& GetProgram(const std::string& func_name) const;
 
   const OpenGLShader& GetShader(const std::string& func_name) const;
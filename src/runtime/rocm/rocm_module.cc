@@ -77,6 +77,10 @@ class ROCMModuleNode : public runtime::ModuleNode {
     stream->Write(data_);
   }
 
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
+
   std::string GetSource(const std::string& format) final {
     if (format == fmt_) { return data_; }
     if (format == "llvm") { return hip_source_; }
@@ -25,6 +25,7 @@
 #include <tvm/runtime/registry.h>
 #include <memory>
 #include <cstring>
+#include <vector>
 #include "rpc_session.h"
 
 namespace tvm {
@@ -44,6 +45,12 @@ class RPCWrappedFunc {
   void operator()(TVMArgs args, TVMRetValue *rv) const {
     sess_->CallFunc(handle_, args, rv, &fwrap_);
   }
+  uint64_t AsyncCall(TVMArgs args, std::vector<TVMRetValue> keep_alive) const {
+    return sess_->AsyncCallFunc(handle_, args, fwrap_, std::move(keep_alive));
+  }
+  const std::shared_ptr<RPCSession>& sess() const {
+    return sess_;
+  }
   ~RPCWrappedFunc() {
     try {
       sess_->CallRemote(RPCCode::kFreeFunc, handle_);
@@ -100,6 +107,17 @@ class RPCWrappedFunc {
   std::shared_ptr<RPCSession> sess_;
 };
 
+// PackedFunc body of a wrapped remote function.
+// Being a named type, it allows the remote function to be recovered
+// from the PackedFunc, e.g. for asynchronous calls.
+struct RPCWrappedFuncRef {
+  std::shared_ptr<RPCWrappedFunc> wf;
+
+  void operator()(TVMArgs args, TVMRetValue *rv) const {
+    wf->operator()(args, rv);
+  }
+};
+
 // RPC that represents a remote module session.
 class RPCModuleNode final : public ModuleNode {
  public:
@@ -144,10 +162,14 @@ class RPCModuleNode final : public ModuleNode {
                               TVMContext ctx,
                               int number,
                               int repeat,
-                              int min_repeat_ms) {
+                              int min_repeat_ms,
+                              int warmup,
+                              bool flush_cache,
+                              bool pin_thread) {
     RPCFuncHandle handle = GetFuncHandle(name);
     if (handle == nullptr) return PackedFunc();
-    handle = sess_->GetTimeEvaluator(handle, ctx, number, repeat, min_repeat_ms);
+    handle = sess_->GetTimeEvaluator(handle, ctx, number, repeat, min_repeat_ms,
+                                     warmup, flush_cache, pin_thread);
     return WrapRemote(handle);
   }
 
@@ -159,9 +181,7 @@ class RPCModuleNode final : public ModuleNode {
   PackedFunc WrapRemote(RPCFuncHandle handle) {
     if (handle == nullptr) return PackedFunc();
     auto wf = std::make_shared<RPCWrappedFunc>(handle, sess_);
-    return PackedFunc([wf](TVMArgs args, TVMRetValue* rv) {
-        return wf->operator()(args, rv);
-      });
+    return PackedFunc(RPCWrappedFuncRef{wf});
   }
 
   RPCFuncHandle GetFuncHandle(const std::string& name) {
@@ -191,9 +211,7 @@ void RPCWrappedFunc::WrapRemote(std::shared_ptr<RPCSession> sess,
   if (handle == nullptr) return;
   if (tcode == kFuncHandle) {
     auto wf = std::make_shared<RPCWrappedFunc>(handle, sess);
-    *rv = PackedFunc([wf](TVMArgs args, TVMRetValue* rv) {
-        return wf->operator()(args, rv);
-      });
+    *rv = PackedFunc(RPCWrappedFuncRef{wf});
   } else if (tcode == kModuleHandle) {
     std::shared_ptr<RPCModuleNode> n =
         std::make_shared<RPCModuleNode>(handle, sess);
@@ -221,12 +239,17 @@ TVM_REGISTER_GLOBAL("module._RPCTimeEvaluator")
     TVMContext ctx;
     ctx.device_type = static_cast<DLDeviceType>(args[2].operator int());
     ctx.device_id = args[3];
+    int warmup = args.size() > 7 ? args[7].operator int() : 1;
+    bool flush_cache = args.size() > 8 && args[8].operator bool();
+    bool pin_thread = args.size() > 9 && args[9].operator bool();
     if (tkey == "rpc") {
       *rv = static_cast<RPCModuleNode*>(m.operator->())
-          ->GetTimeEvaluator(args[1], ctx, args[4], args[5], args[6]);
+          ->GetTimeEvaluator(args[1], ctx, args[4], args[5], args[6],
+                             warmup, flush_cache, pin_thread);
     } else {
       *rv = WrapTimeEvaluator(
-          m.GetFunction(args[1], false), ctx, args[4], args[5], args[6]);
+          m.GetFunction(args[1], false), ctx, args[4], args[5], args[6],
+          warmup, flush_cache, pin_thread);
     }
   });
 
@@ -273,5 +296,64 @@ TVM_REGISTER_GLOBAL("rpc._SessTableIndex")
     *rv = static_cast<RPCModuleNode*>(m.operator->())->sess()->table_index();
   });
 
+TVM_REGISTER_GLOBAL("rpc._AsyncCall")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    PackedFunc f = args[0];
+    PackedFunc::FType body = f.body();
+    const RPCWrappedFuncRef* ref = body.target<RPCWrappedFuncRef>();
+    CHECK(ref != nullptr) << "Asynchronous call expects a remote function";
+    // Keep the function and the object arguments alive until the call completes.
+    std::vector<TVMRetValue> keep_alive(1);
+    keep_alive[0] = f;
+    for (int i = 1; i < args.size(); ++i) {
+      int tcode = args.type_codes[i];
+      if (tcode == kNDArrayContainer || tcode == kFuncHandle || tcode == kModuleHandle) {
+        keep_alive.emplace_back();
+        keep_alive.back() = args[i];
+      }
+    }
+    TVMArgs call_args(args.values + 1, args.type_codes + 1, args.size() - 1);
+    *rv = static_cast<int64_t>(ref->wf->AsyncCall(call_args, std::move(keep_alive)));
+  });
+
+TVM_REGISTER_GLOBAL("rpc._AsyncDone")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    Module m = args[0];
+    std::string tkey = m->type_key();
+    CHECK_EQ(tkey, "rpc");
+    int64_t id = args[1];
+    *rv = static_cast<RPCModuleNode*>(m.operator->())->sess()->AsyncDone(
+        static_cast<uint64_t>(id));
+  });
+
+TVM_REGISTER_GLOBAL("rpc._AsyncWait")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    Module m = args[0];
+    std::string tkey = m->type_key();
+    CHECK_EQ(tkey, "rpc");
+    int64_t id = args[1];
+    static_cast<RPCModuleNode*>(m.operator->())->sess()->AsyncWait(
+        static_cast<uint64_t>(id), rv);
+  });
+
+TVM_REGISTER_GLOBAL("rpc._ConfigAsyncWorkers")
+.set_body_typed(RPCSession::ConfigAsyncWorkers);
+
+TVM_REGISTER_GLOBAL("rpc._AsyncProtocolVersion")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    *rv = kRPCAsyncProtocolVersion;
+  });
+
+TVM_REGISTER_GLOBAL("rpc._SessConfigCopy")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    Module m = args[0];
+    std::string tkey = m->type_key();
+    CHECK_EQ(tkey, "rpc");
+    int64_t chunk_bytes = args[1];
+    CHECK_GE(chunk_bytes, 0);
+    static_cast<RPCModuleNode*>(m.operator->())->sess()->ConfigCopy(
+        static_cast<size_t>(chunk_bytes), args[2]);
+  });
+
 }  // namespace runtime
 }  // namespace tvm
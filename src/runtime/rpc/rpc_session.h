@@ -31,12 +31,19 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <vector>
 #include "../../common/ring_buffer.h"
 
 namespace tvm {
 namespace runtime {
 
 const int kRPCMagic = 0xff271;
+/*!
+ * \brief Version of the asynchronous call protocol, reported by the
+ *  remote global rpc._AsyncProtocolVersion. Remote ends without the
+ *  function do not support asynchronous calls.
+ */
+const int kRPCAsyncProtocolVersion = 1;
 
 /*! \brief The remote functio handle */
 using RPCFuncHandle = void*;
@@ -69,7 +76,10 @@ enum class RPCCode : int {
   kModuleFree,
   kModuleGetFunc,
   kModuleGetSource,
-  kNDArrayFree
+  kNDArrayFree,
+  // Asynchronous calls, tagged with a request id.
+  kAsyncCallFunc,
+  kAsyncReturn
 };
 
 /*!
@@ -87,6 +97,24 @@ class RPCChannel {
    */
   virtual size_t Send(const void* data, size_t size) = 0;
   /*!
+   * \brief Send a sequence of buffers over to the channel.
+   *
+   *  Channels that support scatter-gather I/O override this so that
+   *  bulk payloads can be sent without first being copied into the
+   *  message buffer. The default sends the first non-empty buffer.
+   *
+   * \param bufs The data pointers.
+   * \param sizes The size of each buffer.
+   * \param num The number of buffers.
+   * \return The actual bytes sent, counted across the buffers in order.
+   */
+  virtual size_t SendV(const void* const* bufs, const size_t* sizes, size_t num) {
+    for (size_t i = 0; i < num; ++i) {
+      if (sizes[i] != 0) return Send(bufs[i], sizes[i]);
+    }
+    return 0;
+  }
+  /*!
 e   * \brief Recv data from channel.
    *
    * \param data The data pointer.
@@ -94,6 +122,18 @@ e   * \brief Recv data from channel.
    * \return The actual bytes received.
    */
   virtual size_t Recv(void* data, size_t size) = 0;
+  /*!
+   * \brief Check whether Recv would return without blocking.
+   *
+   *  Lets a session pick up replies it is not waiting for, e.g. when
+   *  checking whether an asynchronous call is done. Channels that cannot
+   *  tell return false, their replies are picked up while waiting.
+   *
+   * \return Whether data, or the end of the stream, is ready.
+   */
+  virtual bool Poll() {
+    return false;
+  }
 };
 
 // Bidirectional Communication Session of PackedRPC
@@ -132,6 +172,44 @@ class RPCSession {
                 TVMArgs args,
                 TVMRetValue* rv,
                 const PackedFunc* fwrap);
+  /*!
+   * \brief Start an asynchronous call of a remote function.
+   *
+   *  The request is tagged with an id so that several calls can be in
+   *  flight over the session, along with synchronous calls and copies.
+   *  A server started by ServerLoop runs them on a worker pool. Servers
+   *  that predate asynchronous calls run the call synchronously instead.
+   *
+   * \param handle The function handle
+   * \param args The arguments
+   * \param fwrap Wrapper function to turn Function/Module handle into real return.
+   * \param keep_alive Local objects that must live until the call completes.
+   * \return The id of the call.
+   */
+  uint64_t AsyncCallFunc(RPCFuncHandle handle,
+                         TVMArgs args,
+                         const PackedFunc& fwrap,
+                         std::vector<TVMRetValue> keep_alive);
+  /*!
+   * \brief Check whether the result of an asynchronous call has been received.
+   * \param id The id of the call.
+   * \return Whether the call has completed.
+   * \note Reads the replies the channel already holds without blocking,
+   *  other replies are received while the session waits for any reply.
+   */
+  bool AsyncDone(uint64_t id);
+  /*!
+   * \brief Wait for an asynchronous call and take its result.
+   * \param id The id of the call.
+   * \param rv The return value.
+   */
+  void AsyncWait(uint64_t id, TVMRetValue* rv);
+  /*!
+   * \brief Set the number of workers that run asynchronous calls
+   *  in server sessions created afterwards, 0 runs them inline.
+   * \param num_workers The number of workers.
+   */
+  static void ConfigAsyncWorkers(int num_workers);
   /*!
    * \brief Copy bytes into remote array content.
    * \param from The source host data.
@@ -166,6 +244,18 @@ class RPCSession {
                       size_t nbytes,
                       TVMContext ctx_from,
                       TVMType type_hint);
+  /*!
+   * \brief Configure how bulk copies are split and pipelined.
+   *
+   *  A copy larger than chunk_bytes is sent as a sequence of chunk
+   *  requests, up to window of which are in flight at the same time.
+   *  This bounds the message buffers on both ends and lets the remote
+   *  side store one chunk while the next one is on the wire.
+   *
+   * \param chunk_bytes The size of each chunk, 0 sends a copy as one request.
+   * \param window The maximum number of chunk requests in flight.
+   */
+  void ConfigCopy(size_t chunk_bytes, int window);
   /*!
    * \brief Get a remote timer function on ctx.
    *  This function consumes fhandle, caller should not call Free on fhandle.
@@ -175,8 +265,8 @@ class RPCSession {
    * \param number The number of times to run this function for taking average.
           We call these runs as one `repeat` of measurement.
    * \param repeat The number of times to repeat the measurement.
-          In total, the function will be invoked (1 + number x repeat) times,
-          where the first one is warm up and will be discarded.
+          In total, the function will be invoked (warmup + number x repeat) times,
+          where the first `warmup` calls are discarded.
           The returned result contains `repeat` costs,
           each of which is an average of `number` costs.
    * \param min_repeat_ms The minimum duration of one `repeat` in milliseconds.
@@ -185,13 +275,19 @@ class RPCSession {
           minimum duration requirement of one `repeat`.
           i.e., When the run time of one `repeat` falls below this time,
           the `number` parameter will be automatically increased.
+   * \param warmup The number of discarded calls before the measurement.
+   * \param flush_cache Whether to flush the host caches before each timed run.
+   * \param pin_thread Whether to pin the measuring thread to its current core.
    * \return A remote timer function
    */
   RPCFuncHandle GetTimeEvaluator(RPCFuncHandle fhandle,
                                  TVMContext ctx,
                                  int number,
                                  int repeat,
-                                 int min_repeat_ms);
+                                 int min_repeat_ms,
+                                 int warmup = 1,
+                                 bool flush_cache = false,
+                                 bool pin_thread = false);
   /*!
    * \brief Call a remote defined system function with arguments.
    * \param fcode The function code.
@@ -227,10 +323,20 @@ class RPCSession {
 
  private:
   class EventHandler;
+  class AsyncWorkerPool;
   // Handle events until receives a return
   // Also flushes channels so that the function advances.
   RPCCode HandleUntilReturnEvent(
       TVMRetValue* rv, bool client_mode, const PackedFunc* fwrap);
+  // Flush the pending messages to the channel.
+  void FlushWriter();
+  // Whether the remote end understands asynchronous calls.
+  bool RemoteSupportsAsync();
+  // Flush the pending message followed by the payload to the channel.
+  void SendWithPayload(const char* payload, size_t size);
+  // Wait for the reply of one chunk request of a bulk copy.
+  // The payload of a copy from remote is received into dst.
+  void WaitCopyReply(RPCCode expect, char* dst, size_t size);
   // Initalization
   void Init();
   // Shutdown
@@ -239,6 +345,14 @@ class RPCSession {
   std::unique_ptr<RPCChannel> channel_;
   // Internal mutex
   std::recursive_mutex mutex_;
+  // Serializes writes to the channel, which also come from async workers.
+  std::mutex send_mutex_;
+  // Workers running the asynchronous calls of a server session.
+  std::unique_ptr<AsyncWorkerPool> async_pool_;
+  // The id of the next asynchronous call.
+  uint64_t next_async_id_{1};
+  // Whether the remote end supports asynchronous calls, -1 if unknown.
+  int remote_async_{-1};
   // Internal ring buffer.
   common::RingBuffer reader_, writer_;
   // Event handler.
@@ -251,6 +365,10 @@ class RPCSession {
   std::string name_;
   // The remote key
   std::string remote_key_;
+  // The chunk size of bulk copies.
+  size_t copy_chunk_bytes_{4UL << 20};
+  // The number of chunk requests in flight during a bulk copy.
+  int copy_window_{4};
 };
 
 /*!
@@ -260,8 +378,8 @@ class RPCSession {
  * \param number The number of times to run this function for taking average.
           We call these runs as one `repeat` of measurement.
  * \param repeat The number of times to repeat the measurement.
-          In total, the function will be invoked (1 + number x repeat) times,
-          where the first one is warm up and will be discarded.
+          In total, the function will be invoked (warmup + number x repeat) times,
+          where the first `warmup` calls are discarded.
           The returned result contains `repeat` costs,
           each of which is an average of `number` costs.
  * \param min_repeat_ms The minimum duration of one `repeat` in milliseconds.
@@ -270,13 +388,22 @@ class RPCSession {
           minimum duration requirement of one `repeat`.
           i.e., When the run time of one `repeat` falls below this time,
           the `number` parameter will be automatically increased.
+ * \param warmup The number of calls made and discarded before the measurement.
+ * \param flush_cache Whether to flush the host caches before each run.
+          When set, every run is timed on its own and the flush is excluded
+          from the measured time, so the result reflects cold-cache behavior.
+ * \param pin_thread Whether to pin the calling thread to its current core
+          for the duration of the measurement.
  * \return f_timer A timer function.
  */
 PackedFunc WrapTimeEvaluator(PackedFunc f,
                              TVMContext ctx,
                              int number,
                              int repeat,
-                             int min_repeat_ms);
+                             int min_repeat_ms,
+                             int warmup = 1,
+                             bool flush_cache = false,
+                             bool pin_thread = false);
 
 /*!
  * \brief Create a Global RPC module that refers to the session.
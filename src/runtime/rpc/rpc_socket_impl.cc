@@ -24,6 +24,11 @@
  */
 #include <tvm/runtime/registry.h>
 #include <memory>
+#include <vector>
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/uio.h>
+#endif
 #include "rpc_session.h"
 #include "../../common/socket.h"
 
@@ -46,6 +51,25 @@ class SockChannel final : public RPCChannel {
     }
     return static_cast<size_t>(n);
   }
+#ifndef _WIN32
+  size_t SendV(const void* const* bufs, const size_t* sizes, size_t num) final {
+    std::vector<iovec> iov;
+    iov.reserve(num);
+    for (size_t i = 0; i < num; ++i) {
+      if (sizes[i] == 0) continue;
+      iovec v;
+      v.iov_base = const_cast<void*>(bufs[i]);
+      v.iov_len = sizes[i];
+      iov.push_back(v);
+    }
+    if (iov.empty()) return 0;
+    ssize_t n = writev(sock_.sockfd, iov.data(), static_cast<int>(iov.size()));
+    if (n == -1) {
+      common::Socket::Error("SockChannel::SendV");
+    }
+    return static_cast<size_t>(n);
+  }
+#endif
   size_t Recv(void* data, size_t size) final {
     ssize_t n = sock_.Recv(data, size);
     if (n == -1) {
@@ -53,6 +77,15 @@ class SockChannel final : public RPCChannel {
     }
     return static_cast<size_t>(n);
   }
+#ifndef _WIN32
+  bool Poll() final {
+    pollfd pfd;
+    pfd.fd = sock_.sockfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0;
+  }
+#endif
 
  private:
   common::TCPSocket sock_;
@@ -30,6 +30,7 @@
 #include "../../registry.cc"
 #include "../../system_lib_module.cc"
 #include "../../thread_pool.cc"
+#include "../../trace.cc"
 #include "../../workspace_pool.cc"
 #include "ecall_registry.h"
 #include "runtime.h"
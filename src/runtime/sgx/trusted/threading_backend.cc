@@ -72,19 +72,34 @@ ThreadGroup::ThreadGroup(int num_workers,
                          bool exclude_worker0)
   : impl_(new ThreadGroup::Impl(num_workers, worker_callback, exclude_worker0)) {}
 void ThreadGroup::Join() {}
-int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
+int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                           int core_offset) {
   int max_conc = MaxConcurrency();
   if (!nthreads || ntheads > max_conc) {
     return max_conc;
   }
   return nthreads;
 }
+int ThreadGroup::ConfigureNumaNode(int node, int nthreads, bool exclude_worker0) {
+  return Configure(kBig, nthreads, exclude_worker0);
+}
 ThreadGroup::~ThreadGroup() { delete impl_; }
 
 void Yield() {}
 
 int MaxConcurrency() { return TVM_SGX_MAX_CONCURRENCY; }
 
+int NumaNodeCount() { return 1; }
+
+const std::vector<unsigned>& NumaNodeCpus(int node) {
+  static std::vector<unsigned> cpus(1, 0);
+  return cpus;
+}
+
+void SetNumaNode(int node) {}
+
+int GetNumaNode() { return -1; }
+
 TVM_REGISTER_ENCLAVE_FUNC("__tvm_run_worker__")
 .set_body([](TVMArgs args, TVMRetValue* rv) {
     void* tg = args[0];
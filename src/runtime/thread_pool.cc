@@ -40,6 +40,8 @@
 #include <memory>
 #include <sstream>
 
+#include "trace.h"
+
 const constexpr int kL1CacheBytes = 64;
 
 namespace tvm {
@@ -47,6 +49,9 @@ namespace runtime {
 
 // stride in the page, fit to cache line.
 constexpr int kSyncStride = 64 / sizeof(std::atomic<int>);
+// flag in the header slot of the counter page,
+// the request runs in work-stealing mode, where the barrier cannot be used.
+constexpr int kSyncNoBarrier = 1;
 
 /*!
  * \brief Thread local master environment.
@@ -63,24 +68,72 @@ class ParallelLauncher {
     this->flambda = flambda;
     this->env.num_task = num_task;
     has_error_.store(false);
+    work_stealing_ = false;
     // reshape
     if (static_cast<size_t>(num_task) > par_errors_.size()) {
       par_errors_.resize(num_task + 1);
-      if (need_sync) {
-        delete[] sync_counter_;
-        sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
-      }
     }
     if (need_sync) {
-      for (int i = 0; i < num_task; ++i) {
-        sync_counter_[i * kSyncStride].store(
-            0, std::memory_order_relaxed);
-      }
+      InitSyncCounter(num_task, 0);
       this->env.sync_handle = sync_counter_;
     } else {
       this->env.sync_handle = nullptr;
     }
   }
+  /*!
+   * \brief Switch the current request to work-stealing mode.
+   *
+   *  Must be called after Init, with env.num_task set to the number of chunks.
+   *  The chunks are evenly split into contiguous ranges, one per worker.
+   *  A worker consumes its own range from the front and steals from the
+   *  back of the other ranges once its own range is drained.
+   *
+   * \param num_workers The number of workers taking part in the launch.
+   */
+  void InitStealing(int num_workers) {
+    int num_chunk = env.num_task;
+    num_pending_.store(num_workers);
+    work_stealing_ = true;
+    // keep a counter page so that a barrier call is detected and reported
+    InitSyncCounter(0, kSyncNoBarrier);
+    this->env.sync_handle = sync_counter_;
+    if (num_workers > steal_ranges_size_) {
+      steal_ranges_.reset(new StealRange[num_workers]);
+      steal_ranges_size_ = num_workers;
+    }
+    for (int i = 0; i < num_workers; ++i) {
+      uint32_t begin = static_cast<uint32_t>(
+          static_cast<int64_t>(num_chunk) * i / num_workers);
+      uint32_t end = static_cast<uint32_t>(
+          static_cast<int64_t>(num_chunk) * (i + 1) / num_workers);
+      steal_ranges_[i].range.store(PackRange(begin, end),
+                                   std::memory_order_relaxed);
+    }
+    num_steal_workers_ = num_workers;
+  }
+  /*!
+   * \brief Run the work assigned to task_id on the calling thread.
+   * \param task_id The task id, it is the worker index in work-stealing mode.
+   */
+  void RunTask(int task_id) {
+    trace::Scope trace_scope("parallel", "task");
+    if (!work_stealing_) {
+      if ((*flambda)(task_id, &env, cdata) == 0) {
+        SignalJobFinish();
+      } else {
+        SignalJobError(task_id);
+      }
+      return;
+    }
+    int chunk_id;
+    while (NextChunk(task_id, &chunk_id)) {
+      if ((*flambda)(chunk_id, &env, cdata) != 0) {
+        par_errors_[chunk_id] = TVMGetLastError();
+        has_error_.store(true);
+      }
+    }
+    SignalJobFinish();
+  }
   ~ParallelLauncher() {
     delete[] sync_counter_;
   }
@@ -131,10 +184,85 @@ class ParallelLauncher {
   std::atomic<int32_t> num_pending_;
   // Whether error has been countered.
   std::atomic<bool> has_error_;
+  /*! \brief Chunk range [begin, end) owned by a worker, packed in one word. */
+  struct StealRange {
+    std::atomic<uint64_t> range;
+    // pad to a cache line to avoid false sharing between workers
+    char pad[kL1CacheBytes - sizeof(std::atomic<uint64_t>)];
+  };
+  static uint64_t PackRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(end) << 32) | begin;
+  }
+  /*!
+   * \brief Get the next chunk to execute, stealing from other workers if needed.
+   * \param worker_id The index of the calling worker.
+   * \param chunk_id The pointer to store the chunk id.
+   * \return Whether a chunk was obtained.
+   */
+  bool NextChunk(int worker_id, int* chunk_id) {
+    // take from the front of our own range
+    std::atomic<uint64_t>& own = steal_ranges_[worker_id].range;
+    uint64_t cur = own.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(cur) < static_cast<uint32_t>(cur >> 32)) {
+      uint32_t begin = static_cast<uint32_t>(cur);
+      if (own.compare_exchange_weak(cur, PackRange(begin + 1, cur >> 32),
+                                    std::memory_order_acq_rel)) {
+        *chunk_id = static_cast<int>(begin);
+        return true;
+      }
+    }
+    // steal from the back of the other ranges
+    for (int k = 1; k < num_steal_workers_; ++k) {
+      std::atomic<uint64_t>& victim =
+          steal_ranges_[(worker_id + k) % num_steal_workers_].range;
+      cur = victim.load(std::memory_order_acquire);
+      while (static_cast<uint32_t>(cur) < static_cast<uint32_t>(cur >> 32)) {
+        uint32_t end = static_cast<uint32_t>(cur >> 32);
+        if (victim.compare_exchange_weak(
+                cur, PackRange(static_cast<uint32_t>(cur), end - 1),
+                std::memory_order_acq_rel)) {
+          *chunk_id = static_cast<int>(end - 1);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+  /*!
+   * \brief Reset the counter page.
+   *
+   *  Slot 0 of the page holds the kSync* flags of the request,
+   *  slot i + 1 holds the barrier counter of task i.
+   *
+   * \param num_task The number of tasks that take part in the barrier.
+   * \param flags The initial flags.
+   */
+  void InitSyncCounter(int num_task, int flags) {
+    if (num_task + 1 > sync_counter_size_) {
+      delete[] sync_counter_;
+      sync_counter_ = new std::atomic<int>[(num_task + 1) * kSyncStride];
+      sync_counter_size_ = num_task + 1;
+    }
+    sync_counter_[0].store(flags, std::memory_order_relaxed);
+    for (int i = 1; i <= num_task; ++i) {
+      sync_counter_[i * kSyncStride].store(
+          0, std::memory_order_relaxed);
+    }
+  }
   // The counter page.
   std::atomic<int32_t>* sync_counter_{nullptr};
+  // The number of slots in the counter page.
+  int sync_counter_size_{0};
   // The error message
   std::vector<std::string> par_errors_;
+  // Whether the current request runs in work-stealing mode.
+  bool work_stealing_{false};
+  // The number of workers taking part in work stealing.
+  int num_steal_workers_{0};
+  // The chunk ranges of each worker.
+  std::unique_ptr<StealRange[]> steal_ranges_;
+  // The number of workers the chunk ranges can host.
+  int steal_ranges_size_{0};
 };
 
 /*! \brief Lock-free single-producer-single-consumer queue for each thread */
@@ -260,9 +388,21 @@ class SpscTaskQueue {
 };
 
 // The thread pool
+/*!
+ * \brief The number of workers of the pool of a thread, read when the
+ *  pool is created on the first parallel launch of the thread.
+ */
+struct ThreadPoolSize {
+  /*! \brief The number of workers, 0 for MaxConcurrency. */
+  int num_workers{0};
+  static ThreadPoolSize* ThreadLocal() {
+    return dmlc::ThreadLocalStore<ThreadPoolSize>::Get();
+  }
+};
+
 class ThreadPool {
  public:
-  ThreadPool(): num_workers_(tvm::runtime::threading::MaxConcurrency()) {
+  ThreadPool(): num_workers_(InitialNumWorkers()) {
     for (int i = 0; i < num_workers_; ++i) {
       // The SpscTaskQueue only hosts ONE item at a time
       queues_.emplace_back(std::unique_ptr<SpscTaskQueue>(new SpscTaskQueue()));
@@ -272,6 +412,10 @@ class ThreadPool {
           num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
           exclude_worker0_ /* include_main_thread */));
     num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
+    const char *val = getenv("TVM_PARALLEL_CHUNKS_PER_WORKER");
+    if (val != nullptr) {
+      chunks_per_worker_ = std::max(atoi(val), 1);
+    }
   }
   ~ThreadPool() {
     for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
@@ -286,15 +430,25 @@ class ThreadPool {
     ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
     CHECK(!launcher->is_worker)
         << "Cannot launch parallel job inside worker, consider fuse then parallel";
-    if (num_task == 0) {
+    // Only split into finer chunks when the code generator marked the lambda
+    // as partitioning its loop by env.num_task without calling the barrier.
+    bool work_stealing = num_task == TVM_PARALLEL_NUM_TASK_SPLITTABLE &&
+        chunks_per_worker_ > 1;
+    if (num_task <= 0) {
       num_task = num_workers_used_;
     }
-    if (need_sync != 0) {
-      CHECK_LE(num_task, num_workers_used_)
-          << "Request parallel sync task larger than number of threads used "
-          << " workers=" << num_workers_used_ << " request=" << num_task;
+    if (work_stealing) {
+      launcher->Init(flambda, cdata, num_task * chunks_per_worker_, false);
+      launcher->InitStealing(num_task);
+      ++num_stealing_launches_;
+    } else {
+      if (need_sync != 0) {
+        CHECK_LE(num_task, num_workers_used_)
+            << "Request parallel sync task larger than number of threads used "
+            << " workers=" << num_workers_used_ << " request=" << num_task;
+      }
+      launcher->Init(flambda, cdata, num_task, need_sync != 0);
     }
-    launcher->Init(flambda, cdata, num_task, need_sync != 0);
     SpscTaskQueue::Task tsk;
     tsk.launcher = launcher;
     // if worker0 is taken by the master, queues_[0] is abandoned
@@ -304,12 +458,7 @@ class ThreadPool {
     }
     // use the master thread to run task 0
     if (exclude_worker0_) {
-      TVMParallelGroupEnv* penv = &(tsk.launcher->env);
-      if ((*tsk.launcher->flambda)(0, penv, cdata) == 0) {
-        tsk.launcher->SignalJobFinish();
-      } else {
-        tsk.launcher->SignalJobError(tsk.task_id);
-      }
+      launcher->RunTask(0);
     }
     int res = launcher->WaitForJobs();
     return res;
@@ -319,16 +468,36 @@ class ThreadPool {
     return dmlc::ThreadLocalStore<ThreadPool>::Get();
   }
 
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads,
+                                 int core_offset = 0) {
     // this will also reset the affinity of the ThreadGroup
     // may use less than the MaxConcurrency number of workers
     num_workers_used_ = threads_->Configure(mode, nthreads,
-                                            exclude_worker0_);
+                                            exclude_worker0_, core_offset);
     // if MaxConcurrency restricted the number of workers (e.g., due to
     // hyperthreading), respect the restriction
     num_workers_used_ = std::min(num_workers_, num_workers_used_);
   }
 
+  static int InitialNumWorkers() {
+    int max_concurrency = tvm::runtime::threading::MaxConcurrency();
+    int num_workers = ThreadPoolSize::ThreadLocal()->num_workers;
+    return num_workers > 0 ? std::min(num_workers, max_concurrency) : max_concurrency;
+  }
+
+  void UpdateNumaNode(int node, int nthreads) {
+    // binds the workers and the master thread to the cpus of the node
+    num_workers_used_ = threads_->ConfigureNumaNode(node, nthreads, exclude_worker0_);
+  }
+
+  void UpdateWorkStealing(int chunks_per_worker) {
+    chunks_per_worker_ = std::max(chunks_per_worker, 1);
+  }
+
+  int64_t NumStealingLaunches() const {
+    return num_stealing_launches_;
+  }
+
  private:
   // Internal worker function.
   void RunWorker(int worker_id) {
@@ -337,13 +506,7 @@ class ThreadPool {
     ParallelLauncher::ThreadLocal()->is_worker = true;
     while (queue->Pop(&task)) {
       CHECK(task.launcher != nullptr);
-      TVMParallelGroupEnv* penv = &(task.launcher->env);
-      void* cdata = task.launcher->cdata;
-      if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
-        task.launcher->SignalJobFinish();
-      } else {
-        task.launcher->SignalJobError(task.task_id);
-      }
+      task.launcher->RunTask(task.task_id);
     }
   }
   int num_workers_;
@@ -355,6 +518,11 @@ class ThreadPool {
 #else
   bool exclude_worker0_{false};
 #endif
+  // number of chunks each worker's share of a parallel loop is split into,
+  // work stealing between workers is enabled when it is larger than 1.
+  int chunks_per_worker_{1};
+  // number of launches that ran in work-stealing mode.
+  int64_t num_stealing_launches_{0};
   std::vector<std::unique_ptr<SpscTaskQueue> > queues_;
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
@@ -365,7 +533,47 @@ TVM_REGISTER_GLOBAL("runtime.config_threadpool")
     static_cast<threading::ThreadGroup::AffinityMode>(\
     static_cast<int>(args[0]));
     int nthreads = args[1];
-    ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
+    // the optional core offset lets the pools of different threads bind to
+    // disjoint cores.
+    int core_offset = args.num_args > 2 ? args[2].operator int() : 0;
+    ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads, core_offset);
+});
+
+// Bind the pool of the calling thread to a NUMA node, and allocate the CPU
+// memory requested from this thread on the node, arguments: node, nthreads.
+// A negative node restores the default configuration.
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_numa")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int node = args[0];
+    int nthreads = args.num_args > 1 ? args[1].operator int() : 0;
+    if (node < 0) {
+      ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(
+          threading::ThreadGroup::kBig, nthreads);
+      threading::SetNumaNode(-1);
+    } else {
+      ThreadPool::ThreadLocal()->UpdateNumaNode(node, nthreads);
+      threading::SetNumaNode(node);
+    }
+});
+
+// Set the number of workers of the pool of the calling thread, must be
+// called before the thread's first parallel launch.
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_size")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    ThreadPoolSize::ThreadLocal()->num_workers = args[0];
+});
+
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_work_stealing")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int chunks_per_worker = args[0];
+    ThreadPool::ThreadLocal()->UpdateWorkStealing(chunks_per_worker);
+});
+
+// Get the number of launches of the calling thread that ran in
+// work-stealing mode.
+TVM_REGISTER_GLOBAL("runtime.threadpool_work_stealing_launches")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    *rv = ThreadPool::ThreadLocal()->NumStealingLaunches();
 });
 
 
@@ -384,14 +592,23 @@ int TVMBackendParallelLaunch(
 
 int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
   using tvm::runtime::kSyncStride;
+  // This is called from generated code, report errors instead of throwing.
+  if (penv->sync_handle == nullptr) {
+    TVMAPISetLastError("Parallel barrier is called in a launch without sync");
+    return -1;
+  }
   int num_task = penv->num_task;
   std::atomic<int>* sync_counter =
       reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
-  int old_counter = sync_counter[task_id * kSyncStride].fetch_add(
+  if (sync_counter[0].load(std::memory_order_relaxed) & tvm::runtime::kSyncNoBarrier) {
+    TVMAPISetLastError("Parallel barrier is not supported in work-stealing mode");
+    return -1;
+  }
+  int old_counter = sync_counter[(task_id + 1) * kSyncStride].fetch_add(
       1, std::memory_order_release);
   for (int i = 0; i < num_task; ++i) {
     if (i != task_id) {
-      while (sync_counter[i * kSyncStride].load(
+      while (sync_counter[(i + 1) * kSyncStride].load(
                  std::memory_order_relaxed) <= old_counter) {
         tvm::runtime::threading::Yield();
       }
@@ -24,8 +24,11 @@
  */
 #include <tvm/runtime/threading_backend.h>
 #include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
 #include <thread>
 #include <algorithm>
+#include <string>
+#include <utility>
 #if defined(__linux__) || defined(__ANDROID__)
 #include <fstream>
 #include <sstream>
@@ -60,7 +63,7 @@ class ThreadGroup::Impl {
     }
   }
 
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int core_offset) {
     int num_workers_used = 0;
     if (mode == kLittle) {
       num_workers_used = little_count_;
@@ -84,7 +87,7 @@ class ThreadGroup::Impl {
     if (val == nullptr || atoi(val) == 1) {
       // Do not set affinity if there are more workers than found cores
       if (sorted_order_.size() >= static_cast<unsigned int>(num_workers_)) {
-          SetAffinity(exclude_worker0, mode == kLittle);
+          SetAffinity(exclude_worker0, mode == kLittle, core_offset);
       } else {
         LOG(WARNING)
           << "The thread affinity cannot be set when the number of workers"
@@ -94,11 +97,47 @@ class ThreadGroup::Impl {
     return num_workers_used;
   }
 
+  int ConfigureNumaNode(int node, int nthreads, bool exclude_worker0) {
+    const std::vector<unsigned>& cpus = NumaNodeCpus(node);
+    int num_workers_used = nthreads;
+    if (num_workers_used == 0) {
+      num_workers_used = std::max(MaxConcurrency() / NumaNodeCount(), 1);
+    }
+    num_workers_used = std::min(num_workers_, num_workers_used);
+    const char *val = getenv("TVM_BIND_THREADS");
+    if (val == nullptr || atoi(val) == 1) {
+      // The cpus of a node list one thread of each physical core first, so
+      // that workers only share a core once every core has one.
+      std::vector<unsigned> cores;
+      for (int i = 0; i < num_workers_; ++i) {
+        cores.push_back(cpus[i % cpus.size()]);
+      }
+      BindToCores(cores, exclude_worker0);
+    }
+    return num_workers_used;
+  }
+
  private:
   // bind worker threads to disjoint cores
   // if worker 0 is offloaded to master, i.e. exclude_worker0 is true,
   // the master thread is bound to core 0.
-  void SetAffinity(bool exclude_worker0, bool reverse = false) {
+  // core_offset shifts the cores used, wrapping around the sorted order.
+  void SetAffinity(bool exclude_worker0, bool reverse = false, int core_offset = 0) {
+#if defined(__linux__) || defined(__ANDROID__)
+    CHECK_GE(sorted_order_.size(), num_workers_);
+#endif
+    const size_t num_cores = sorted_order_.size();
+    std::vector<unsigned> cores;
+    for (int i = 0; i < num_workers_; ++i) {
+      size_t pos = (core_offset + i) % num_cores;
+      cores.push_back(reverse ? sorted_order_[num_cores - pos - 1] : sorted_order_[pos]);
+    }
+    BindToCores(cores, exclude_worker0);
+  }
+
+  // bind worker i to cores[i], the master thread takes cores[0]
+  // if exclude_worker0 is true.
+  void BindToCores(const std::vector<unsigned>& cores, bool exclude_worker0) {
 #if defined(__ANDROID__)
 #ifndef CPU_SET
 #define CPU_SETSIZE 1024
@@ -114,18 +153,10 @@ class ThreadGroup::Impl {
 #endif
 #endif
 #if defined(__linux__) || defined(__ANDROID__)
-    CHECK_GE(sorted_order_.size(), num_workers_);
-
     for (unsigned i = 0; i < threads_.size(); ++i) {
-      unsigned core_id;
-      if (reverse) {
-        core_id = sorted_order_[sorted_order_.size() - (i + exclude_worker0) - 1];
-      } else {
-        core_id = sorted_order_[i + exclude_worker0];
-      }
       cpu_set_t cpuset;
       CPU_ZERO(&cpuset);
-      CPU_SET(core_id, &cpuset);
+      CPU_SET(cores[i + exclude_worker0], &cpuset);
 #if defined(__ANDROID__)
       sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
 #else
@@ -133,14 +164,10 @@ class ThreadGroup::Impl {
           sizeof(cpu_set_t), &cpuset);
 #endif
     }
-    if (exclude_worker0) {  // bind the master thread to core 0
+    if (exclude_worker0) {  // bind the master thread to the first core
       cpu_set_t cpuset;
       CPU_ZERO(&cpuset);
-      if (reverse) {
-        CPU_SET(sorted_order_[sorted_order_.size() - 1], &cpuset);
-      } else {
-        CPU_SET(sorted_order_[0], &cpuset);
-      }
+      CPU_SET(cores[0], &cpuset);
 #if defined(__ANDROID__)
       sched_setaffinity(pthread_self(),
         sizeof(cpu_set_t), &cpuset);
@@ -207,8 +234,13 @@ ThreadGroup::ThreadGroup(int num_workers,
 ThreadGroup::~ThreadGroup() { delete impl_; }
 void ThreadGroup::Join() { impl_->Join(); }
 
-int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
-  return impl_->Configure(mode, nthreads, exclude_worker0);
+int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                           int core_offset) {
+  return impl_->Configure(mode, nthreads, exclude_worker0, core_offset);
+}
+
+int ThreadGroup::ConfigureNumaNode(int node, int nthreads, bool exclude_worker0) {
+  return impl_->ConfigureNumaNode(node, nthreads, exclude_worker0);
 }
 
 void Yield() {
@@ -233,6 +265,113 @@ int MaxConcurrency() {
 }
 
 
+// Parse a sysfs cpu list such as "0-3,8-11".
+static std::vector<unsigned> ParseCpuList(const std::string& list) {
+  std::vector<unsigned> cpus;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) end = list.size();
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    unsigned first = static_cast<unsigned>(atoi(range.c_str()));
+    unsigned last = dash == std::string::npos ?
+        first : static_cast<unsigned>(atoi(range.c_str() + dash + 1));
+    for (unsigned cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    pos = end + 1;
+  }
+  return cpus;
+}
+
+// Order cpus so that one hardware thread of every physical core comes
+// before any second sibling. Cpu ids say nothing about the topology, the
+// siblings of cpu 0 may be cpu 1 or cpu N/2, so the siblings are read from
+// sysfs. A cpu's rank is its position among its siblings.
+static std::vector<unsigned> CoresFirst(const std::vector<unsigned>& cpus) {
+  std::vector<std::pair<unsigned, unsigned> > ranked;
+  for (unsigned cpu : cpus) {
+    unsigned rank = 0;
+#if defined(__linux__)
+    std::ostringstream path;
+    path << "/sys/devices/system/cpu/cpu" << cpu << "/topology/thread_siblings_list";
+    std::ifstream ifs(path.str());
+    std::string list;
+    if (ifs >> list) {
+      std::vector<unsigned> siblings = ParseCpuList(list);
+      rank = static_cast<unsigned>(
+          std::find(siblings.begin(), siblings.end(), cpu) - siblings.begin());
+      if (rank == siblings.size()) rank = 0;
+    }
+#endif
+    ranked.push_back(std::make_pair(rank, cpu));
+  }
+  std::stable_sort(ranked.begin(), ranked.end(),
+                   [](const std::pair<unsigned, unsigned>& a,
+                      const std::pair<unsigned, unsigned>& b) {
+                     return a.first < b.first;
+                   });
+  std::vector<unsigned> ordered;
+  for (const auto& p : ranked) {
+    ordered.push_back(p.second);
+  }
+  return ordered;
+}
+
+// The cpus of each NUMA node, a single node holding all cpus when the
+// topology is unknown. Nodes are assumed to be numbered contiguously.
+static const std::vector<std::vector<unsigned> >& NumaTopology() {
+  static std::vector<std::vector<unsigned> > nodes = []() {
+    std::vector<std::vector<unsigned> > nodes;
+#if defined(__linux__)
+    while (true) {
+      std::ostringstream path;
+      path << "/sys/devices/system/node/node" << nodes.size() << "/cpulist";
+      std::ifstream ifs(path.str());
+      if (ifs.fail()) break;
+      std::string list;
+      ifs >> list;
+      nodes.push_back(CoresFirst(ParseCpuList(list)));
+    }
+#endif
+    if (nodes.empty()) {
+      std::vector<unsigned> cpus;
+      for (unsigned i = 0; i < std::thread::hardware_concurrency(); ++i) {
+        cpus.push_back(i);
+      }
+      nodes.push_back(cpus);
+    }
+    return nodes;
+  }();
+  return nodes;
+}
+
+int NumaNodeCount() {
+  return static_cast<int>(NumaTopology().size());
+}
+
+const std::vector<unsigned>& NumaNodeCpus(int node) {
+  const auto& nodes = NumaTopology();
+  CHECK(node >= 0 && node < static_cast<int>(nodes.size()))
+      << "Invalid NUMA node " << node << ", the system has " << nodes.size();
+  CHECK(!nodes[node].empty()) << "NUMA node " << node << " has no cpus";
+  return nodes[node];
+}
+
+struct NumaNodeEntry {
+  int node{-1};
+};
+
+void SetNumaNode(int node) {
+  CHECK(node >= -1 && node < NumaNodeCount()) << "Invalid NUMA node " << node;
+  dmlc::ThreadLocalStore<NumaNodeEntry>::Get()->node = node;
+}
+
+int GetNumaNode() {
+  return dmlc::ThreadLocalStore<NumaNodeEntry>::Get()->node;
+}
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
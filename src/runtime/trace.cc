@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file trace.cc
+ * \brief Per-thread event buffers of the runtime timeline trace.
+ */
+#include <dmlc/logging.h>
+#include <dmlc/thread_local.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "trace.h"
+
+namespace tvm {
+namespace runtime {
+namespace trace {
+
+std::atomic<bool> enabled{false};
+
+namespace {
+
+constexpr size_t kMaxNameLength = 63;
+
+struct Event {
+  const char* category;
+  char name[kMaxNameLength + 1];
+  int64_t begin_ns;
+  int64_t end_ns;
+  int64_t bytes;
+};
+
+/*!
+ * \brief The event buffer of one thread. Only the owning thread writes it,
+ *  it publishes the events through size.
+ */
+struct ThreadBuffer {
+  std::vector<Event> events;
+  std::atomic<size_t> size{0};
+  /*! \brief The trace the events belong to. */
+  std::atomic<uint64_t> generation{0};
+  size_t dropped{0};
+  int tid{0};
+};
+
+/*! \brief The trace settings and the buffers of all threads that recorded an event. */
+struct TraceState {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer> > buffers;
+  std::atomic<uint64_t> generation{0};
+  std::atomic<size_t> capacity{0};
+  std::chrono::steady_clock::time_point epoch{std::chrono::steady_clock::now()};
+
+  static TraceState* Global() {
+    static TraceState inst;
+    return &inst;
+  }
+};
+
+/*! \brief The buffer of the calling thread, which the trace state keeps alive. */
+struct ThreadBufferEntry {
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+ThreadBuffer* GetThreadBuffer() {
+  TraceState* reg = TraceState::Global();
+  std::shared_ptr<ThreadBuffer>& buffer =
+      dmlc::ThreadLocalStore<ThreadBufferEntry>::Get()->buffer;
+  if (buffer == nullptr) {
+    buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    buffer->tid = static_cast<int>(reg->buffers.size()) + 1;
+    reg->buffers.push_back(buffer);
+  }
+  uint64_t generation = reg->generation.load(std::memory_order_acquire);
+  if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+    // first event of this thread in a new trace
+    buffer->events.resize(reg->capacity.load(std::memory_order_relaxed));
+    buffer->size.store(0, std::memory_order_relaxed);
+    buffer->dropped = 0;
+    buffer->generation.store(generation, std::memory_order_release);
+  }
+  return buffer.get();
+}
+
+void WriteEscaped(std::ostream& os, const char* str) {
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      os << '\\' << *str;
+    } else if (static_cast<unsigned char>(*str) >= 0x20) {
+      os << *str;
+    }
+  }
+}
+
+}  // namespace
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - TraceState::Global()->epoch).count();
+}
+
+void Record(const char* category, const char* name, size_t name_len,
+            int64_t begin_ns, int64_t end_ns, int64_t bytes) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  size_t size = buffer->size.load(std::memory_order_relaxed);
+  if (size == buffer->events.size()) {
+    ++buffer->dropped;
+    return;
+  }
+  Event& event = buffer->events[size];
+  event.category = category;
+  name_len = std::min(name_len, kMaxNameLength);
+  memcpy(event.name, name, name_len);
+  event.name[name_len] = '\0';
+  event.begin_ns = begin_ns;
+  event.end_ns = end_ns;
+  event.bytes = bytes;
+  buffer->size.store(size + 1, std::memory_order_release);
+}
+
+void Start(size_t events_per_thread) {
+  CHECK_GT(events_per_thread, 0U);
+  TraceState* reg = TraceState::Global();
+  reg->capacity.store(events_per_thread, std::memory_order_relaxed);
+  reg->generation.fetch_add(1, std::memory_order_release);
+  enabled.store(true, std::memory_order_release);
+}
+
+void Stop() {
+  enabled.store(false, std::memory_order_release);
+}
+
+std::string DumpJSON() {
+  TraceState* reg = TraceState::Global();
+  uint64_t generation = reg->generation.load(std::memory_order_acquire);
+  std::ostringstream os;
+  os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first = true;
+  size_t dropped = 0;
+  std::lock_guard<std::mutex> lock(reg->mutex);
+  for (const auto& buffer : reg->buffers) {
+    if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+    size_t size = buffer->size.load(std::memory_order_acquire);
+    dropped += buffer->dropped;
+    for (size_t i = 0; i < size; ++i) {
+      const Event& event = buffer->events[i];
+      // Chrome trace timestamps are in microseconds.
+      os << (first ? "" : ", ") << "{\"name\": \"";
+      WriteEscaped(os, event.name);
+      os << "\", \"cat\": \"" << event.category << "\", \"ph\": \"X\""
+         << ", \"ts\": " << event.begin_ns / 1000.0
+         << ", \"dur\": " << (event.end_ns - event.begin_ns) / 1000.0
+         << ", \"pid\": 1, \"tid\": " << buffer->tid;
+      if (event.bytes >= 0) {
+        os << ", \"args\": {\"bytes\": " << event.bytes << "}";
+      }
+      os << "}";
+      first = false;
+    }
+  }
+  os << "], \"otherData\": {\"dropped_events\": " << dropped << "}}";
+  return os.str();
+}
+
+TVM_REGISTER_GLOBAL("runtime.trace_start")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int64_t events_per_thread = args.num_args > 0 ? args[0].operator int64_t() : 1 << 16;
+    Start(static_cast<size_t>(events_per_thread));
+  });
+
+TVM_REGISTER_GLOBAL("runtime.trace_stop")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    Stop();
+  });
+
+// Returns the JSON, and also writes it to the file given as argument.
+TVM_REGISTER_GLOBAL("runtime.trace_dump")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    std::string json = DumpJSON();
+    if (args.num_args > 0) {
+      std::string path = args[0];
+      std::ofstream fs(path);
+      CHECK(fs.is_open()) << "Cannot open " << path;
+      fs << json;
+    }
+    *rv = json;
+  });
+
+}  // namespace trace
+}  // namespace runtime
+}  // namespace tvm
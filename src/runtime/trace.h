@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file trace.h
+ * \brief Opt-in timeline tracing of the runtime, dumped as Chrome trace JSON.
+ *
+ *  Every thread records its events into a buffer of its own, so recording
+ *  takes no lock. When tracing is off a Scope only loads one atomic flag.
+ */
+#ifndef TVM_RUNTIME_TRACE_H_
+#define TVM_RUNTIME_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace tvm {
+namespace runtime {
+namespace trace {
+
+/*! \brief Whether tracing is on, use Enabled() to check it. */
+extern std::atomic<bool> enabled;
+
+/*! \return Whether tracing is on. */
+inline bool Enabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+/*! \return The time since the trace clock started, in nanoseconds. */
+int64_t NowNs();
+
+/*!
+ * \brief Record a complete event into the buffer of the calling thread.
+ * \param category The category, must be a string literal.
+ * \param name The name of the event, copied and truncated if long.
+ * \param name_len The length of the name.
+ * \param begin_ns The begin time.
+ * \param end_ns The end time.
+ * \param bytes The bytes the event touched, -1 if not applicable.
+ */
+void Record(const char* category, const char* name, size_t name_len,
+            int64_t begin_ns, int64_t end_ns, int64_t bytes);
+
+/*!
+ * \brief Start tracing, dropping the events of the previous trace.
+ * \param events_per_thread The capacity of the buffer of each thread, later
+ *  events of a thread whose buffer is full are dropped.
+ */
+void Start(size_t events_per_thread);
+
+/*! \brief Stop tracing. */
+void Stop();
+
+/*!
+ * \brief Get the events of the last trace as Chrome trace JSON, which can be
+ *  loaded into chrome://tracing or Perfetto. Call it after Stop.
+ * \return The JSON string.
+ */
+std::string DumpJSON();
+
+/*!
+ * \brief Record the lifetime of the scope as an event when tracing is on.
+ *
+ *  The name is not copied before the scope ends and must outlive it.
+ */
+class Scope {
+ public:
+  Scope(const char* category, const char* name, int64_t bytes = -1)
+      : Scope(category, name, Enabled() ? strlen(name) : 0, bytes) {}
+  Scope(const char* category, const std::string& name, int64_t bytes = -1)
+      : Scope(category, name.c_str(), name.length(), bytes) {}
+  Scope(const char* category, const char* name, size_t name_len, int64_t bytes)
+      : category_(category), name_(name), name_len_(name_len), bytes_(bytes) {
+    if (Enabled()) begin_ns_ = NowNs();
+  }
+  ~Scope() {
+    if (begin_ns_ >= 0 && Enabled()) {
+      Record(category_, name_, name_len_, begin_ns_, NowNs(), bytes_);
+    }
+  }
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  const char* category_;
+  const char* name_;
+  size_t name_len_;
+  int64_t bytes_;
+  int64_t begin_ns_{-1};
+};
+
+}  // namespace trace
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_TRACE_H_
@@ -0,0 +1,305 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file src/runtime/vm/executable.cc
+ * \brief Serialization of virtual machine executables.
+ */
+
+#include <dmlc/memory_io.h>
+#include <tvm/logging.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/serializer.h>
+#include <tvm/runtime/vm.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../file_util.h"
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+/*! \brief Magic number of a serialized executable. */
+constexpr uint64_t kTVMVMExecutableMagic = 0xD225DE2F4214151D;
+/*! \brief Version of the executable format. */
+constexpr uint64_t kTVMVMExecutableVersion = 1;
+/*! \brief Alignment of the constant section, so it starts on a page. */
+constexpr size_t kConstantSectionAlign = 4096;
+
+/*
+ * An executable is laid out as:
+ *
+ *   uint64 magic, uint64 version, uint64 metadata size
+ *   metadata: packed function names, the global map, the functions'
+ *             bytecode and a table of the constants' shape, dtype,
+ *             offset and size
+ *   padding up to a page
+ *   constant data, each aligned to kAllocAlignment
+ *
+ * Constant offsets are relative to the start of the constant section,
+ * so that loading can point the constants straight into a mapping.
+ */
+
+inline size_t AlignUp(size_t value, size_t align) {
+  return (value + align - 1) / align * align;
+}
+
+void VirtualMachine::Save(const std::string& file_name) const {
+  DLContext cpu_ctx;
+  cpu_ctx.device_type = kDLCPU;
+  cpu_ctx.device_id = 0;
+  CHECK_EQ(packed_funcs.size(), packed_func_names.size())
+      << "The names of the packed functions are required to save the executable";
+
+  std::vector<NDArray> arrays;
+  for (Object obj : constants) {
+    CHECK(obj->tag == ObjectTag::kTensor) << "Only tensor constants can be saved";
+    NDArray array = ToNDArray(obj);
+    if (array->ctx.device_type != kDLCPU) array = array.CopyTo(cpu_ctx);
+    CHECK(array->strides == nullptr) << "Only compact constants can be saved";
+    arrays.push_back(array);
+  }
+
+  std::string metadata;
+  dmlc::MemoryStringStream writer(&metadata);
+  dmlc::Stream* strm = &writer;
+  strm->Write(packed_func_names);
+  std::vector<std::pair<Index, std::string>> globals;
+  for (const auto& kv : global_map_) globals.emplace_back(kv.second, kv.first);
+  std::sort(globals.begin(), globals.end());
+  std::vector<std::string> global_names;
+  std::vector<Index> global_indices;
+  for (const auto& g : globals) {
+    global_indices.push_back(g.first);
+    global_names.push_back(g.second);
+  }
+  strm->Write(global_names);
+  strm->Write(global_indices);
+  uint64_t num_functions = functions.size();
+  strm->Write(num_functions);
+  for (const auto& func : functions) {
+    strm->Write(func.name);
+    strm->Write(func.params);
+    strm->Write(func.register_file_size);
+    strm->Write(func.bytecode);
+  }
+  uint64_t num_constants = arrays.size();
+  strm->Write(num_constants);
+  uint64_t offset = 0;
+  for (const auto& array : arrays) {
+    uint64_t nbytes = GetDataSize(*array.operator->());
+    offset = AlignUp(offset, kAllocAlignment);
+    strm->Write(array->dtype);
+    strm->Write(std::vector<int64_t>(array->shape, array->shape + array->ndim));
+    strm->Write(offset);
+    strm->Write(nbytes);
+    offset += nbytes;
+  }
+
+  std::ofstream fs(file_name, std::ios::out | std::ios::binary);
+  CHECK(!fs.fail()) << "Cannot open " << file_name;
+  uint64_t header[3] = {kTVMVMExecutableMagic, kTVMVMExecutableVersion, metadata.size()};
+  fs.write(reinterpret_cast<const char*>(header), sizeof(header));
+  fs.write(metadata.data(), metadata.size());
+  size_t pos = sizeof(header) + metadata.size();
+  std::string padding(kConstantSectionAlign, '\0');
+  fs.write(padding.data(), AlignUp(pos, kConstantSectionAlign) - pos);
+  pos = 0;
+  for (const auto& array : arrays) {
+    size_t aligned = AlignUp(pos, kAllocAlignment);
+    fs.write(padding.data(), aligned - pos);
+    size_t nbytes = GetDataSize(*array.operator->());
+    fs.write(static_cast<const char*>(array->data) + array->byte_offset, nbytes);
+    pos = aligned + nbytes;
+  }
+  CHECK(!fs.fail()) << "Failed to write " << file_name;
+}
+
+/*!
+ * \brief Check the indices into the functions, constants and operators of a
+ *  loaded executable, which are only known once every table is read.
+ */
+static void CheckTableIndices(const VirtualMachine& vm, const std::string& file_name) {
+  Index num_functions = static_cast<Index>(vm.functions.size());
+  Index num_constants = static_cast<Index>(vm.constants.size());
+  Index num_packed = static_cast<Index>(vm.packed_funcs.size());
+  for (const auto& kv : vm.global_map_) {
+    CHECK(kv.second >= 0 && kv.second < num_functions)
+        << "Invalid index of global " << kv.first << " in " << file_name;
+  }
+  for (const VMFunction& func : vm.functions) {
+    for (const Instruction& instr : func.instructions) {
+      Index index = 0, size = 0;
+      switch (instr.op) {
+        case Opcode::Invoke:
+          index = instr.func_index;
+          size = num_functions;
+          break;
+        case Opcode::AllocClosure:
+          index = instr.clo_index;
+          size = num_functions;
+          break;
+        case Opcode::LoadConst:
+          index = instr.const_index;
+          size = num_constants;
+          break;
+        case Opcode::InvokePacked:
+          index = instr.packed_index;
+          size = num_packed;
+          break;
+        default:
+          continue;
+      }
+      CHECK(index >= 0 && index < size)
+          << "Index " << index << " out of range in " << func.name << " of " << file_name;
+    }
+  }
+}
+
+VirtualMachine VirtualMachine::Load(const std::string& file_name, const Module& lib) {
+  std::shared_ptr<MappedFile> file = MappedFile::Open(file_name);
+  dmlc::MemoryFixedSizeStream reader(file->data(), file->size());
+  dmlc::Stream* strm = &reader;
+  uint64_t header[3];
+  CHECK_EQ(strm->Read(header, sizeof(header)), sizeof(header))
+      << file_name << " is not a VM executable";
+  CHECK_EQ(header[0], kTVMVMExecutableMagic) << file_name << " is not a VM executable";
+  CHECK_EQ(header[1], kTVMVMExecutableVersion)
+      << "Unsupported VM executable version " << header[1];
+  size_t data_start = AlignUp(sizeof(header) + header[2], kConstantSectionAlign);
+  CHECK_LE(data_start, AlignUp(file->size(), kConstantSectionAlign))
+      << "Truncated VM executable " << file_name;
+
+  VirtualMachine vm;
+  vm.lib = lib;
+  CHECK(strm->Read(&vm.packed_func_names)) << "Invalid VM executable " << file_name;
+  if (!vm.packed_func_names.empty()) {
+    CHECK(lib.operator->() != nullptr) << "The executable calls compiled operators, a library is required";
+  }
+  for (const auto& name : vm.packed_func_names) {
+    PackedFunc pf = vm.lib.GetFunction(name, true);
+    CHECK(pf != nullptr) << "Cannot find operator " << name << " in the library";
+    vm.packed_funcs.push_back(pf);
+  }
+
+  std::vector<std::string> global_names;
+  std::vector<Index> global_indices;
+  CHECK(strm->Read(&global_names)) << "Invalid VM executable " << file_name;
+  CHECK(strm->Read(&global_indices)) << "Invalid VM executable " << file_name;
+  CHECK_EQ(global_names.size(), global_indices.size());
+  for (size_t i = 0; i < global_names.size(); ++i) {
+    vm.global_map_[global_names[i]] = global_indices[i];
+  }
+
+  uint64_t num_functions;
+  CHECK(strm->Read(&num_functions)) << "Invalid VM executable " << file_name;
+  for (uint64_t i = 0; i < num_functions; ++i) {
+    std::string name;
+    Index params, register_file_size;
+    std::vector<Index> bytecode;
+    CHECK(strm->Read(&name) && strm->Read(&params) && strm->Read(&register_file_size) &&
+          strm->Read(&bytecode)) << "Invalid VM executable " << file_name;
+    vm.functions.push_back(
+        VMFunction::FromBytecode(name, params, bytecode, register_file_size));
+  }
+
+  uint64_t num_constants;
+  CHECK(strm->Read(&num_constants)) << "Invalid VM executable " << file_name;
+  for (uint64_t i = 0; i < num_constants; ++i) {
+    DLDataType dtype;
+    std::vector<int64_t> shape;
+    uint64_t offset, nbytes;
+    CHECK(strm->Read(&dtype) && strm->Read(&shape) && strm->Read(&offset) && strm->Read(&nbytes))
+        << "Invalid VM executable " << file_name;
+    NDArray array = MappedNDArray(file, data_start + offset, shape, dtype);
+    CHECK_EQ(GetDataSize(*array.operator->()), nbytes) << "Invalid VM executable " << file_name;
+    vm.constants.push_back(Object::Tensor(array));
+  }
+  CheckTableIndices(vm, file_name);
+  return vm;
+}
+
+/*!
+ * \brief A runtime module running a loaded executable.
+ *
+ *  The virtual machine keeps its state between calls, so a module must
+ *  not be invoked from several threads at once.
+ */
+class VirtualMachineModuleNode : public ModuleNode {
+ public:
+  explicit VirtualMachineModuleNode(VirtualMachine vm) : vm_(std::move(vm)) {}
+
+  const char* type_key() const final {
+    return "VirtualMachine";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const std::shared_ptr<ModuleNode>& sptr_to_self) final {
+    if (name == "invoke") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          std::string func_name = args[0];
+          CHECK(vm_.global_map_.count(func_name)) << "Cannot find function " << func_name;
+          std::vector<Object> vm_args;
+          for (int i = 1; i < args.num_args; ++i) {
+            if (args[i].type_code() == kNDArrayContainer) {
+              vm_args.push_back(Object::Tensor(args[i].operator NDArray()));
+            } else {
+              vm_args.push_back(args[i].operator Object());
+            }
+          }
+          Object result = vm_.Invoke(func_name, vm_args);
+          if (result->tag == ObjectTag::kTensor) {
+            *rv = ToNDArray(result);
+          } else {
+            *rv = result;
+          }
+        });
+    } else {
+      return PackedFunc();
+    }
+  }
+
+ private:
+  VirtualMachine vm_;
+};
+
+TVM_REGISTER_GLOBAL("relay._vm._load_executable")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    std::string file_name = args[0];
+    Module lib;
+    if (args[1].type_code() != kNull) lib = args[1];
+    TVMContext ctx;
+    int dev_type = args[2];
+    ctx.device_type = static_cast<DLDeviceType>(dev_type);
+    ctx.device_id = args[3];
+    VirtualMachine vm = VirtualMachine::Load(file_name, lib);
+    vm.Init({ctx});
+    *rv = Module(std::make_shared<VirtualMachineModuleNode>(std::move(vm)));
+  });
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
@@ -22,8 +22,10 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <cstdlib>
 #include <utility>
 #include <memory>
+#include <string>
 #include "memory_manager.h"
 #include "naive_allocator.h"
 #include "pooled_allocator.h"
@@ -51,8 +53,10 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
 }
 
 MemoryManager* MemoryManager::Global() {
-  static MemoryManager memory_manager;
-  return &memory_manager;
+  // Intentionally leaked, so that cached buffers are not released after
+  // the device APIs are destroyed at exit.
+  static MemoryManager* memory_manager = new MemoryManager();
+  return memory_manager;
 }
 
 Allocator* MemoryManager::GetAllocator(TVMContext ctx) {
@@ -60,7 +64,18 @@ Allocator* MemoryManager::GetAllocator(TVMContext ctx) {
   if (allocators_.find(ctx) == allocators_.end()) {
     DLOG(INFO) << "New allocator for " << DeviceName(ctx.device_type) << "("
                << ctx.device_id << ")";
-    std::unique_ptr<Allocator> alloc(new NaiveAllocator(ctx));
+    // TVM_VM_ALLOCATOR=naive frees every buffer right away, the default
+    // pooled allocator caches them, under TVM_VM_MEMORY_LIMIT bytes if set.
+    const char* kind = getenv("TVM_VM_ALLOCATOR");
+    std::unique_ptr<Allocator> alloc;
+    if (kind != nullptr && std::string(kind) == "naive") {
+      alloc.reset(new NaiveAllocator(ctx));
+    } else {
+      const char* limit = getenv("TVM_VM_MEMORY_LIMIT");
+      size_t memory_limit = limit == nullptr ? 0 : std::strtoull(limit, nullptr, 10);
+      alloc.reset(new PooledAllocator(
+          ctx, PooledAllocator::kDefaultPageSize, memory_limit));
+    }
     allocators_.emplace(ctx, std::move(alloc));
   }
   return allocators_.at(ctx).get();
@@ -25,9 +25,10 @@
 #define TVM_RUNTIME_VM_POOLED_ALLOCATOR_H_
 
 #include <tvm/runtime/device_api.h>
+#include <algorithm>
 #include <atomic>
+#include <exception>
 #include <mutex>
-#include <unordered_map>
 #include <vector>
 
 #include "memory_manager.h"
@@ -36,64 +37,132 @@ namespace tvm {
 namespace runtime {
 namespace vm {
 
+/*!
+ * \brief Allocator that caches freed buffers in power-of-two buckets.
+ *
+ *  Requests are rounded up to a power-of-two number of pages, so that a
+ *  cached buffer can be reused by any request of the same bucket, e.g. by
+ *  tensors of different sequence lengths. Each bucket has its own lock.
+ *  When a memory limit is set, cached buffers are released, largest first,
+ *  to keep the memory held by the allocator under the limit.
+ */
 class PooledAllocator final : public Allocator {
  public:
   static constexpr size_t kDefaultPageSize = 4096;
+  static constexpr int kNumBuckets = 48;
 
-  explicit PooledAllocator(TVMContext ctx, size_t page_size = kDefaultPageSize)
-      : Allocator(), page_size_(page_size), used_memory_(0) {}
+  /*!
+   * \brief Create the allocator.
+   * \param ctx The context to allocate on.
+   * \param page_size The size of the smallest bucket.
+   * \param memory_limit The maximum bytes held by the allocator, 0 for no limit.
+   */
+  explicit PooledAllocator(TVMContext ctx,
+                           size_t page_size = kDefaultPageSize,
+                           size_t memory_limit = 0)
+      : Allocator(), page_size_(page_size), memory_limit_(memory_limit),
+        used_memory_(0), cached_memory_(0), ctx_(ctx) {}
 
   ~PooledAllocator() { ReleaseAll(); }
 
   Buffer Alloc(size_t nbytes, size_t alignment, TVMType type_hint) override {
-    std::lock_guard<std::mutex> lock(mu_);
-    size_t size = ((nbytes + page_size_ - 1) / page_size_) * page_size_;
-    auto&& it = memory_pool_.find(size);
-    if (it != memory_pool_.end() && !it->second.empty()) {
-      auto&& pool = it->second;
-      auto ret = pool.back();
-      pool.pop_back();
-      return ret;
+    int bucket = BucketIndex(nbytes);
+    // reuse a buffer of the bucket, or of the next one to cap the waste at 4x.
+    for (int b = bucket; b < std::min(bucket + 2, static_cast<int>(kNumBuckets)); ++b) {
+      Buffer buf;
+      if (PopCached(b, &buf)) {
+        return buf;
+      }
     }
     Buffer buf;
     buf.ctx = ctx_;
-    buf.size = size;
-    buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, size, alignment, type_hint);
-    used_memory_.fetch_add(size, std::memory_order_relaxed);
-    DLOG(INFO) << "allocate " << size << " B, used memory " << used_memory_ << " B";
+    buf.size = page_size_ << bucket;
+    if (memory_limit_ != 0) {
+      Trim(memory_limit_ > buf.size ? memory_limit_ - buf.size : 0);
+    }
+    try {
+      buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, buf.size, alignment, type_hint);
+    } catch (const std::exception& e) {
+      // out of memory, either a dmlc::Error from the device API or a
+      // std::bad_alloc from the host allocator, retry after releasing
+      // all cached buffers.
+      Trim(0);
+      buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, buf.size, alignment, type_hint);
+    }
+    used_memory_.fetch_add(buf.size, std::memory_order_relaxed);
+    DLOG(INFO) << "allocate " << buf.size << " B, used memory " << used_memory_ << " B";
     return buf;
   }
 
   void Free(const Buffer& buffer) override {
-    std::lock_guard<std::mutex> lock(mu_);
-    if (memory_pool_.find(buffer.size) == memory_pool_.end()) {
-      memory_pool_.emplace(buffer.size, std::vector<Buffer>{});
+    int bucket = BucketIndex(buffer.size);
+    {
+      std::lock_guard<std::mutex> lock(buckets_[bucket].mu);
+      buckets_[bucket].pool.push_back(buffer);
     }
-    memory_pool_.at(buffer.size).push_back(buffer);
+    cached_memory_.fetch_add(buffer.size, std::memory_order_relaxed);
     DLOG(INFO) << "reclaim buffer " << buffer.size;
+    if (memory_limit_ != 0 && UsedMemory() > memory_limit_) {
+      Trim(memory_limit_);
+    }
   }
 
   size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
 
- private:
-  void ReleaseAll() {
-    std::lock_guard<std::mutex> lock(mu_);
-    for (auto const& it : memory_pool_) {
-      auto const& pool = it.second;
-      for (auto const& buf : pool) {
+  /*! \return The bytes held in cached buffers. */
+  size_t CachedMemory() const { return cached_memory_.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Release cached buffers, largest first, until the memory held
+   *  by the allocator is not larger than target.
+   * \param target The target number of bytes.
+   */
+  void Trim(size_t target) {
+    for (int b = kNumBuckets - 1; b >= 0 && UsedMemory() > target; --b) {
+      Buffer buf;
+      while (UsedMemory() > target && PopCached(b, &buf)) {
         DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
+        used_memory_.fetch_sub(buf.size, std::memory_order_relaxed);
       }
     }
-    memory_pool_.clear();
-    used_memory_ = 0;
+  }
+
+ private:
+  /*! \brief Cached buffers of one bucket. */
+  struct Bucket {
+    std::mutex mu;
+    std::vector<Buffer> pool;
+  };
+
+  int BucketIndex(size_t nbytes) const {
+    size_t pages = (nbytes + page_size_ - 1) / page_size_;
+    int bucket = 0;
+    while ((static_cast<size_t>(1) << bucket) < pages) ++bucket;
+    CHECK_LT(bucket, kNumBuckets) << "Allocation of " << nbytes << " B is too large";
+    return bucket;
+  }
+
+  bool PopCached(int bucket, Buffer* buf) {
+    std::lock_guard<std::mutex> lock(buckets_[bucket].mu);
+    auto& pool = buckets_[bucket].pool;
+    if (pool.empty()) return false;
+    *buf = pool.back();
+    pool.pop_back();
+    cached_memory_.fetch_sub(buf->size, std::memory_order_relaxed);
+    return true;
+  }
+
+  void ReleaseAll() {
+    Trim(0);
     DLOG(INFO) << "release all buffers";
   }
 
  private:
   size_t page_size_;
+  size_t memory_limit_;
   std::atomic<size_t> used_memory_;
-  std::unordered_map<size_t, std::vector<Buffer> > memory_pool_;
-  std::mutex mu_;
+  std::atomic<size_t> cached_memory_;
+  Bucket buckets_[kNumBuckets];
   TVMContext ctx_;
 };
 
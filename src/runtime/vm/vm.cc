@@ -30,10 +30,13 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../../runtime/vm/memory_manager.h"
 #include "../../runtime/vm/naive_allocator.h"
+#include "../trace.h"
 
 using namespace tvm::runtime;
 
@@ -111,6 +114,8 @@ Instruction::Instruction(const Instruction& instr) {
     case Opcode::Goto:
       this->pc_offset = instr.pc_offset;
       return;
+    case Opcode::KillRegister:
+      return;
     default:
       std::ostringstream out;
       out << "Invalid instruction " << static_cast<int>(instr.op);
@@ -191,6 +196,8 @@ Instruction& Instruction::operator=(const Instruction& instr) {
     case Opcode::Goto:
       this->pc_offset = instr.pc_offset;
       return *this;
+    case Opcode::KillRegister:
+      return *this;
     default:
       std::ostringstream out;
       out << "Invalid instruction " << static_cast<int>(instr.op);
@@ -208,6 +215,7 @@ Instruction::~Instruction() {
     case Opcode::LoadConst:
     case Opcode::GetField:
     case Opcode::Goto:
+    case Opcode::KillRegister:
       return;
     case Opcode::AllocDatatype:
       delete this->datatype_fields;
@@ -368,6 +376,315 @@ Instruction Instruction::Move(RegName src, RegName dst) {
   return instr;
 }
 
+Instruction Instruction::KillRegister(RegName reg) {
+  Instruction instr;
+  instr.op = Opcode::KillRegister;
+  instr.dst = reg;
+  return instr;
+}
+
+/*! \brief The number of words an instruction takes in the bytecode. */
+static Index EncodedLength(const Instruction& instr) {
+  switch (instr.op) {
+    case Opcode::Move: return 3;
+    case Opcode::Ret: return 2;
+    case Opcode::Invoke: return 4 + instr.num_args;
+    case Opcode::InvokeClosure: return 4 + instr.closure_args_num;
+    case Opcode::InvokePacked: return 4 + instr.arity;
+    case Opcode::AllocTensor: return 4;
+    case Opcode::AllocDatatype: return 4 + instr.num_fields;
+    case Opcode::AllocClosure: return 4 + instr.num_freevar;
+    case Opcode::GetField: return 4;
+    case Opcode::If: return 4;
+    case Opcode::Select: return 5;
+    case Opcode::LoadConst: return 3;
+    case Opcode::Goto: return 2;
+    case Opcode::KillRegister: return 2;
+  }
+  LOG(FATAL) << "Invalid instruction " << static_cast<int>(instr.op);
+  return 0;
+}
+
+static inline Index EncodeDataType(DLDataType dtype) {
+  return static_cast<Index>(dtype.code) | (static_cast<Index>(dtype.bits) << 8) |
+      (static_cast<Index>(dtype.lanes) << 16);
+}
+
+static inline DLDataType DecodeDataType(Index word) {
+  DLDataType dtype;
+  dtype.code = static_cast<uint8_t>(word & 0xFF);
+  dtype.bits = static_cast<uint8_t>((word >> 8) & 0xFF);
+  dtype.lanes = static_cast<uint16_t>((word >> 16) & 0xFFFF);
+  return dtype;
+}
+
+/*! \brief Lower instructions to the flat bytecode run by the interpreter. */
+static std::vector<Index> EncodeBytecode(const std::vector<Instruction>& instructions) {
+  // Word position of every instruction, and of the end of the function.
+  std::vector<Index> word_pos(instructions.size() + 1, 0);
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    word_pos[i + 1] = word_pos[i] + EncodedLength(instructions[i]);
+  }
+  auto jump = [&word_pos](size_t i, Index offset) {
+    Index target = static_cast<Index>(i) + offset;
+    CHECK(target >= 0 && target < static_cast<Index>(word_pos.size()))
+        << "jump target out of range at instruction " << i;
+    return word_pos[target] - word_pos[i];
+  };
+
+  std::vector<Index> code;
+  code.reserve(word_pos.back());
+  auto push_regs = [&code](const RegName* regs, Index num) {
+    code.push_back(num);
+    code.insert(code.end(), regs, regs + num);
+  };
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    const Instruction& instr = instructions[i];
+    code.push_back(static_cast<Index>(instr.op));
+    switch (instr.op) {
+      case Opcode::Move:
+        code.push_back(instr.dst);
+        code.push_back(instr.from);
+        break;
+      case Opcode::Ret:
+        code.push_back(instr.result);
+        break;
+      case Opcode::Invoke:
+        code.push_back(instr.dst);
+        code.push_back(instr.func_index);
+        push_regs(instr.invoke_args_registers, instr.num_args);
+        break;
+      case Opcode::InvokeClosure:
+        code.push_back(instr.dst);
+        code.push_back(instr.closure);
+        push_regs(instr.closure_args, instr.closure_args_num);
+        break;
+      case Opcode::InvokePacked:
+        code.push_back(instr.packed_index);
+        code.push_back(instr.output_size);
+        push_regs(instr.packed_args, instr.arity);
+        break;
+      case Opcode::AllocTensor:
+        code.push_back(instr.dst);
+        code.push_back(instr.shape_register);
+        code.push_back(EncodeDataType(instr.dtype));
+        break;
+      case Opcode::AllocDatatype:
+        code.push_back(instr.dst);
+        code.push_back(instr.constructor_tag);
+        push_regs(instr.datatype_fields, instr.num_fields);
+        break;
+      case Opcode::AllocClosure:
+        code.push_back(instr.dst);
+        code.push_back(instr.clo_index);
+        push_regs(instr.free_vars, instr.num_freevar);
+        break;
+      case Opcode::GetField:
+        code.push_back(instr.dst);
+        code.push_back(instr.object);
+        code.push_back(instr.field_index);
+        break;
+      case Opcode::If:
+        code.push_back(instr.if_cond);
+        code.push_back(jump(i, instr.true_offset));
+        code.push_back(jump(i, instr.false_offset));
+        break;
+      case Opcode::Select:
+        code.push_back(instr.dst);
+        code.push_back(instr.select_cond);
+        code.push_back(instr.select_op1);
+        code.push_back(instr.select_op2);
+        break;
+      case Opcode::LoadConst:
+        code.push_back(instr.dst);
+        code.push_back(instr.const_index);
+        break;
+      case Opcode::Goto:
+        code.push_back(jump(i, instr.pc_offset));
+        break;
+      case Opcode::KillRegister:
+        code.push_back(instr.dst);
+        break;
+    }
+    CHECK_EQ(static_cast<Index>(code.size()), word_pos[i + 1]);
+  }
+  return code;
+}
+
+VMFunction::VMFunction(const std::string& name, Index params,
+                       const std::vector<Instruction>& instructions,
+                       Index register_file_size)
+    : name(name),
+      params(params),
+      instructions(instructions),
+      register_file_size(register_file_size),
+      bytecode(EncodeBytecode(instructions)) {}
+
+/*!
+ * \brief Check the registers an instruction refers to, so that corrupted
+ *  bytecode is rejected when loaded rather than read out of bounds.
+ */
+static void CheckRegisters(const Instruction& instr, Index register_file_size,
+                           const std::string& name) {
+  auto check = [&](RegName reg) {
+    CHECK(reg >= 0 && reg < register_file_size)
+        << "Register " << reg << " out of range in " << name;
+  };
+  auto check_all = [&](const RegName* regs, Index num) {
+    for (Index i = 0; i < num; ++i) check(regs[i]);
+  };
+  switch (instr.op) {
+    case Opcode::Move:
+      check(instr.dst);
+      check(instr.from);
+      break;
+    case Opcode::Ret:
+      check(instr.result);
+      break;
+    case Opcode::Invoke:
+      check(instr.dst);
+      check_all(instr.invoke_args_registers, instr.num_args);
+      break;
+    case Opcode::InvokeClosure:
+      check(instr.dst);
+      check(instr.closure);
+      check_all(instr.closure_args, instr.closure_args_num);
+      break;
+    case Opcode::InvokePacked:
+      CHECK(instr.output_size >= 0 && instr.output_size <= instr.arity)
+          << "Invalid number of outputs in " << name;
+      check_all(instr.packed_args, instr.arity);
+      break;
+    case Opcode::AllocTensor:
+      check(instr.dst);
+      check(instr.shape_register);
+      break;
+    case Opcode::AllocDatatype:
+      check(instr.dst);
+      check_all(instr.datatype_fields, instr.num_fields);
+      break;
+    case Opcode::AllocClosure:
+      check(instr.dst);
+      check_all(instr.free_vars, instr.num_freevar);
+      break;
+    case Opcode::GetField:
+      check(instr.dst);
+      check(instr.object);
+      CHECK_GE(instr.field_index, 0) << "Invalid field index in " << name;
+      break;
+    case Opcode::If:
+      check(instr.if_cond);
+      break;
+    case Opcode::Select:
+      check(instr.dst);
+      check(instr.select_cond);
+      check(instr.select_op1);
+      check(instr.select_op2);
+      break;
+    case Opcode::LoadConst:
+    case Opcode::KillRegister:
+      check(instr.dst);
+      break;
+    case Opcode::Goto:
+      break;
+  }
+}
+
+VMFunction VMFunction::FromBytecode(const std::string& name, Index params,
+                                    const std::vector<Index>& bytecode,
+                                    Index register_file_size) {
+  std::vector<Instruction> instructions;
+  // Jumps are resolved once every instruction's word position is known.
+  std::unordered_map<Index, size_t> instr_at;
+  std::vector<std::pair<size_t, Index>> jumps;
+  Index size = static_cast<Index>(bytecode.size());
+  Index pc = 0;
+  // Operand k of the current instruction, bounds checked against a
+  // truncated or corrupted executable.
+  auto w = [&](Index k) {
+    CHECK_LT(pc + k, size) << "Truncated bytecode in " << name;
+    return bytecode[pc + k];
+  };
+  auto regs = [&](Index first) {
+    Index num = w(first);
+    CHECK(num >= 0 && pc + first + num < size) << "Truncated bytecode in " << name;
+    return std::vector<RegName>(bytecode.begin() + pc + first + 1,
+                                bytecode.begin() + pc + first + 1 + num);
+  };
+  CHECK(params >= 0 && params <= register_file_size)
+      << "Invalid number of parameters in " << name;
+  while (pc < size) {
+    instr_at[pc] = instructions.size();
+    CHECK(w(0) >= 0 && w(0) <= static_cast<Index>(Opcode::KillRegister))
+        << "Invalid opcode " << w(0) << " in " << name;
+    switch (static_cast<Opcode>(w(0))) {
+      case Opcode::Move:
+        instructions.push_back(Instruction::Move(w(2), w(1)));
+        break;
+      case Opcode::Ret:
+        instructions.push_back(Instruction::Ret(w(1)));
+        break;
+      case Opcode::Invoke:
+        instructions.push_back(Instruction::Invoke(w(2), regs(3), w(1)));
+        break;
+      case Opcode::InvokeClosure:
+        instructions.push_back(Instruction::InvokeClosure(w(2), regs(3), w(1)));
+        break;
+      case Opcode::InvokePacked:
+        instructions.push_back(Instruction::InvokePacked(w(1), w(3), w(2), regs(3)));
+        break;
+      case Opcode::AllocTensor:
+        instructions.push_back(Instruction::AllocTensor(w(2), DecodeDataType(w(3)), w(1)));
+        break;
+      case Opcode::AllocDatatype:
+        instructions.push_back(Instruction::AllocDatatype(w(2), w(3), regs(3), w(1)));
+        break;
+      case Opcode::AllocClosure:
+        instructions.push_back(Instruction::AllocClosure(w(2), w(3), regs(3), w(1)));
+        break;
+      case Opcode::GetField:
+        instructions.push_back(Instruction::GetField(w(2), w(3), w(1)));
+        break;
+      case Opcode::If:
+        jumps.emplace_back(instructions.size(), pc);
+        instructions.push_back(Instruction::If(w(1), w(2), w(3)));
+        break;
+      case Opcode::Select:
+        instructions.push_back(Instruction::Select(w(2), w(3), w(4), w(1)));
+        break;
+      case Opcode::LoadConst:
+        instructions.push_back(Instruction::LoadConst(w(2), w(1)));
+        break;
+      case Opcode::Goto:
+        jumps.emplace_back(instructions.size(), pc);
+        instructions.push_back(Instruction::Goto(w(1)));
+        break;
+      case Opcode::KillRegister:
+        instructions.push_back(Instruction::KillRegister(w(1)));
+        break;
+    }
+    CheckRegisters(instructions.back(), register_file_size, name);
+    pc += EncodedLength(instructions.back());
+  }
+  instr_at[pc] = instructions.size();
+
+  auto resolve = [&](size_t index, Index word_pc, Index offset) {
+    auto it = instr_at.find(word_pc + offset);
+    CHECK(it != instr_at.end()) << "Invalid jump target in " << name;
+    return static_cast<Index>(it->second) - static_cast<Index>(index);
+  };
+  for (const auto& jump : jumps) {
+    Instruction& instr = instructions[jump.first];
+    if (instr.op == Opcode::If) {
+      instr.true_offset = resolve(jump.first, jump.second, instr.true_offset);
+      instr.false_offset = resolve(jump.first, jump.second, instr.false_offset);
+    } else {
+      instr.pc_offset = resolve(jump.first, jump.second, instr.pc_offset);
+    }
+  }
+  return VMFunction(name, params, instructions, register_file_size);
+}
+
 void DLDatatypePrint(std::ostream& os, const DLDataType& dtype) {
   switch (dtype.code) {
     case kDLInt:
@@ -466,6 +783,10 @@ void InstructionPrint(std::ostream& os, const Instruction& instr) {
       os << "goto " << instr.pc_offset;
       break;
     }
+    case Opcode::KillRegister: {
+      os << "kill " << instr.dst;
+      break;
+    }
     case Opcode::Select: {
       os << "select " << instr.dst << " " << instr.select_cond << " " << instr.select_op1 << " "
          << instr.select_op2;
@@ -522,13 +843,14 @@ void VirtualMachine::InvokeGlobal(const VMFunction& func, const std::vector<Obje
   }
   DLOG(INFO) << "func.params= " << func.params << std::endl;
 
-  code = func.instructions.data();
+  code = func.bytecode.data();
   pc = 0;
 }
 
 Object VirtualMachine::Invoke(const VMFunction& func, const std::vector<Object>& args) {
   DLOG(INFO) << "Executing Function: " << std::endl << func << std::endl;
 
+  trace::Scope trace_scope("vm", func.name);
   InvokeGlobal(func, args);
   Run();
   auto alloc = MemoryManager::Global()->GetAllocator(ctxs[0]);
@@ -542,21 +864,6 @@ Object VirtualMachine::Invoke(const std::string& name, const std::vector<Object>
   return Invoke(this->functions[func_index], args);
 }
 
-void InvokePacked(const PackedFunc& func, Index arg_count, Index output_size,
-                  const std::vector<Object>& args) {
-  std::vector<TVMValue> values(arg_count);
-  std::vector<int> codes(arg_count);
-  runtime::TVMArgsSetter setter(values.data(), codes.data());
-
-  for (Index i = 0; i < arg_count; i++) {
-    NDArray data = ToNDArray(args[i]);
-    setter(i, data);
-  }
-
-  TVMRetValue rv;
-  func.CallPacked(TVMArgs(values.data(), codes.data(), arg_count), &rv);
-}
-
 void VirtualMachine::Init(const std::vector<TVMContext>& ctxs) { this->ctxs = ctxs; }
 
 inline void VirtualMachine::WriteRegister(Index r, const Object& val) {
@@ -567,182 +874,240 @@ inline Object VirtualMachine::ReadRegister(Index r) const {
   return frames.back().register_file[r];
 }
 
+void VirtualMachine::CallFunction(const VMFunction& func, const Index* arg_regs, Index num_args,
+                                  const std::vector<Object>& free_vars, RegName dst) {
+  PushFrame(func.params, this->pc, func);
+  auto& caller = frames[frames.size() - 2].register_file;
+  auto& callee = frames.back().register_file;
+  for (Index i = 0; i < num_args; ++i) {
+    callee[i] = caller[arg_regs[i]];
+  }
+  for (size_t i = 0; i < free_vars.size(); ++i) {
+    callee[num_args + i] = free_vars[i];
+  }
+  frames.back().caller_return_register = dst;
+  code = func.bytecode.data();
+  pc = 0;
+}
+
+/*! \brief Read the first byte of a condition tensor. */
+static bool ReadCondition(const Object& cond) {
+  NDArray array = ToNDArray(cond);
+  if (array->ctx.device_type != kDLCPU) {
+    DLContext cpu_ctx;
+    cpu_ctx.device_type = kDLCPU;
+    cpu_ctx.device_id = 0;
+    array = array.CopyTo(cpu_ctx);
+  }
+  // CHECK_EQ(TVMType2Type(array->dtype), Bool());
+  return reinterpret_cast<uint8_t*>(array->data)[0];
+}
+
+// GCC and Clang support taking the address of a label, which lets every
+// handler jump straight to the next one instead of going back through a
+// single switch, giving each handler its own branch prediction.
+#if defined(__GNUC__) && !defined(TVM_VM_SWITCH_DISPATCH)
+#define TVM_VM_THREADED_DISPATCH 1
+#else
+#define TVM_VM_THREADED_DISPATCH 0
+#endif
+
 void VirtualMachine::Run() {
   CHECK(this->code);
   this->pc = 0;
   Index frame_start = frames.size();
-  while (true) {
-  main_loop:
-    auto const& instr = this->code[this->pc];
-    DLOG(INFO) << "\nExecuting(" << pc << "): ";
-#if USE_RELAY_DEBUG
-    InstructionPrint(std::cout, instr);
-#endif  // USE_RELAY_DEBUG
 
-    switch (instr.op) {
-      case Opcode::Move: {
-        Object from_obj;
-        if (instr.from == 0) {
-          from_obj = return_register;
-        } else {
-          from_obj = ReadRegister(instr.from);
-        }
-        WriteRegister(instr.dst, from_obj);
-        pc++;
-        goto main_loop;
-      }
-      case Opcode::LoadConst: {
-        WriteRegister(instr.dst, this->constants[instr.const_index]);
-        pc++;
-        goto main_loop;
-      }
-      case Opcode::Invoke: {
-        std::vector<Object> args;
-        for (Index i = 0; i < instr.num_args; ++i) {
-          args.push_back(ReadRegister(instr.invoke_args_registers[i]));
-        }
-        InvokeGlobal(this->functions[instr.func_index], args);
-        frames.back().caller_return_register = instr.dst;
-        goto main_loop;
-      }
-      case Opcode::InvokePacked: {
-        const auto& func = packed_funcs[instr.packed_index];
-        const auto& arity = instr.arity;
-        std::vector<Object> args;
-        for (Index i = 0; i < arity; ++i) {
-          args.push_back(ReadRegister(instr.packed_args[i]));
-        }
-        InvokePacked(func, arity, instr.output_size, args);
-        for (Index i = 0; i < instr.output_size; ++i) {
-          WriteRegister(instr.packed_args[instr.arity - instr.output_size + i],
-                        args[instr.arity - instr.output_size + i]);
-        }
-        pc++;
-        goto main_loop;
-      }
-      case Opcode::InvokeClosure: {
-        auto object = ReadRegister(instr.closure);
-        const auto& closure = object.AsClosure();
-        std::vector<Object> args;
-        for (Index i = 0; i < instr.closure_args_num; ++i) {
-          args.push_back(ReadRegister(instr.closure_args[i]));
-        }
-        for (auto free_var : closure->free_vars) {
-          args.push_back(free_var);
-        }
-        InvokeGlobal(this->functions[closure->func_index], args);
-        frames.back().caller_return_register = instr.dst;
-        goto main_loop;
+#if TVM_VM_THREADED_DISPATCH
+  // Indexed by opcode, keep in the order of the Opcode enum.
+  static const void* dispatch_table[] = {
+    &&op_Move, &&op_Ret, &&op_Invoke, &&op_InvokeClosure, &&op_InvokePacked,
+    &&op_AllocTensor, &&op_AllocDatatype, &&op_AllocClosure, &&op_GetField,
+    &&op_If, &&op_Select, &&op_LoadConst, &&op_Goto, &&op_KillRegister
+  };
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *dispatch_table[code[pc]]
+#else
+#define VM_CASE(name) case Opcode::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+
+  // Every handler dispatches after its block is closed: a computed goto out
+  // of a block does not run the destructors of its locals.
+  VM_DISPATCH();
+#if !TVM_VM_THREADED_DISPATCH
+dispatch:
+  switch (static_cast<Opcode>(code[pc])) {
+#endif
+    VM_CASE(Move) {
+      // move dst from
+      Object from_obj;
+      if (code[pc + 2] == 0) {
+        from_obj = return_register;
+      } else {
+        from_obj = ReadRegister(code[pc + 2]);
       }
-      case Opcode::GetField: {
-        auto object = ReadRegister(instr.object);
-        CHECK(object->tag == ObjectTag::kDatatype)
-            << "Object is not data type object, register " << instr.object << ", Object tag "
-            << static_cast<int>(object->tag);
-        const auto& tuple = object.AsDatatype();
-        auto field = tuple->fields[instr.field_index];
-        WriteRegister(instr.dst, field);
-        pc++;
-        goto main_loop;
+      WriteRegister(code[pc + 1], from_obj);
+      pc += 3;
+    }
+    VM_DISPATCH();
+    VM_CASE(LoadConst) {
+      // load_const dst const_index
+      WriteRegister(code[pc + 1], this->constants[code[pc + 2]]);
+      pc += 3;
+    }
+    VM_DISPATCH();
+    VM_CASE(Invoke) {
+      // invoke dst func_index num_args args...
+      const VMFunction& func = this->functions[code[pc + 2]];
+      const Index* arg_regs = code + pc + 4;
+      Index num_args = code[pc + 3];
+      RegName dst = code[pc + 1];
+      pc += 4 + num_args;
+      CallFunction(func, arg_regs, num_args, {}, dst);
+    }
+    VM_DISPATCH();
+    VM_CASE(InvokePacked) {
+      // invoke_packed packed_index output_size arity args...
+      const auto& func = packed_funcs[code[pc + 1]];
+      Index arity = code[pc + 3];
+      const Index* arg_regs = code + pc + 4;
+      packed_values_.resize(arity);
+      packed_codes_.resize(arity);
+      runtime::TVMArgsSetter setter(packed_values_.data(), packed_codes_.data());
+      // The register file keeps the tensors alive for the call, so only
+      // their handles are passed on. Outputs are written in place.
+      const auto& regs = frames.back().register_file;
+      for (Index i = 0; i < arity; ++i) {
+        setter(i, regs[arg_regs[i]].AsTensor()->data);
       }
-      case Opcode::Goto: {
-        pc += instr.pc_offset;
-        goto main_loop;
+      TVMRetValue rv;
+      Index packed_index = code[pc + 1];
+      trace::Scope trace_scope(
+          "op", static_cast<size_t>(packed_index) < packed_func_names.size() ?
+          packed_func_names[packed_index].c_str() : "invoke_packed");
+      func.CallPacked(TVMArgs(packed_values_.data(), packed_codes_.data(), arity), &rv);
+      pc += 4 + arity;
+    }
+    VM_DISPATCH();
+    VM_CASE(InvokeClosure) {
+      // invoke_closure dst closure num_args args...
+      auto object = ReadRegister(code[pc + 2]);
+      const auto& closure = object.AsClosure();
+      const Index* arg_regs = code + pc + 4;
+      Index num_args = code[pc + 3];
+      RegName dst = code[pc + 1];
+      pc += 4 + num_args;
+      CallFunction(this->functions[closure->func_index], arg_regs, num_args,
+                   closure->free_vars, dst);
+    }
+    VM_DISPATCH();
+    VM_CASE(GetField) {
+      // get_field dst object field_index
+      auto object = ReadRegister(code[pc + 2]);
+      CHECK(object->tag == ObjectTag::kDatatype)
+          << "Object is not data type object, register " << code[pc + 2] << ", Object tag "
+          << static_cast<int>(object->tag);
+      const auto& tuple = object.AsDatatype();
+      auto field = tuple->fields[code[pc + 3]];
+      WriteRegister(code[pc + 1], field);
+      pc += 4;
+    }
+    VM_DISPATCH();
+    VM_CASE(Goto) {
+      // goto pc_offset
+      pc += code[pc + 1];
+    }
+    VM_DISPATCH();
+    VM_CASE(If) {
+      // if cond true_offset false_offset
+      if (ReadCondition(ReadRegister(code[pc + 1]))) {
+        pc += code[pc + 2];
+      } else {
+        pc += code[pc + 3];
       }
-      case Opcode::If: {
-        // How do we do this efficiently?
+    }
+    VM_DISPATCH();
+    VM_CASE(AllocTensor) {
+      // alloc_tensor dst shape_register dtype
+      NDArray shape_tensor = ToNDArray(ReadRegister(code[pc + 2]));
+      if (shape_tensor->ctx.device_type != kDLCPU) {
         DLContext cpu_ctx;
         cpu_ctx.device_type = kDLCPU;
         cpu_ctx.device_id = 0;
-
-        const auto& cond = ReadRegister(instr.if_cond);
-        NDArray cpu_array = ToNDArray(cond).CopyTo(cpu_ctx);
-        // CHECK_EQ(cpu_array->dtype, Bool());
-        bool branch = reinterpret_cast<uint8_t*>(cpu_array->data)[0];
-
-        if (branch) {
-          pc += instr.true_offset;
-        } else {
-          pc += instr.false_offset;
-        }
-
-        goto main_loop;
+        shape_tensor = shape_tensor.CopyTo(cpu_ctx);
       }
-      case Opcode::AllocTensor: {
-        DLContext cpu_ctx;
-        cpu_ctx.device_type = kDLCPU;
-        cpu_ctx.device_id = 0;
 
-        auto shape_tensor_obj = ReadRegister(instr.shape_register);
-        NDArray shape_tensor = ToNDArray(shape_tensor_obj).CopyTo(cpu_ctx);
-
-        int64_t* dims = static_cast<int64_t*>(shape_tensor->data);
-        auto num_dims = shape_tensor->shape[0];
-        auto shape = std::vector<int64_t>(shape_tensor->shape[0]);
-        shape.assign(dims, dims + num_dims);
-        auto allocator = MemoryManager::Global()->GetAllocator(ctxs[0]);
-        auto data = allocator->Empty(shape, instr.dtype, ctxs[0]);
-        auto obj = Object::Tensor(data);
-        WriteRegister(instr.dst, obj);
-        pc++;
-        goto main_loop;
-      }
-      case Opcode::AllocDatatype: {
-        std::vector<Object> fields;
-        for (Index i = 0; i < instr.num_fields; ++i) {
-          fields.push_back(ReadRegister(instr.datatype_fields[i]));
-        }
-        Object obj = Object::Datatype(instr.constructor_tag, fields);
-        WriteRegister(instr.dst, obj);
-        pc++;
-        goto main_loop;
+      int64_t* dims = static_cast<int64_t*>(shape_tensor->data);
+      auto num_dims = shape_tensor->shape[0];
+      auto shape = std::vector<int64_t>(dims, dims + num_dims);
+      auto allocator = MemoryManager::Global()->GetAllocator(ctxs[0]);
+      trace::Scope trace_scope("memory", "alloc_tensor");
+      auto data = allocator->Empty(shape, DecodeDataType(code[pc + 3]), ctxs[0]);
+      WriteRegister(code[pc + 1], Object::Tensor(data));
+      pc += 4;
+    }
+    VM_DISPATCH();
+    VM_CASE(AllocDatatype) {
+      // alloc_data dst tag num_fields fields...
+      Index num_fields = code[pc + 3];
+      std::vector<Object> fields;
+      fields.reserve(num_fields);
+      for (Index i = 0; i < num_fields; ++i) {
+        fields.push_back(ReadRegister(code[pc + 4 + i]));
       }
-      case Opcode::AllocClosure: {
-        std::vector<Object> free_vars;
-        for (Index i = 0; i < instr.num_freevar; i++) {
-          free_vars.push_back(ReadRegister(instr.free_vars[i]));
-        }
-        WriteRegister(instr.dst, Object::Closure(instr.func_index, free_vars));
-        pc++;
-        goto main_loop;
+      WriteRegister(code[pc + 1], Object::Datatype(code[pc + 2], fields));
+      pc += 4 + num_fields;
+    }
+    VM_DISPATCH();
+    VM_CASE(AllocClosure) {
+      // alloc_closure dst clo_index num_freevar free_vars...
+      Index num_freevar = code[pc + 3];
+      std::vector<Object> free_vars;
+      free_vars.reserve(num_freevar);
+      for (Index i = 0; i < num_freevar; i++) {
+        free_vars.push_back(ReadRegister(code[pc + 4 + i]));
       }
-      case Opcode::Select: {
-        DLContext cpu_ctx;
-        cpu_ctx.device_type = kDLCPU;
-        cpu_ctx.device_id = 0;
+      WriteRegister(code[pc + 1], Object::Closure(code[pc + 2], free_vars));
+      pc += 4 + num_freevar;
+    }
+    VM_DISPATCH();
+    VM_CASE(Select) {
+      // select dst cond op1 op2
+      bool branch = ReadCondition(ReadRegister(code[pc + 2]));
+      WriteRegister(code[pc + 1], ReadRegister(branch ? code[pc + 3] : code[pc + 4]));
+      pc += 5;
+    }
+    VM_DISPATCH();
+    VM_CASE(KillRegister) {
+      // kill reg
+      // Drop the reference so the storage can go back to the allocator
+      // before the frame exits.
+      WriteRegister(code[pc + 1], Object());
+      pc += 2;
+    }
+    VM_DISPATCH();
+    VM_CASE(Ret) {
+      // ret result
+      // If we have hit the point from which we started
+      // running, we should return to the caller breaking
+      // the dispatch loop.
+      return_register = ReadRegister(code[pc + 1]);
+      auto caller_return_register = frames.back().caller_return_register;
 
-        auto cond = ReadRegister(instr.select_cond);
-        NDArray cpu_array = ToNDArray(cond).CopyTo(cpu_ctx);
-        // CHECK_EQ(TVMType2Type(cpu_array->dtype), Bool());
-        bool branch = reinterpret_cast<uint8_t*>(cpu_array->data)[0];
-
-        if (branch) {
-          auto op1 = ReadRegister(instr.select_op1);
-          WriteRegister(instr.dst, op1);
-        } else {
-          auto op2 = ReadRegister(instr.select_op2);
-          WriteRegister(instr.dst, op2);
-        }
-        pc++;
-        goto main_loop;
-      }
-      case Opcode::Ret: {
-        // If we have hit the point from which we started
-        // running, we should return to the caller breaking
-        // the dispatch loop.
-        return_register = ReadRegister(instr.result);
-        auto caller_return_register = frames.back().caller_return_register;
-
-        if (PopFrame() == frame_start) {
-          return;
-          // Otherwise we are just returning from a local call.
-        } else {
-          WriteRegister(caller_return_register, return_register);
-          goto main_loop;
-        }
+      if (PopFrame() == frame_start) {
+        return;
       }
+      // Otherwise we are just returning from a local call.
+      WriteRegister(caller_return_register, return_register);
     }
+    VM_DISPATCH();
+#if !TVM_VM_THREADED_DISPATCH
+    default:
+      LOG(FATAL) << "Invalid opcode " << code[pc];
   }
+#endif
+#undef VM_CASE
+#undef VM_DISPATCH
 }
 
 }  // namespace vm
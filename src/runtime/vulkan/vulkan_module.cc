@@ -108,6 +108,10 @@ class VulkanModuleNode final :public runtime::ModuleNode {
     stream->Write(fmap_);
     stream->Write(smap_);
   }
+
+  std::vector<std::string> GetFunctionNames() final {
+    return FunctionInfoNames(fmap_);
+  }
   std::string GetSource(const std::string& format) final {
     // can only return source code.
     return source_;
@@ -22,7 +22,16 @@
  * \file workspace_pool.h
  * \brief Workspace pool utility.
  */
+#include <tvm/runtime/registry.h>
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "trace.h"
 #include "workspace_pool.h"
 
 namespace tvm {
@@ -30,94 +39,191 @@ namespace runtime {
 
 // page size.
 constexpr size_t kWorkspacePageSize = 4 << 10;
+// number of size classes that hold an exact number of pages.
+constexpr int kNumExactClasses = 16;
+// number of size classes per power of two above the exact classes.
+constexpr int kClassesPerDoubling = 4;
+// number of 64 bit words of the non-empty class bitmap.
+constexpr int kClassMaskWords = 3;
+// total number of size classes.
+constexpr int kNumSizeClasses = kClassMaskWords * 64;
+// maximum number of classes a cached block can be above the request.
+constexpr int kMaxClassSlack = 8;
+
+/*!
+ * \brief Map a number of pages to its size class.
+ * \param pages The number of pages requested.
+ * \param class_pages The number of pages of blocks in the class.
+ * \return The size class index.
+ */
+inline int SizeClass(size_t pages, size_t* class_pages) {
+  if (pages <= static_cast<size_t>(kNumExactClasses)) {
+    *class_pages = pages;
+    return static_cast<int>(pages) - 1;
+  }
+  // kClassesPerDoubling geometric classes per power of two.
+  int lg = 0;
+  while ((static_cast<size_t>(2) << lg) <= pages - 1) ++lg;
+  int shift = lg - 2;
+  size_t rounded = ((pages - 1) >> shift) + 1;
+  *class_pages = rounded << shift;
+  int cls = kNumExactClasses + (lg - 4) * kClassesPerDoubling +
+      static_cast<int>(rounded) - (kClassesPerDoubling + 1);
+  CHECK_LT(cls, kNumSizeClasses) << "Workspace allocation is too large";
+  return cls;
+}
+
+/*!
+ * \brief Open addressing hash map from block address to a value.
+ *
+ *  Entries live in one flat array, so insert and erase do not allocate
+ *  once the table has grown to the working set.
+ */
+template<typename V>
+class BlockMap {
+ public:
+  BlockMap() : slots_(16) {}
+  size_t size() const {
+    return size_;
+  }
+  void Insert(void* key, const V& value) {
+    if ((size_ + 1) * 2 > slots_.size()) Grow();
+    size_t i = Probe(key);
+    if (slots_[i].key == nullptr) ++size_;
+    slots_[i].key = key;
+    slots_[i].value = value;
+  }
+  // Remove key and store its value, return whether key was present.
+  bool Erase(void* key, V* value) {
+    size_t i = Probe(key);
+    if (slots_[i].key == nullptr) return false;
+    *value = slots_[i].value;
+    // backward shift deletion keeps the probe sequences intact.
+    size_t mask = slots_.size() - 1;
+    size_t j = i;
+    while (true) {
+      j = (j + 1) & mask;
+      if (slots_[j].key == nullptr) break;
+      size_t home = Hash(slots_[j].key) & mask;
+      if (((j - home) & mask) >= ((j - i) & mask)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].key = nullptr;
+    --size_;
+    return true;
+  }
+
+ private:
+  struct Slot {
+    void* key{nullptr};
+    V value;
+  };
+  static size_t Hash(void* key) {
+    uint64_t h = reinterpret_cast<uintptr_t>(key) >> 4;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+  // Find the slot of key, or the empty slot where it would be inserted.
+  size_t Probe(void* key) const {
+    size_t mask = slots_.size() - 1;
+    size_t i = Hash(key) & mask;
+    while (slots_[i].key != nullptr && slots_[i].key != key) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+  void Grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+    std::swap(old, slots_);
+    size_ = 0;
+    for (const Slot& slot : old) {
+      if (slot.key != nullptr) Insert(slot.key, slot.value);
+    }
+  }
+  std::vector<Slot> slots_;
+  size_t size_{0};
+};
 
 class WorkspacePool::Pool {
  public:
-  // constructor
-  Pool() {
-    // safe guard header on each list.
-    Entry e;
-    e.data = nullptr;
-    e.size = 0;
-    free_list_.push_back(e);
-    allocated_.push_back(e);
+  explicit Pool(DLDeviceType device_type) : device_type_(device_type) {}
+  // The device type of the pool.
+  DLDeviceType device_type() const {
+    return device_type_;
   }
   // allocate from pool
   void* Alloc(TVMContext ctx, DeviceAPI* device, size_t nbytes) {
     // Allocate align to page.
-    nbytes = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize * kWorkspacePageSize;
-    if (nbytes == 0) nbytes = kWorkspacePageSize;
+    size_t pages = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize;
+    if (pages == 0) pages = 1;
+    size_t class_pages;
+    int cls = SizeClass(pages, &class_pages);
     Entry e;
-    TVMType type;
-    type.code = kDLUInt;
-    type.bits = 8;
-    type.lanes = 1;
-    if (free_list_.size() == 2) {
-      e = free_list_.back();
-      free_list_.pop_back();
-      if (e.size < nbytes) {
-        // resize the page
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
-      }
-    } else if (free_list_.size() == 1) {
-      e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-      e.size = nbytes;
+    int free_cls = FindFreeClass(cls);
+    if (free_cls >= 0 && free_cls - cls <= kMaxClassSlack) {
+      e = PopFree(free_cls);
+      Inc(&stats_.num_hit, 1);
     } else {
-      if (free_list_.back().size >= nbytes) {
-        // find smallest fit
-        auto it = free_list_.end() - 2;
-        for (; it->size >= nbytes; --it) {}
-        e = *(it + 1);
-        free_list_.erase(it + 1);
-      } else {
-        // resize the page
-        e = free_list_.back();
-        free_list_.pop_back();
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
+      // release the largest smaller block to bound the memory held by the
+      // pool when the allocation pattern grows.
+      int smaller = FindFreeClassBelow(cls);
+      if (smaller >= 0) {
+        Entry old = PopFree(smaller);
+        device->FreeDataSpace(ctx, old.data);
+        Inc(&stats_.reserved_bytes, -static_cast<int64_t>(old.size));
       }
+      TVMType type;
+      type.code = kDLUInt;
+      type.bits = 8;
+      type.lanes = 1;
+      e.size = class_pages * kWorkspacePageSize;
+      e.size_class = cls;
+      e.data = device->AllocDataSpace(ctx, e.size, kTempAllocaAlignment, type);
+      Inc(&stats_.reserved_bytes, static_cast<int64_t>(e.size));
+    }
+    e.requested = nbytes;
+    allocated_.Insert(e.data, e);
+    Inc(&stats_.num_alloc, 1);
+    Inc(&stats_.requested_bytes, static_cast<int64_t>(nbytes));
+    Inc(&stats_.used_bytes, static_cast<int64_t>(e.size));
+    if (stats_.used_bytes.load(std::memory_order_relaxed) >
+        stats_.peak_used_bytes.load(std::memory_order_relaxed)) {
+      stats_.peak_used_bytes.store(stats_.used_bytes.load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
     }
-    allocated_.push_back(e);
     return e.data;
   }
   // free resource back to pool
   void Free(void* data) {
     Entry e;
-    if (allocated_.back().data == data) {
-      // quick path, last allocated.
-      e = allocated_.back();
-      allocated_.pop_back();
-    } else {
-      int index = static_cast<int>(allocated_.size()) - 2;
-      for (; index > 0 && allocated_[index].data != data; --index) {}
-      CHECK_GT(index, 0) << "trying to free things that has not been allocated";
-      e = allocated_[index];
-      allocated_.erase(allocated_.begin() + index);
-    }
-    if (free_list_.back().size < e.size) {
-      free_list_.push_back(e);
-    } else if (free_list_.size() == 2) {
-      free_list_.push_back(free_list_.back());
-      free_list_[1] = e;
-    } else {
-      size_t i = free_list_.size() - 1;
-      free_list_.resize(free_list_.size() + 1);
-      for (; e.size < free_list_[i].size; --i) {
-        free_list_[i + 1] = free_list_[i];
-      }
-      free_list_[i + 1] = e;
-    }
+    CHECK(allocated_.Erase(data, &e)) << "trying to free things that has not been allocated";
+    Inc(&stats_.requested_bytes, -static_cast<int64_t>(e.requested));
+    Inc(&stats_.used_bytes, -static_cast<int64_t>(e.size));
+    free_list_[e.size_class].push_back(e);
+    class_mask_[e.size_class / 64] |= static_cast<uint64_t>(1) << (e.size_class % 64);
   }
   // Release all resources
   void Release(TVMContext ctx, DeviceAPI* device) {
-    CHECK_EQ(allocated_.size(), 1);
-    for (size_t i = 1; i < free_list_.size(); ++i) {
-      device->FreeDataSpace(ctx, free_list_[i].data);
+    CHECK_EQ(allocated_.size(), 0);
+    for (int cls = 0; cls < kNumSizeClasses; ++cls) {
+      for (const Entry& e : free_list_[cls]) {
+        device->FreeDataSpace(ctx, e.data);
+      }
+      free_list_[cls].clear();
     }
-    free_list_.clear();
+    std::fill(class_mask_, class_mask_ + kClassMaskWords, 0);
+    stats_.reserved_bytes.store(0, std::memory_order_relaxed);
+  }
+  // Add the statistics of this pool to stats.
+  void AddStats(WorkspacePoolStats* stats) const {
+    stats->num_alloc += stats_.num_alloc.load(std::memory_order_relaxed);
+    stats->num_hit += stats_.num_hit.load(std::memory_order_relaxed);
+    stats->requested_bytes += stats_.requested_bytes.load(std::memory_order_relaxed);
+    stats->used_bytes += stats_.used_bytes.load(std::memory_order_relaxed);
+    stats->sum_peak_used_bytes += stats_.peak_used_bytes.load(std::memory_order_relaxed);
+    stats->reserved_bytes += stats_.reserved_bytes.load(std::memory_order_relaxed);
   }
 
  private:
@@ -125,11 +231,99 @@ class WorkspacePool::Pool {
   struct Entry {
     void* data;
     size_t size;
+    size_t requested;
+    int size_class;
   };
-  /*! \brief List of free items, sorted from small to big size */
-  std::vector<Entry> free_list_;
-  /*! \brief List of allocated items */
-  std::vector<Entry> allocated_;
+  /*!
+   * \brief Statistics counters.
+   *  Only the owner thread writes them, other threads read them through
+   *  the registry, hence they are atomic.
+   */
+  struct Counters {
+    std::atomic<int64_t> num_alloc{0};
+    std::atomic<int64_t> num_hit{0};
+    std::atomic<int64_t> requested_bytes{0};
+    std::atomic<int64_t> used_bytes{0};
+    std::atomic<int64_t> peak_used_bytes{0};
+    std::atomic<int64_t> reserved_bytes{0};
+  };
+  // single writer increment, avoids a locked instruction on the hot path.
+  static void Inc(std::atomic<int64_t>* counter, int64_t value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+  }
+  Entry PopFree(int cls) {
+    Entry e = free_list_[cls].back();
+    free_list_[cls].pop_back();
+    if (free_list_[cls].empty()) {
+      class_mask_[cls / 64] &= ~(static_cast<uint64_t>(1) << (cls % 64));
+    }
+    return e;
+  }
+  // Find the smallest non-empty class that is not smaller than cls, -1 if none.
+  int FindFreeClass(int cls) const {
+    for (int w = cls / 64; w < kClassMaskWords; ++w) {
+      uint64_t mask = class_mask_[w];
+      if (w == cls / 64) mask &= ~static_cast<uint64_t>(0) << (cls % 64);
+      if (mask != 0) return w * 64 + LowestBit(mask);
+    }
+    return -1;
+  }
+  // Find the largest non-empty class that is smaller than cls, -1 if none.
+  int FindFreeClassBelow(int cls) const {
+    for (int w = cls / 64; w >= 0; --w) {
+      uint64_t mask = class_mask_[w];
+      if (w == cls / 64) mask &= (static_cast<uint64_t>(1) << (cls % 64)) - 1;
+      if (mask != 0) return w * 64 + HighestBit(mask);
+    }
+    return -1;
+  }
+  static int LowestBit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1)) {
+      mask >>= 1;
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+  static int HighestBit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(mask);
+#else
+    int bit = 63;
+    while (!(mask >> bit)) --bit;
+    return bit;
+#endif
+  }
+  /*! \brief Free blocks of each size class */
+  std::vector<Entry> free_list_[kNumSizeClasses];
+  /*! \brief Bitmap of the size classes with free blocks */
+  uint64_t class_mask_[kClassMaskWords] = {0};
+  /*! \brief Allocated items indexed by address */
+  BlockMap<Entry> allocated_;
+  /*! \brief Statistics */
+  Counters stats_;
+  /*! \brief The device type */
+  DLDeviceType device_type_;
+};
+
+/*!
+ * \brief Registry of the live per-device pools, used to aggregate statistics.
+ *
+ *  Pools are published here when created and withdrawn before they are
+ *  deleted, so other threads never look into the array of a WorkspacePool.
+ */
+struct WorkspacePoolRegistry {
+  std::mutex mutex;
+  std::unordered_set<const WorkspacePool::Pool*> pools;
+  static WorkspacePoolRegistry* Global() {
+    static WorkspacePoolRegistry* inst = new WorkspacePoolRegistry();
+    return inst;
+  }
 };
 
 WorkspacePool::WorkspacePool(DLDeviceType device_type, std::shared_ptr<DeviceAPI> device)
@@ -139,6 +333,11 @@ WorkspacePool::WorkspacePool(DLDeviceType device_type, std::shared_ptr<DeviceAPI
 WorkspacePool::~WorkspacePool() {
   for (size_t i = 0; i < array_.size(); ++i) {
     if (array_[i] != nullptr) {
+      {
+        WorkspacePoolRegistry* reg = WorkspacePoolRegistry::Global();
+        std::lock_guard<std::mutex> lock(reg->mutex);
+        reg->pools.erase(array_[i]);
+      }
       TVMContext ctx;
       ctx.device_type = device_type_;
       ctx.device_id = static_cast<int>(i);
@@ -149,11 +348,16 @@ WorkspacePool::~WorkspacePool() {
 }
 
 void* WorkspacePool::AllocWorkspace(TVMContext ctx, size_t size) {
+  trace::Scope trace_scope("memory", "alloc_workspace", static_cast<int64_t>(size));
   if (static_cast<size_t>(ctx.device_id) >= array_.size()) {
     array_.resize(ctx.device_id + 1, nullptr);
   }
   if (array_[ctx.device_id] == nullptr) {
-    array_[ctx.device_id] = new Pool();
+    Pool* pool = new Pool(device_type_);
+    WorkspacePoolRegistry* reg = WorkspacePoolRegistry::Global();
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    reg->pools.insert(pool);
+    array_[ctx.device_id] = pool;
   }
   return array_[ctx.device_id]->Alloc(ctx, device_.get(), size);
 }
@@ -164,5 +368,45 @@ void WorkspacePool::FreeWorkspace(TVMContext ctx, void* ptr) {
   array_[ctx.device_id]->Free(ptr);
 }
 
+WorkspacePoolStats WorkspacePool::GetStats() const {
+  WorkspacePoolStats stats;
+  for (const Pool* pool : array_) {
+    if (pool != nullptr) pool->AddStats(&stats);
+  }
+  return stats;
+}
+
+WorkspacePoolStats WorkspacePool::GetGlobalStats(DLDeviceType device_type) {
+  WorkspacePoolStats stats;
+  WorkspacePoolRegistry* reg = WorkspacePoolRegistry::Global();
+  std::lock_guard<std::mutex> lock(reg->mutex);
+  for (const Pool* pool : reg->pools) {
+    if (pool->device_type() == device_type) pool->AddStats(&stats);
+  }
+  return stats;
+}
+
+// Get the workspace statistics of a device type in json format.
+TVM_REGISTER_GLOBAL("runtime.workspace_pool_stats")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    int device_type = args[0];
+    WorkspacePoolStats stats =
+        WorkspacePool::GetGlobalStats(static_cast<DLDeviceType>(device_type));
+    double hit_rate = stats.num_alloc == 0 ? 0.0 :
+        static_cast<double>(stats.num_hit) / stats.num_alloc;
+    double fragmentation = stats.used_bytes == 0 ? 0.0 :
+        1.0 - static_cast<double>(stats.requested_bytes) / stats.used_bytes;
+    std::ostringstream os;
+    os << "{\"num_alloc\": " << stats.num_alloc
+       << ", \"num_hit\": " << stats.num_hit
+       << ", \"hit_rate\": " << hit_rate
+       << ", \"requested_bytes\": " << stats.requested_bytes
+       << ", \"used_bytes\": " << stats.used_bytes
+       << ", \"sum_peak_used_bytes\": " << stats.sum_peak_used_bytes
+       << ", \"reserved_bytes\": " << stats.reserved_bytes
+       << ", \"fragmentation\": " << fragmentation << "}";
+    *rv = os.str();
+  });
+
 }  // namespace runtime
 }  // namespace tvm
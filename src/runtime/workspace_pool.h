@@ -31,6 +31,26 @@
 
 namespace tvm {
 namespace runtime {
+/*! \brief Statistics of workspace pools. */
+struct WorkspacePoolStats {
+  /*! \brief Number of allocation requests. */
+  int64_t num_alloc{0};
+  /*! \brief Number of requests served by a cached block. */
+  int64_t num_hit{0};
+  /*! \brief Bytes requested by the live allocations. */
+  int64_t requested_bytes{0};
+  /*! \brief Bytes of the blocks backing the live allocations. */
+  int64_t used_bytes{0};
+  /*!
+   * \brief Sum of the peak used_bytes of each per-device pool.
+   *  The pools peak at different times, so this is an upper bound of
+   *  the peak of the total rather than a peak.
+   */
+  int64_t sum_peak_used_bytes{0};
+  /*! \brief Bytes allocated from the device, including cached blocks. */
+  int64_t reserved_bytes{0};
+};
+
 /*!
  * \brief A workspace pool to manage
  *
@@ -41,6 +61,9 @@ namespace runtime {
  *  - Only a few allocation will happen, and space will be released after use.
  *  - The release order is usually in reverse order of allocate
  *  - Repeative pattern of same allocations over different runs.
+ *
+ *  Blocks are cached in segregated free lists, one per size class,
+ *  so that both allocation and free take constant time.
  */
 class TVM_DLL WorkspacePool {
  public:
@@ -65,9 +88,26 @@ class TVM_DLL WorkspacePool {
    * \param ptr The pointer to be freed.
    */
   void FreeWorkspace(TVMContext ctx, void* ptr);
+  /*!
+   * \brief Get the statistics of this pool, summed over all devices.
+   *  Must be called on the thread that uses the pool.
+   * \return The statistics.
+   */
+  WorkspacePoolStats GetStats() const;
+  /*! \brief The pool of one device. */
+  class Pool;
+  /*!
+   * \brief Get the statistics summed over all live pools of a device type.
+   *
+   *  Pools are usually thread local, the per-device pools of every thread
+   *  are read through a registry, so this is safe to call from any thread.
+   *
+   * \param device_type The device type.
+   * \return The statistics.
+   */
+  static WorkspacePoolStats GetGlobalStats(DLDeviceType device_type);
 
  private:
-  class Pool;
   /*! \brief pool of device local array */
   std::vector<Pool*> array_;
   /*! \brief device type this pool support */
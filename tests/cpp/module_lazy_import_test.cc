@@ -0,0 +1,181 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/logging.h>
+#include <dmlc/memory_io.h>
+#include <gtest/gtest.h>
+#include <tvm/codegen.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/registry.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../src/runtime/module_util.h"
+
+namespace {
+
+using tvm::runtime::Module;
+using tvm::runtime::ModuleNode;
+using tvm::runtime::PackedFunc;
+using tvm::runtime::TVMArgs;
+using tvm::runtime::TVMRetValue;
+
+/*! \brief The number of times the test module was deserialized. */
+int num_loads = 0;
+
+/*! \brief A device-like module that exposes one function returning its payload length. */
+class LazyTestModuleNode : public ModuleNode {
+ public:
+  explicit LazyTestModuleNode(std::string payload) : payload_(payload) {}
+
+  const char* type_key() const final {
+    return "lazy_test";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const std::shared_ptr<ModuleNode>& sptr_to_self) final {
+    if (name != "f") return PackedFunc();
+    int size = static_cast<int>(payload_.size());
+    return PackedFunc([size](TVMArgs args, TVMRetValue* rv) { *rv = size; });
+  }
+
+  void SaveToBinary(dmlc::Stream* stream) final {
+    stream->Write(payload_);
+  }
+
+  std::vector<std::string> GetFunctionNames() final {
+    return {"f"};
+  }
+
+ private:
+  std::string payload_;
+};
+
+/*! \brief A host module that only carries imports. */
+class HostTestModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final {
+    return "host_test";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const std::shared_ptr<ModuleNode>& sptr_to_self) final {
+    return PackedFunc();
+  }
+};
+
+TVM_REGISTER_GLOBAL("module.loadbinary_lazy_test")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    dmlc::Stream* stream = static_cast<dmlc::Stream*>(args[0].operator void*());
+    std::string payload;
+    CHECK(stream->Read(&payload));
+    ++num_loads;
+    *rv = Module(std::make_shared<LazyTestModuleNode>(payload));
+  });
+
+Module HostWithImport(Module import) {
+  Module host(std::make_shared<HostTestModuleNode>());
+  host.Import(import);
+  return host;
+}
+
+// Extract the bytes of the module blob from the C source of PackImportsToC.
+std::string ParseBlob(const std::string& code) {
+  size_t pos = code.find("= {");
+  size_t end = code.find("};", pos);
+  CHECK(pos != std::string::npos && end != std::string::npos);
+  std::string blob;
+  while ((pos = code.find("0x", pos)) < end) {
+    char* next;
+    blob.push_back(static_cast<char>(strtoul(code.c_str() + pos, &next, 16)));
+    pos = next - code.c_str();
+  }
+  return blob;
+}
+
+std::vector<Module> ImportBlob(const std::string& blob) {
+  std::vector<Module> modules;
+  tvm::runtime::ImportModuleBlob(blob.data(), &modules);
+  return modules;
+}
+
+}  // namespace
+
+TEST(LazyImport, LoadOnFirstLookup) {
+  Module dev(std::make_shared<LazyTestModuleNode>("payload"));
+  std::string blob = ParseBlob(tvm::codegen::PackImportsToC(HostWithImport(dev), false));
+  num_loads = 0;
+  std::vector<Module> modules = ImportBlob(blob);
+  CHECK_EQ(modules.size(), 1U);
+  CHECK_EQ(num_loads, 0);
+  CHECK_EQ(std::string(modules[0]->type_key()), "lazy_test");
+  // a name the blob does not index misses without loading.
+  CHECK(modules[0].GetFunction("g") == nullptr);
+  CHECK_EQ(num_loads, 0);
+  // an indexed name loads the module once.
+  PackedFunc f = modules[0].GetFunction("f");
+  CHECK(f != nullptr);
+  CHECK_EQ(num_loads, 1);
+  CHECK_EQ(f().operator int(), 7);
+  CHECK(modules[0].GetFunction("f") != nullptr);
+  CHECK_EQ(num_loads, 1);
+}
+
+TEST(LazyImport, OldBlobFormat) {
+  // size, then type key and payload of each module, without the index.
+  std::string bin;
+  dmlc::MemoryStringStream ms(&bin);
+  dmlc::Stream* stream = &ms;
+  stream->Write(static_cast<uint64_t>(1));
+  stream->Write(std::string("lazy_test"));
+  stream->Write(std::string("old"));
+  std::string blob;
+  uint64_t nbytes = bin.size();
+  for (size_t i = 0; i < sizeof(nbytes); ++i) {
+    blob.push_back(static_cast<char>((nbytes >> (i * 8)) & 0xffUL));
+  }
+  blob += bin;
+  num_loads = 0;
+  std::vector<Module> modules = ImportBlob(blob);
+  CHECK_EQ(modules.size(), 1U);
+  // the old format is loaded eagerly.
+  CHECK_EQ(num_loads, 1);
+  CHECK_EQ(modules[0].GetFunction("f")().operator int(), 3);
+}
+
+TEST(LazyImport, ReExport) {
+  Module dev(std::make_shared<LazyTestModuleNode>("payload"));
+  std::string blob = ParseBlob(tvm::codegen::PackImportsToC(HostWithImport(dev), false));
+  num_loads = 0;
+  std::vector<Module> modules = ImportBlob(blob);
+  // exporting the placeholder again writes its payload without loading it.
+  std::string blob2 = ParseBlob(tvm::codegen::PackImportsToC(HostWithImport(modules[0]), false));
+  CHECK_EQ(num_loads, 0);
+  CHECK_EQ(blob2, blob);
+  std::vector<Module> modules2 = ImportBlob(blob2);
+  CHECK_EQ(num_loads, 0);
+  CHECK_EQ(modules2[0].GetFunction("f")().operator int(), 7);
+  CHECK_EQ(num_loads, 1);
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
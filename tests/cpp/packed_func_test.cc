@@ -22,6 +22,8 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/tvm.h>
 #include <tvm/ir.h>
+#include <chrono>
+#include <string>
 
 TEST(PackedFunc, Basic) {
   using namespace tvm;
@@ -177,6 +179,54 @@ TEST(TypedPackedFunc, HighOrder) {
   CHECK_EQ(f1(3), 4);
 }
 
+TEST(TypedPackedFunc, Unboxed) {
+  using namespace tvm;
+  using namespace tvm::runtime;
+  using FConcat = TypedPackedFunc<std::string(const std::string&, int)>;
+  FConcat fconcat([](const std::string& s, int n) { return s + std::to_string(n); });
+  CHECK(fconcat.unboxed());
+  CHECK_EQ(fconcat("x", 1), "x1");
+  // copies share the unboxed entry
+  FConcat copy = fconcat;
+  CHECK(copy.unboxed());
+  CHECK_EQ(copy("y", 2), "y2");
+  // the packed path still works
+  CHECK_EQ(fconcat.packed()("z", 3).operator std::string(), "z3");
+  // a TypedPackedFunc from a PackedFunc takes the packed path
+  FConcat from_packed(fconcat.packed());
+  CHECK(!from_packed.unboxed());
+  CHECK_EQ(from_packed("w", 4), "w4");
+  copy = fconcat.packed();
+  CHECK(!copy.unboxed());
+  int counter = 0;
+  TypedPackedFunc<void(int)> fadd([&counter](int x) { counter += x; });
+  fadd(2);
+  fadd.packed()(3);
+  CHECK_EQ(counter, 5);
+}
+
+TEST(TypedPackedFunc, CallOverhead) {
+  using namespace tvm::runtime;
+  using FAdd = TypedPackedFunc<int(int, int)>;
+  FAdd unboxed([](int x, int y) { return x + y; });
+  FAdd boxed(unboxed.packed());
+  const int kCalls = 1000000;
+  auto measure = [kCalls](const FAdd& f) {
+    int sum = 0;
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kCalls; ++i) {
+      sum = f(sum, 1);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    CHECK_EQ(sum, kCalls);
+    return std::chrono::duration<double, std::nano>(end - begin).count() / kCalls;
+  };
+  double boxed_ns = measure(boxed);
+  double unboxed_ns = measure(unboxed);
+  LOG(INFO) << "TypedPackedFunc<int(int, int)> call: packed " << boxed_ns
+            << " ns, unboxed " << unboxed_ns << " ns";
+}
+
 // new namespoace
 namespace test {
 // register int vector as extension type
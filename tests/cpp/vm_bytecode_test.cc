@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <tvm/runtime/vm.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using tvm::runtime::vm::Index;
+using tvm::runtime::vm::Instruction;
+using tvm::runtime::vm::VirtualMachine;
+using tvm::runtime::vm::VMFunction;
+
+// f(x) = x, through a copy in register 1.
+VMFunction MakeIdentity(const std::string& name) {
+  return VMFunction(name, 1, {Instruction::Move(0, 1), Instruction::Ret(1)}, 2);
+}
+
+std::string TempPath(const char* name) {
+  return std::string(P_tmpdir) + "/" + name;
+}
+
+}  // namespace
+
+TEST(VMBytecode, RoundTrip) {
+  VMFunction func = MakeIdentity("main");
+  VMFunction loaded = VMFunction::FromBytecode(
+      func.name, func.params, func.bytecode, func.register_file_size);
+  ASSERT_EQ(loaded.instructions.size(), func.instructions.size());
+  CHECK(loaded.bytecode == func.bytecode);
+}
+
+TEST(VMBytecode, RegisterOutOfRange) {
+  VMFunction func = MakeIdentity("main");
+  EXPECT_THROW(VMFunction::FromBytecode(func.name, func.params, func.bytecode, 1),
+               dmlc::Error);
+  std::vector<Index> bytecode = func.bytecode;
+  // The source register of the move.
+  bytecode[2] = -1;
+  EXPECT_THROW(VMFunction::FromBytecode(func.name, func.params, bytecode, 2),
+               dmlc::Error);
+}
+
+TEST(VMBytecode, Truncated) {
+  VMFunction func = MakeIdentity("main");
+  std::vector<Index> bytecode(func.bytecode.begin(), func.bytecode.end() - 1);
+  EXPECT_THROW(VMFunction::FromBytecode(func.name, func.params, bytecode, 2),
+               dmlc::Error);
+}
+
+TEST(VMBytecode, TableIndexOutOfRange) {
+  std::string path = TempPath("vm_bytecode_test.vm");
+  VirtualMachine vm;
+  vm.functions.push_back(
+      VMFunction("main", 0, {Instruction::LoadConst(0, 0), Instruction::Ret(0)}, 1));
+  vm.global_map_["main"] = 0;
+  vm.Save(path);
+  // The constant pool is empty.
+  EXPECT_THROW(VirtualMachine::Load(path, tvm::runtime::Module()), dmlc::Error);
+
+  vm.functions[0] = MakeIdentity("main");
+  vm.global_map_["main"] = 1;
+  vm.Save(path);
+  EXPECT_THROW(VirtualMachine::Load(path, tvm::runtime::Module()), dmlc::Error);
+
+  vm.global_map_["main"] = 0;
+  vm.Save(path);
+  VirtualMachine loaded = VirtualMachine::Load(path, tvm::runtime::Module());
+  EXPECT_EQ(loaded.functions.size(), 1U);
+  std::remove(path.c_str());
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
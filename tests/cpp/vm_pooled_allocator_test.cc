@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include "../src/runtime/vm/pooled_allocator.h"
+
+namespace {
+
+using tvm::runtime::vm::Buffer;
+using tvm::runtime::vm::MemoryManager;
+using tvm::runtime::vm::PooledAllocator;
+
+const TVMType kFloat32{kDLFloat, 32, 1};
+
+TVMContext CPUContext(int device_id) {
+  TVMContext ctx;
+  ctx.device_type = kDLCPU;
+  ctx.device_id = device_id;
+  return ctx;
+}
+
+}  // namespace
+
+TEST(PooledAllocator, BucketReuse) {
+  PooledAllocator alloc(CPUContext(0));
+  Buffer a = alloc.Alloc(5000, 64, kFloat32);
+  CHECK_EQ(a.size, 2 * PooledAllocator::kDefaultPageSize);
+  alloc.Free(a);
+  // a request of the same bucket gets the cached buffer back.
+  Buffer b = alloc.Alloc(7000, 64, kFloat32);
+  CHECK_EQ(b.data, a.data);
+  CHECK_EQ(alloc.UsedMemory(), a.size);
+  CHECK_EQ(alloc.CachedMemory(), 0U);
+  alloc.Free(b);
+  // so does a request of the bucket below.
+  Buffer c = alloc.Alloc(100, 64, kFloat32);
+  CHECK_EQ(c.data, a.data);
+  CHECK_EQ(c.size, a.size);
+  // but not a request further below.
+  Buffer d = alloc.Alloc(20000, 64, kFloat32);
+  alloc.Free(d);
+  Buffer e = alloc.Alloc(100, 64, kFloat32);
+  CHECK_NE(e.data, d.data);
+  CHECK_EQ(e.size, PooledAllocator::kDefaultPageSize);
+  CHECK_EQ(alloc.CachedMemory(), d.size);
+  alloc.Free(c);
+  alloc.Free(e);
+}
+
+TEST(PooledAllocator, Trim) {
+  const size_t page = PooledAllocator::kDefaultPageSize;
+  PooledAllocator alloc(CPUContext(0));
+  Buffer small = alloc.Alloc(page, 64, kFloat32);
+  Buffer medium = alloc.Alloc(4 * page, 64, kFloat32);
+  Buffer large = alloc.Alloc(16 * page, 64, kFloat32);
+  alloc.Free(small);
+  alloc.Free(medium);
+  alloc.Free(large);
+  CHECK_EQ(alloc.UsedMemory(), 21 * page);
+  CHECK_EQ(alloc.CachedMemory(), 21 * page);
+  // the largest buffers are released first.
+  alloc.Trim(8 * page);
+  CHECK_EQ(alloc.UsedMemory(), 5 * page);
+  CHECK_EQ(alloc.CachedMemory(), 5 * page);
+  alloc.Trim(page);
+  CHECK_EQ(alloc.UsedMemory(), page);
+  Buffer again = alloc.Alloc(page, 64, kFloat32);
+  CHECK_EQ(again.data, small.data);
+  alloc.Free(again);
+  alloc.Trim(0);
+  CHECK_EQ(alloc.UsedMemory(), 0U);
+  CHECK_EQ(alloc.CachedMemory(), 0U);
+}
+
+TEST(PooledAllocator, MemoryLimit) {
+  const size_t page = PooledAllocator::kDefaultPageSize;
+  // the limit is read when the allocator of a context is first created,
+  // use a device id no other test touches.
+  setenv("TVM_VM_MEMORY_LIMIT", "8192", 1);
+  auto* alloc = dynamic_cast<PooledAllocator*>(
+      MemoryManager::Global()->GetAllocator(CPUContext(7)));
+  unsetenv("TVM_VM_MEMORY_LIMIT");
+  CHECK(alloc != nullptr);
+  Buffer a = alloc->Alloc(page, 64, kFloat32);
+  Buffer b = alloc->Alloc(page, 64, kFloat32);
+  Buffer c = alloc->Alloc(page, 64, kFloat32);
+  // live buffers may exceed the limit, cached ones may not.
+  CHECK_EQ(alloc->UsedMemory(), 3 * page);
+  alloc->Free(a);
+  alloc->Free(b);
+  alloc->Free(c);
+  CHECK_LE(alloc->UsedMemory(), 2 * page);
+  CHECK_EQ(alloc->CachedMemory(), alloc->UsedMemory());
+}
+
+int main(int argc, char ** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
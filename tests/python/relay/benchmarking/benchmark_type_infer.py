@@ -0,0 +1,101 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmarking incremental against full type inference on a pass pipeline.
+
+Usage: python benchmark_type_infer.py [--num-layers 152] [--repeat 3]
+"""
+import argparse
+import os
+import time
+
+import numpy as np
+
+from tvm import relay
+from tvm.relay import testing
+from tvm.relay import transform
+
+ENV_NAME = "TVM_RELAY_INCREMENTAL_TYPE_INFER"
+
+
+def count_calls(func):
+    calls = [0]
+    def fvisit(e):
+        if isinstance(e, relay.Call):
+            calls[0] += 1
+    relay.ir_pass.post_order_visit(func, fvisit)
+    return calls[0]
+
+
+def pipeline():
+    # A typical optimization sequence, every pass requires InferType first.
+    return transform.Sequential([
+        transform.SimplifyInference(),
+        transform.CanonicalizeOps(),
+        transform.FoldScaleAxis(),
+        transform.EliminateCommonSubexpr(),
+        transform.FuseOps(),
+        transform.InferType(),
+    ], opt_level=3)
+
+
+def run(net, incremental, repeat):
+    os.environ[ENV_NAME] = "1" if incremental else "0"
+    seq = pipeline()
+    costs = []
+    result = None
+    for _ in range(repeat):
+        # Function passes update the module in place, start from a fresh one.
+        mod = relay.Module.from_expr(net)
+        with relay.build_config(opt_level=3, instrument=True) as ctx:
+            start = time.time()
+            result = seq(mod)
+            costs.append(time.time() - start)
+    return result, np.array(costs) * 1000, ctx.profile_summary()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--num-layers", type=int, default=152)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    net, _ = testing.resnet.get_workload(num_layers=args.num_layers)
+    print("resnet-%d: %d calls" % (args.num_layers, count_calls(net)))
+
+    saved = os.environ.get(ENV_NAME)
+    try:
+        full_mod, full_cost, full_summary = run(net, False, args.repeat)
+        inc_mod, inc_cost, inc_summary = run(net, True, args.repeat)
+    finally:
+        if saved is None:
+            del os.environ[ENV_NAME]
+        else:
+            os.environ[ENV_NAME] = saved
+    assert relay.ir_pass.alpha_equal(full_mod["main"],
+                                     inc_mod["main"])
+
+    print("Full type inference:\n" + full_summary)
+    print("Incremental type inference:\n" + inc_summary)
+    print("Pipeline time, full: %.2f ms (%.2f ms)" %
+          (np.mean(full_cost), np.std(full_cost)))
+    print("Pipeline time, incremental: %.2f ms (%.2f ms)" %
+          (np.mean(inc_cost), np.std(inc_cost)))
+    print("Speedup: %.2fx" % (np.mean(full_cost) / np.mean(inc_cost)))
+
+
+if __name__ == "__main__":
+    main()
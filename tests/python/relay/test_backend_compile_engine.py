@@ -49,6 +49,46 @@ def test_compile_engine():
                 y.asnumpy(), x.asnumpy() * 3)
     engine.dump()
 
+def test_compile_engine_disk_cache():
+    from tvm.contrib import graph_runtime, util
+    engine = relay.backend.compile_engine.get()
+    def get_func(shape):
+        x = relay.var("x", shape=shape)
+        y = relay.multiply(x, x)
+        f = relay.ir_pass.infer_type(relay.Function([x], relay.add(y, x)))
+        return f
+    def fail_build(*args):
+        raise RuntimeError("the module should come from the disk cache")
+    build_llvm = tvm.get_global_func("codegen.build_llvm")
+    ctx = tvm.cpu()
+    temp = util.tempdir()
+    engine.set_disk_cache(temp.temp_dir)
+    try:
+        for i in range(2):
+            if i == 1:
+                # code generation must not run again.
+                tvm.register_func("codegen.build_llvm", fail_build, override=True)
+            # drop the in memory cache so that the kernel comes from disk.
+            # The kernels of this round get new unique names, the cached
+            # modules are renamed to match the graph.
+            engine.clear()
+            f = engine.jit(get_func((7,)), "llvm")
+            x = tvm.nd.array(np.full(7, 2, dtype="float32"), ctx=ctx)
+            y = tvm.nd.empty((7,), ctx=ctx)
+            f(x, y)
+            tvm.testing.assert_allclose(y.asnumpy(), np.full(7, 6))
+            graph, lib, _ = relay.build(get_func((5,)), "llvm")
+            m = graph_runtime.create(graph, lib, ctx)
+            m.run(x=np.full(5, 3, dtype="float32"))
+            tvm.testing.assert_allclose(m.get_output(0).asnumpy(), np.full(5, 12))
+            keys = [p for p in temp.listdir() if p.endswith(".key")]
+            assert len(keys) == 2
+    finally:
+        tvm.register_func("codegen.build_llvm", build_llvm, override=True)
+        engine.set_disk_cache(None)
+        engine.clear()
+
+
 def test_compile_placeholder_bypass():
     engine = relay.backend.compile_engine.get()
     x = relay.var("x", shape=(2, 3))
@@ -79,6 +119,7 @@ def test_compile_tuple_dup():
 
 if __name__ == "__main__":
     test_compile_engine()
+    test_compile_engine_disk_cache()
     test_compile_placeholder_bypass()
     test_compile_injective_with_tuple()
     test_compile_tuple_dup()
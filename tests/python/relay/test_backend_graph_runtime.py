@@ -14,6 +14,7 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import json
 import numpy as np
 
 import tvm
@@ -111,6 +112,127 @@ def test_with_params():
     tvm.testing.assert_allclose(res, ref_res)
 
 
+def test_execution_context():
+    x = relay.var('x', shape=(10, 5))
+    y = relay.var('y', shape=(1, 5))
+    z = relay.exp(relay.add(x, y))
+    func = relay.Function([x, y], z)
+    y_data = np.random.rand(1, 5).astype('float32')
+    graph, lib, params = relay.build(func, "llvm", params={"y": y_data})
+    mod = graph_runtime.create(graph, lib, ctx=tvm.cpu(0))
+    mod.load_params(relay.save_param_dict(params))
+    ctx_mod = mod.create_execution_context()
+    x0 = np.random.rand(10, 5).astype('float32')
+    x1 = np.random.rand(10, 5).astype('float32')
+    mod.set_input(x=x0)
+    ctx_mod.set_input(x=x1)
+    mod.run()
+    ctx_mod.run()
+    # params are shared while activations are not
+    tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), np.exp(x0 + y_data))
+    tvm.testing.assert_allclose(ctx_mod.get_output(0).asnumpy(), np.exp(x1 + y_data))
+
+    # updating a parameter through any context updates it for all
+    name = list(params.keys())[0]
+    y_data = np.random.rand(1, 5).astype('float32')
+    ctx_mod.set_input(name, y_data)
+    mod.run()
+    tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), np.exp(x0 + y_data))
+
+    # parameters set after a context is created are visible to it
+    mod = graph_runtime.create(graph, lib, ctx=tvm.cpu(0))
+    ctx_mod = mod.create_execution_context()
+    mod.set_params(**params)
+    ctx_mod.run(x=x1)
+    tvm.testing.assert_allclose(ctx_mod.get_output(0).asnumpy(),
+                                np.exp(x1 + params[name].asnumpy()))
+
+
+def test_parallel_build():
+    x = relay.var('x', shape=(10, 5))
+    y = relay.var('y', shape=(1, 5))
+    z = relay.exp(relay.add(x, y))
+    z = relay.nn.softmax(relay.nn.relu(z))
+    z = relay.sum(relay.sigmoid(z), axis=1)
+    func = relay.Function([x, y], z)
+    x_data = np.random.rand(10, 5).astype('float32')
+    y_data = np.random.rand(1, 5).astype('float32')
+    engine = relay.backend.compile_engine.get()
+    results = []
+    for threads in [1, 4]:
+        # lower every primitive function again
+        engine.clear()
+        with relay.build_config(opt_level=0), tvm.build_config(build_threads=threads):
+            graph, lib, params = relay.build(func, "llvm")
+        mod = graph_runtime.create(graph, lib, ctx=tvm.cpu(0))
+        mod.run(x=x_data, y=y_data)
+        use_counts = sorted((v.cached_func.func_name, v.use_count)
+                            for _, v in engine.items())
+        results.append((graph, lib.get_source(), use_counts, mod.get_output(0).asnumpy()))
+    # parallel lowering must not change the code nor the cache statistics
+    assert results[0][0] == results[1][0]
+    assert results[0][1] == results[1][1]
+    assert results[0][2] == results[1][2]
+    tvm.testing.assert_allclose(results[0][3], results[1][3])
+
+
+def test_inter_op_parallelism():
+    x = relay.var('x', shape=(10, 5))
+    branches = [relay.exp(x), relay.sqrt(relay.abs(x)), relay.negative(x), relay.tanh(x)]
+    z = branches[0]
+    for b in branches[1:]:
+        z = relay.add(z, b)
+    func = relay.Function([x], z)
+    # keep every operator in its own kernel, fusion would merge the branches.
+    with relay.build_config(opt_level=0):
+        graph, lib, _ = relay.build(func, "llvm")
+    nodes = json.loads(graph)["nodes"]
+    inputs = [i for i, node in enumerate(nodes) if node["op"] == "null"]
+    independent = [node for node in nodes if node["op"] == "tvm_op" and
+                   all(e[0] in inputs for e in node["inputs"])]
+    assert len(independent) >= 2, graph
+    mod = graph_runtime.create(graph, lib, ctx=tvm.cpu(0))
+    for _ in range(10):
+        x_data = np.random.uniform(-1, 1, (10, 5)).astype('float32')
+        mod.set_inter_op_parallelism(1)
+        mod.run(x=x_data)
+        serial = mod.get_output(0).asnumpy()
+        ref = np.exp(x_data) + np.sqrt(np.abs(x_data)) - x_data + np.tanh(x_data)
+        tvm.testing.assert_allclose(serial, ref, rtol=1e-5)
+        mod.set_inter_op_parallelism(2)
+        mod.run(x=x_data)
+        tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), serial)
+
+
+def test_pipelined_runtime():
+    x = relay.var('x', shape=(10, 5))
+    y = relay.var('y', shape=(1, 5))
+    z = relay.exp(relay.add(x, y))
+    func = relay.Function([x, y], z)
+    y_data = np.random.rand(1, 5).astype('float32')
+    graph, lib, params = relay.build(func, "llvm", params={"y": y_data})
+    mod = graph_runtime.create(graph, lib, ctx=tvm.cpu(0))
+    mod.load_params(relay.save_param_dict(params))
+    pipeline = mod.create_pipeline(num_buffers=2)
+    finished = []
+    xs = [np.random.rand(10, 5).astype('float32') for _ in range(4)]
+    # more requests than buffers: submitting waits for the oldest to be released
+    pending = []
+    for x_data in xs:
+        if len(pending) == 2:
+            req, ref = pending.pop(0)
+            tvm.testing.assert_allclose(req.result()[0].asnumpy(), ref, rtol=1e-5)
+        req = pipeline.submit(callback=lambda i, err: finished.append(err), x=x_data)
+        pending.append((req, np.exp(x_data + y_data)))
+    for req, ref in pending:
+        req.wait()
+        assert req.done()
+        out = req.get_output(0, tvm.nd.empty((10, 5)))
+        req.release()
+        tvm.testing.assert_allclose(out.asnumpy(), ref, rtol=1e-5)
+    assert finished == [""] * len(xs)
+
+
 def test_plan_memory():
     # it is sufficient to cycle through two memories.
 
@@ -184,6 +306,10 @@ def test_gru_like():
 if __name__ == "__main__":
     test_plan_memory()
     test_with_params()
+    test_execution_context()
+    test_parallel_build()
+    test_inter_op_parallelism()
+    test_pipelined_runtime()
     test_add_op_scalar()
     test_add_op_tensor()
     test_add_op_broadcast()
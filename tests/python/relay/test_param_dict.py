@@ -52,6 +52,53 @@ def test_ndarray_reflection():
     np.testing.assert_equal(deser_param_dict['x'].asnumpy(), deser_param_dict['y'].asnumpy())
 
 
+def _mapped_ranges(path):
+    """Address ranges at which path is mapped, None when unknown."""
+    if not os.path.exists("/proc/self/maps"):
+        return None
+    path = os.path.realpath(path)
+    ranges = []
+    with open("/proc/self/maps") as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 6 and fields[5] == path:
+                begin, end = fields[0].split("-")
+                ranges.append((int(begin, 16), int(end, 16)))
+    return ranges
+
+
+def test_load_params_from_file():
+    x = relay.var('x', shape=(10, 5))
+    y = relay.var('y', shape=(10, 5))
+    func = relay.Function([x, y], x + y)
+    y_data = np.random.uniform(size=(10, 5)).astype("float32")
+    graph, lib, params = relay.build(func, target="llvm", params={'y': y_data})
+
+    temp = util.tempdir()
+    path = temp.relpath("deploy.params")
+    relay.save_param_dict_to_file(params, path)
+    # The old layout is accepted as well.
+    old_path = temp.relpath("old.params")
+    with open(old_path, "wb") as fo:
+        fo.write(relay.save_param_dict(params))
+
+    x_data = np.random.uniform(size=(10, 5)).astype("float32")
+    for p, prefetch, zero_copy in [(path, True, True), (old_path, False, False)]:
+        mod = graph_runtime.create(graph, lib, tvm.cpu())
+        mod.load_params_from_file(p, prefetch)
+        mod.run(x=x_data)
+        np.testing.assert_allclose(mod.get_output(0).asnumpy(), x_data + y_data)
+        # The aligned layout binds the parameters to the mapping itself.
+        ranges = _mapped_ranges(p)
+        if ranges is None:
+            continue
+        for name in params:
+            param = mod.get_input(name)
+            address = (param.handle.contents.data or 0) + param.handle.contents.byte_offset
+            in_mapping = any(begin <= address < end for begin, end in ranges)
+            assert in_mapping == zero_copy, name
+
+
 def test_bigendian_rpc_param():
     """Test big endian rpc when there is a PowerPC RPC server available"""
     host = os.environ.get("TVM_POWERPC_TEST_HOST", None)
@@ -91,4 +138,5 @@ def test_bigendian_rpc_param():
 if __name__ == "__main__":
     test_save_load()
     test_ndarray_reflection()
+    test_load_params_from_file()
     test_bigendian_rpc_param()
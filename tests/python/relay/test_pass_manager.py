@@ -15,10 +15,12 @@
 # specific language governing permissions and limitations
 # under the License.
 """Unit tests for relay pass manager."""
+import json
 import numpy as np
 
 import tvm
 from tvm import relay
+from tvm.contrib import util
 from tvm.relay import ExprFunctor
 from tvm.relay import Function, Call
 from tvm.relay import ir_pass
@@ -450,9 +452,85 @@ def test_sequential_with_scoping():
     assert relay.ir_pass.alpha_equal(zz, zexpected)
 
 
+def test_parallel_function_pass():
+    tp = relay.TensorType((5, 10), "float32")
+    def make_mod():
+        funcs = {}
+        for i in range(8):
+            x = relay.var("x", tp)
+            dead = relay.var("dead", tp)
+            body = relay.Let(dead, relay.add(x, x),
+                             relay.multiply(x, relay.const(float(i))))
+            funcs["f%d" % i] = relay.Function([x], body)
+        return relay.Module(funcs)
+
+    dce = _transform.DeadCodeElimination()
+    assert dce.thread_safe
+    with relay.build_config(num_threads=1):
+        ref_mod = dce(make_mod())
+    with relay.build_config(num_threads=4) as ctx:
+        assert ctx.num_threads == 4
+        mod = dce(make_mod())
+    for i in range(8):
+        name = "f%d" % i
+        assert relay.ir_pass.alpha_equal(mod[name], ref_mod[name])
+        assert not isinstance(mod[name].body, relay.Let)
+
+    # Passes defined in Python always run serially.
+    visited = []
+    @_transform.function_pass(opt_level=1)
+    def record(func, mod, ctx):
+        visited.append(func)
+        return func
+    assert not record.thread_safe
+    with relay.build_config(num_threads=4):
+        record(make_mod())
+    assert len(visited) == 8
+
+
+def test_pass_instrument():
+    shape = (1, 2, 3)
+    tp = relay.TensorType(shape, "float32")
+    x = relay.var("x", tp)
+    c = relay.const(np.ones(shape).astype("float32"))
+    y = relay.add(relay.add(c, c), x)
+    mod = relay.Module({"main": relay.Function([x], y)})
+
+    seq = _transform.Sequential([
+        relay.transform.InferType(),
+        relay.transform.FoldConstant(),
+    ], opt_level=2, name="pipeline")
+    with relay.build_config(opt_level=2, instrument=True) as ctx:
+        seq(mod)
+    summary = ctx.profile_summary()
+    for name in ["pipeline", "InferType", "FoldConstant"]:
+        assert name in summary
+
+    temp = util.tempdir()
+    path = temp.relpath("trace.json")
+    ctx.dump_trace(path)
+    with open(path) as f:
+        events = json.load(f)
+    names = [e["name"] for e in events]
+    # Nested passes finish before the sequence that runs them.
+    assert names == ["InferType", "FoldConstant", "pipeline"]
+    fold = events[1]
+    assert fold["ph"] == "X" and fold["dur"] >= 0
+    assert fold["args"]["nodes_after"] < fold["args"]["nodes_before"]
+
+    ctx.clear_profile()
+    assert "InferType" not in ctx.profile_summary()
+    # Nothing is recorded without instrumentation.
+    with relay.build_config(opt_level=2) as ctx:
+        seq(mod)
+    assert "pipeline" not in ctx.profile_summary()
+
+
 if __name__ == "__main__":
     test_module_pass()
     test_function_pass()
     test_sequential_pass()
     test_sequential_with_scoping()
     test_pass_info()
+    test_parallel_function_pass()
+    test_pass_instrument()
@@ -17,6 +17,7 @@
 """Test that type checker correcly computes types
    for expressions.
 """
+import os
 import tvm
 import numpy as np
 from tvm.relay.ir_pass import infer_type
@@ -332,6 +333,34 @@ def test_adt_match_type_annotations():
     assert ft.checked_type == relay.FuncType([tt], relay.TupleType([]))
 
 
+def test_incremental():
+    tt = relay.TensorType
+    x = relay.var("x", shape=(2, 3))
+    f1 = infer_type(relay.Function([x], relay.nn.relu(relay.add(x, x))))
+    checked = f1.body
+    checked_type = checked.checked_type
+    # Rewrite around the checked body, its type is reused.
+    c = relay.const(np.ones((3,), "float32"))
+    z = relay.sum(relay.multiply(checked, c), axis=1)
+    f2 = relay.Function([f1.params[0]], z)
+    inc = infer_type(f2)
+    assert inc.checked_type == relay.FuncType([tt((2, 3), "float32")],
+                                              tt((2,), "float32"))
+    # A reused call keeps its node and the very type object it had.
+    assert inc.body.args[0].args[0].same_as(checked)
+    assert inc.body.args[0].args[0].checked_type.same_as(checked_type)
+
+    # Re-solving everything gives the same program, but new types.
+    os.environ["TVM_RELAY_INCREMENTAL_TYPE_INFER"] = "0"
+    try:
+        full = infer_type(f2)
+    finally:
+        del os.environ["TVM_RELAY_INCREMENTAL_TYPE_INFER"]
+    assert relay.ir_pass.alpha_equal(inc, full)
+    assert inc.body.args[0].checked_type == full.body.args[0].checked_type
+    assert not full.body.args[0].args[0].checked_type.same_as(checked_type)
+
+
 if __name__ == "__main__":
     test_free_expr()
     test_dual_op()
@@ -350,3 +379,4 @@ if __name__ == "__main__":
     test_constructor_type()
     test_constructor_call()
     test_adt_match()
+    test_incremental()
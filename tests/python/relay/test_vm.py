@@ -20,6 +20,8 @@ from nose.tools import nottest
 import tvm
 import numpy as np
 from tvm import relay
+from tvm.contrib import util
+from tvm.relay.backend import vm as _vm
 from tvm.relay.scope_builder import ScopeBuilder
 from tvm.relay.prelude import Prelude
 
@@ -260,6 +262,52 @@ def test_closure():
     res = veval(main)
     tvm.testing.assert_allclose(res.asnumpy(), 3.0)
 
+def test_deep_chain():
+    # Every intermediate is dead after its single use, so the compiler
+    # releases its register right away; the result must be unaffected.
+    x = relay.var('x', shape=(10, 10))
+    y = relay.var('y', shape=(10, 10))
+    z = x
+    for i in range(20):
+        z = relay.annotation.stop_fusion(z + y)
+    f = relay.Function([x, y], relay.If(any(relay.op.equal(x, y)), x, z))
+    x_data = np.random.rand(10, 10).astype('float32')
+    y_data = np.random.rand(10, 10).astype('float32')
+
+    res = veval(f, x_data, y_data)
+    tvm.testing.assert_allclose(res.asnumpy(), x_data + 20 * y_data, rtol=1e-5)
+    res = veval(f, x_data, x_data)
+    tvm.testing.assert_allclose(res.asnumpy(), x_data)
+
+    # Each of the 20 intermediates but the result dies at its next use.
+    mod = relay.Module()
+    mod[mod.entry_func] = f
+    bytecode = _vm.get_bytecode(mod)
+    kills = [line for line in bytecode.splitlines() if ": kill " in line]
+    assert len(kills) >= 19, bytecode
+
+def test_save_load_executable():
+    x = relay.var('x', shape=(10, 10))
+    y = relay.var('y', shape=(10, 10))
+    c = relay.const(np.random.rand(10, 10).astype('float32'))
+    mod = relay.Module()
+    mod[mod.entry_func] = relay.Function([x, y], (x + c) * y)
+
+    temp = util.tempdir()
+    path = temp.relpath("exe.vm")
+    lib = _vm.save_executable(mod, path)
+    lib.export_library(temp.relpath("lib.so"))
+    lib = tvm.module.load(temp.relpath("lib.so"))
+    exe = _vm.load_executable(path, lib)
+
+    x_data = np.random.rand(10, 10).astype('float32')
+    y_data = np.random.rand(10, 10).astype('float32')
+    res = exe.invoke("main", x_data, y_data)
+    tvm.testing.assert_allclose(res.asnumpy(), (x_data + c.data.asnumpy()) * y_data)
+    # The state is reset between calls.
+    res = exe.invoke("main", y_data, x_data)
+    tvm.testing.assert_allclose(res.asnumpy(), (y_data + c.data.asnumpy()) * x_data)
+
 if __name__ == "__main__":
     test_id()
     test_op()
@@ -277,3 +325,5 @@ if __name__ == "__main__":
     # TODO(@jroesch): restore when match is supported
     # test_list_constructor()
     test_closure()
+    test_deep_chain()
+    test_save_load_executable()
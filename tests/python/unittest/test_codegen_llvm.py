@@ -18,7 +18,9 @@ import tvm
 from tvm.contrib import util, clang
 import numpy as np
 import ctypes
+import json
 import math
+import threading
 
 def test_llvm_intrin():
     ib = tvm.ir_builder.create()
@@ -162,6 +164,107 @@ def test_llvm_persist_parallel():
     check_llvm()
 
 
+def test_llvm_parallel_work_stealing():
+    n = 1027
+    A = tvm.placeholder((n,), name='A')
+    B = tvm.compute(A.shape, lambda *i: A(*i) * 2 + 1, name='B')
+    s = tvm.create_schedule(B.op)
+    s[B].parallel(B.op.axis[0])
+
+    def check_llvm():
+        if not tvm.module.enabled("llvm"):
+            return
+        f = tvm.build(s, [A, B], "llvm")
+        ctx = tvm.cpu(0)
+        a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), ctx)
+        config = tvm.get_global_func("runtime.config_threadpool_work_stealing")
+        num_launches = tvm.get_global_func("runtime.threadpool_work_stealing_launches")
+        config(8)
+        try:
+            start = num_launches()
+            for i in range(4):
+                b = tvm.nd.array(np.zeros(n, dtype=B.dtype), ctx)
+                f(a, b)
+                tvm.testing.assert_allclose(b.asnumpy(), a.asnumpy() * 2 + 1)
+                # every launch of the lambda is split into stolen chunks
+                assert num_launches() == start + i + 1
+        finally:
+            config(1)
+        # back in static mode
+        b = tvm.nd.array(np.zeros(n, dtype=B.dtype), ctx)
+        f(a, b)
+        tvm.testing.assert_allclose(b.asnumpy(), a.asnumpy() * 2 + 1)
+        assert num_launches() == start + 4
+
+    def check_barrier():
+        if not tvm.module.enabled("llvm"):
+            return
+        # The code generator keeps a lambda that calls the barrier in static mode.
+        m = 128
+        C = tvm.placeholder((m,), name='C')
+        D = tvm.compute(C.shape, lambda *i: C(*i) + 1, name='D')
+        E = tvm.compute(C.shape, lambda *i: D(*i) * 2, name='E')
+        s = tvm.create_schedule(E.op)
+        xo, xi = s[E].split(E.op.axis[0], nparts=1)
+        s[D].compute_at(s[E], xo)
+        s[D].parallel(s[D].op.axis[0])
+        s[D].pragma(s[D].op.axis[0], "parallel_barrier_when_finish")
+        s[E].parallel(xi)
+        s[E].pragma(xo, "parallel_launch_point")
+        s[E].pragma(xi, "parallel_stride_pattern")
+        f = tvm.build(s, [C, E], "llvm")
+        ctx = tvm.cpu(0)
+        c = tvm.nd.array(np.random.uniform(size=m).astype(C.dtype), ctx)
+        config = tvm.get_global_func("runtime.config_threadpool_work_stealing")
+        num_launches = tvm.get_global_func("runtime.threadpool_work_stealing_launches")
+        config(8)
+        try:
+            start = num_launches()
+            for _ in range(3):
+                e = tvm.nd.array(np.zeros(m, dtype=E.dtype), ctx)
+                f(c, e)
+                tvm.testing.assert_allclose(e.asnumpy(), (c.asnumpy() + 1) * 2)
+            assert num_launches() == start
+        finally:
+            config(1)
+
+    check_llvm()
+    check_barrier()
+
+
+def test_llvm_parallel_numa():
+    n = 1024
+    A = tvm.placeholder((n,), name='A')
+    B = tvm.compute(A.shape, lambda i: A[i] * 2 + 1, name='B')
+    s = tvm.create_schedule(B.op)
+    s[B].parallel(B.op.axis[0])
+
+    def check_llvm():
+        if not tvm.module.enabled("llvm"):
+            return
+        f = tvm.build(s, [A, B], "llvm")
+        results = []
+
+        # the thread pool configuration is per calling thread
+        def run():
+            config = tvm.get_global_func("runtime.config_threadpool_numa")
+            config(0)
+            ctx = tvm.cpu(0)
+            a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), ctx)
+            b = tvm.nd.array(np.zeros(n, dtype=B.dtype), ctx)
+            f(a, b)
+            config(-1)
+            results.append((a.asnumpy(), b.asnumpy()))
+
+        t = threading.Thread(target=run)
+        t.start()
+        t.join()
+        a, b = results[0]
+        tvm.testing.assert_allclose(b, a * 2 + 1)
+
+    check_llvm()
+
+
 def test_llvm_flip_pipeline():
     def check_llvm(nn, base):
         if not tvm.module.enabled("llvm"):
@@ -263,9 +366,15 @@ def test_llvm_temp_space():
         n = nn
         a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), ctx)
         c = tvm.nd.array(np.zeros(n, dtype=C.dtype), ctx)
+        workspace_stats = tvm.get_global_func("runtime.workspace_pool_stats")
+        before = json.loads(workspace_stats(ctx.device_type))
         f(a, c)
         tvm.testing.assert_allclose(
             c.asnumpy(), a.asnumpy() + 1 + 1)
+        after = json.loads(workspace_stats(ctx.device_type))
+        assert after["num_alloc"] > before["num_alloc"]
+        assert after["used_bytes"] == before["used_bytes"]
+        assert after["sum_peak_used_bytes"] >= nn * 4
     check_llvm()
 
 def test_multiple_func():
@@ -303,6 +412,26 @@ def test_multiple_func():
 
 
 
+def test_llvm_parallel_codegen():
+    n = 64
+    A = tvm.placeholder((n,), name='A')
+    funcs = []
+    for i in range(5):
+        B = tvm.compute(A.shape, lambda *j: A(*j) + i, name='B')
+        s = tvm.create_schedule(B.op)
+        funcs.append(tvm.lower(s, [A, B], name="fadd%d" % i))
+    if not tvm.module.enabled("llvm"):
+        return
+    with tvm.build_config(build_threads=3):
+        m = tvm.build(funcs, "llvm")
+    ctx = tvm.cpu(0)
+    a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype), ctx)
+    b = tvm.nd.array(np.zeros(n, dtype=A.dtype), ctx)
+    for i in range(5):
+        m["fadd%d" % i](a, b)
+        tvm.testing.assert_allclose(b.asnumpy(), a.asnumpy() + i)
+
+
 def test_llvm_condition():
     def check_llvm(n, offset):
         if not tvm.module.enabled("llvm"):
@@ -478,11 +607,14 @@ if __name__ == "__main__":
     test_rank_zero_bound_checkers()
     test_llvm_bool()
     test_llvm_persist_parallel()
+    test_llvm_parallel_work_stealing()
+    test_llvm_parallel_numa()
     test_llvm_condition()
     test_llvm_vadd_pipeline()
     test_llvm_add_pipeline()
     test_llvm_intrin()
     test_multiple_func()
+    test_llvm_parallel_codegen()
     test_llvm_flip_pipeline()
     test_llvm_madd_pipeline()
     test_llvm_temp_space()
@@ -116,6 +116,8 @@ def test_device_module_dump():
         f.export_library(path_dso)
 
         f1 = tvm.module.load(path_dso)
+        # device modules are loaded on demand, but keep their type key
+        assert f1.imported_modules[0].type_key == device
         a = tvm.nd.array(np.random.uniform(size=1024).astype(A.dtype), ctx)
         b = tvm.nd.array(np.zeros(1024, dtype=A.dtype), ctx)
         f1(a, b)
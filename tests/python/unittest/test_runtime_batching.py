@@ -0,0 +1,110 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import json
+import threading
+import tvm
+import numpy as np
+from tvm.contrib import graph_runtime, batching_runtime
+
+
+def make_graph(batch, n):
+    node0 = {"op": "null", "name": "x", "inputs": []}
+    node1 = {"op": "tvm_op", "name": "add",
+             "inputs": [[0, 0, 0]],
+             "attrs": {"func_name": "myadd",
+                       "flatten_data": "0",
+                       "num_inputs" : "1",
+                       "num_outputs" : "1"}}
+    shape = (batch, n)
+    attrs = {
+        "shape" : ["list_shape", [shape, shape]],
+        "dltype" : ["list_str", ["float32", "float32"]],
+        "storage_id" : ["list_int", [0, 1]],
+    }
+    graph = {"nodes": [node0, node1],
+             "arg_nodes": [0],
+             "node_row_ptr": [0, 1, 2],
+             "heads": [[1, 0, 0]],
+             "attrs": attrs}
+    return json.dumps(graph)
+
+
+def test_batching_graph():
+    if not tvm.module.enabled("llvm"):
+        print("Skip because llvm is not enabled")
+        return
+    n = 4
+    batch = tvm.var("batch")
+    A = tvm.placeholder((batch, n), name='A')
+    B = tvm.compute(A.shape, lambda *i: A(*i) + 1.0, name='B')
+    s = tvm.create_schedule(B.op)
+    mlib = tvm.build(s, [A, B], "llvm", name="myadd")
+    buckets = {}
+    for bs in [2, 4]:
+        buckets[bs] = graph_runtime.create(make_graph(bs, n), mlib, tvm.cpu(0))
+    mod = batching_runtime.create(["x"], buckets, max_delay_us=1000)
+
+    errors = []
+    def request(k):
+        a = np.random.uniform(size=(1, n)).astype(A.dtype)
+        b = tvm.nd.empty((1, n))
+        mod.run([tvm.nd.array(a)], [b])
+        if not np.array_equal(b.asnumpy(), a + 1):
+            errors.append(k)
+
+    threads = [threading.Thread(target=request, args=(k,)) for k in range(8)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert not errors
+    # requests must match the rows of the graph.
+    for a, b in [((1, n), (2, n)), ((1, n + 1), (1, n)), ((1, n), (1, n, 1))]:
+        try:
+            mod.run([tvm.nd.empty(a)], [tvm.nd.empty(b)])
+            assert False
+        except tvm.TVMError:
+            pass
+    stats = mod.get_stats()
+    assert stats["num_requests"] == 8
+    assert stats["queue_depth"] == 0
+    assert 0 < stats["batch_fill_rate"] <= 1
+
+
+def test_batching_function():
+    def fexec(x):
+        return tvm.nd.array(x.asnumpy() * 2)
+    mod = batching_runtime.create(["x"], {4: fexec}, max_delay_us=100)
+    a = np.random.uniform(size=(3, 2)).astype("float32")
+    b = tvm.nd.empty((3, 2))
+    mod.run([tvm.nd.array(a)], [b])
+    np.testing.assert_equal(b.asnumpy(), a * 2)
+    assert mod.get_stats()["num_batches"] == 1
+
+    # an executor returning fewer rows than requested is an error.
+    mod = batching_runtime.create(["x"], {4: lambda x: tvm.nd.empty((2, 2))},
+                                  max_delay_us=100)
+    try:
+        mod.run([tvm.nd.array(a)], [b])
+        assert False
+    except tvm.TVMError:
+        pass
+
+
+if __name__ == "__main__":
+    test_batching_graph()
+    test_batching_function()
@@ -100,6 +100,14 @@ def test_graph_simple():
         out = mod.get_output(0, tvm.nd.empty((n,)))
         np.testing.assert_equal(out.asnumpy(), a + 1)
 
+        #verify the counters are reported per op, with or without hardware support
+        ops = mod.run_individual_counters(5)
+        assert [op["name"] for op in ops] == ['add']
+        assert ops[0]["time_us"] > 0
+        assert ops[0]["io_bytes"] == 2 * n * 4
+        if "cycles" in ops[0] and "instructions" in ops[0]:
+            assert "ipc" in ops[0]
+
         mod.exit()
         #verify dump root delete after cleanup
         assert(not os.path.exists(directory))
@@ -58,6 +58,37 @@ def test_min_repeat_ms():
     assert ct > 10 + 2
 
 
+def test_time_evaluator_options():
+    calls = []
+
+    @tvm.register_func
+    def my_counter():
+        calls.append(time.time())
+
+    X = tvm.compute((), lambda : tvm.call_packed("my_counter"))
+    s = tvm.create_schedule(X.op)
+    func = tvm.build(s, [X])
+
+    x = tvm.nd.empty((), dtype="int32")
+    ftimer = func.time_evaluator(func.entry_name, tvm.cpu(),
+                                 number=1, repeat=5, warmup=3,
+                                 flush_cache=True, pin_thread=True)
+    res = ftimer(x)
+    assert len(calls) == 3 + 5
+    assert len(res.results) == 5
+    assert min(res.results) <= res.median <= res.p95 <= max(res.results)
+    assert res.std >= 0
+
+
+def test_profile_result_stats():
+    res = tvm.module.ProfileResult(mean=2.5, results=(4.0, 1.0, 3.0, 2.0))
+    assert abs(res.median - 2.5) < 1e-9
+    assert abs(res.p95 - 3.85) < 1e-9
+    assert abs(res.std - 1.25 ** 0.5) < 1e-9
+
+
 if __name__ == "__main__":
     test_min_repeat_ms()
+    test_time_evaluator_options()
+    test_profile_result_stats()
 
@@ -14,6 +14,7 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import sys
 import tvm
 import numpy as np
 
@@ -71,6 +72,62 @@ def test_fp16_conversion():
 
         tvm.testing.assert_allclose(expected, real)
 
+
+def _data_address(arr):
+    return arr.handle.contents.data or 0
+
+def _anon_huge_pages_kb(address):
+    """AnonHugePages of the mapping holding address, None without THP."""
+    try:
+        with open("/sys/kernel/mm/transparent_hugepage/enabled") as f:
+            if "[never]" in f.read():
+                return None
+        with open("/proc/self/smaps") as f:
+            lines = f.readlines()
+    except IOError:
+        return None
+    inside = False
+    for line in lines:
+        fields = line.split()
+        if "-" in fields[0] and not fields[0].endswith(":"):
+            begin, end = [int(x, 16) for x in fields[0].split("-")]
+            inside = begin <= address < end
+        elif inside and fields[0] == "AnonHugePages:":
+            return int(fields[1])
+    return None
+
+def test_nd_huge_pages():
+    config = tvm.get_global_func("runtime.config_huge_pages")
+    huge_page = 2 << 20
+    # transparent huge pages for allocations of at least 1MB
+    config(1, 1 << 20)
+    try:
+        x = np.random.uniform(size=(1 << 19,)).astype("float32")
+        y = tvm.nd.array(x)
+        z = y.copyto(tvm.cpu(0))
+        small = tvm.nd.array(x[:16])
+        np.testing.assert_equal(x, z.asnumpy())
+        np.testing.assert_equal(x[:16], small.asnumpy())
+        if sys.platform.startswith("linux"):
+            # the 2MB arrays are mapped on their own, 2MB aligned, while the
+            # small one comes from the heap through posix_memalign.
+            assert _data_address(y) % huge_page == 0
+            assert _data_address(z) % huge_page == 0
+            assert _data_address(small) % huge_page != 0
+            # both were fully written, so THP backs them when it can.
+            huge_kb = _anon_huge_pages_kb(_data_address(y))
+            if huge_kb is not None:
+                assert huge_kb > 0
+        del y, z
+    finally:
+        config(0)
+    # with huge pages off, large arrays come from the heap again, behind
+    # the allocator's chunk header.
+    w = tvm.nd.array(np.zeros((1 << 19,), dtype="float32"))
+    if sys.platform.startswith("linux"):
+        assert _data_address(w) % huge_page != 0
+
 if __name__ == "__main__":
     test_nd_create()
     test_fp16_conversion()
+    test_nd_huge_pages()
@@ -99,6 +99,48 @@ def test_rpc_array():
     fremote = remote.get_function("rpc.test.remote_array_func")
     fremote(r_cpu)
 
+def test_rpc_array_chunked():
+    if not tvm.module.enabled("rpc"):
+        return
+    server = rpc.Server("localhost")
+    remote = rpc.connect(server.host, server.port)
+    ctx = remote.cpu(0)
+    # sizes that do not divide the chunk size, and a zero-sized array
+    for shape, dtype in [((1000, 33), "float32"), ((77,), "float64"), ((0,), "float32")]:
+        x = np.random.uniform(size=shape).astype(dtype)
+        for chunk_size, window in [(1000, 1), (1000, 3), (12, 2), (0, 4)]:
+            remote.config_copy(chunk_size, window)
+            y = tvm.nd.array(x, ctx=ctx)
+            np.testing.assert_equal(y.asnumpy(), x)
+
+def test_rpc_async_call():
+    if not tvm.module.enabled("rpc"):
+        return
+    @tvm.register_func("rpc.test.async_add")
+    def async_add(x, y):
+        if x < 0:
+            raise ValueError("negative")
+        return x + y
+    server = rpc.Server("localhost")
+    remote = rpc.connect(server.host, server.port)
+    remote.config_async_workers(2)
+    fadd = remote.get_function("rpc.test.async_add")
+    futures = [remote.async_call(fadd, i, 10) for i in range(8)]
+    failed = remote.async_call(fadd, -1, 10)
+    # synchronous traffic while the calls are in flight
+    x = np.random.uniform(size=(64, 64)).astype("float32")
+    y = tvm.nd.array(x, ctx=remote.cpu(0))
+    np.testing.assert_equal(y.asnumpy(), x)
+    assert fadd(1, 2) == 3
+    for i, fut in enumerate(futures):
+        assert fut.wait() == i + 10
+        assert fut.done()
+    try:
+        failed.wait()
+        assert False
+    except tvm.TVMError as err:
+        assert "negative" in str(err)
+
 def test_rpc_file_exchange():
     if not tvm.module.enabled("rpc"):
         return
@@ -338,6 +380,8 @@ if __name__ == "__main__":
     test_rpc_remote_module()
     test_rpc_file_exchange()
     test_rpc_array()
+    test_rpc_array_chunked()
+    test_rpc_async_call()
     test_rpc_simple()
     test_local_func()
     test_rpc_tracker_register()
@@ -0,0 +1,77 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import json
+import tvm
+import numpy as np
+from tvm.contrib import graph_runtime, trace, util
+
+
+def test_trace_graph_runtime():
+    n = 4
+    A = tvm.placeholder((n,), name='A')
+    B = tvm.compute(A.shape, lambda *i: A(*i) + 1.0, name='B')
+    s = tvm.create_schedule(B.op)
+    node0 = {"op": "null", "name": "x", "inputs": []}
+    node1 = {"op": "tvm_op", "name": "add",
+             "inputs": [[0, 0, 0]],
+             "attrs": {"func_name": "myadd",
+                       "flatten_data": "1",
+                       "num_inputs" : "1",
+                       "num_outputs" : "1"}}
+    shape = (n,)
+    attrs = {
+        "shape" : ["list_shape", [shape, shape]],
+        "dltype" : ["list_str", ["float32", "float32"]],
+        "storage_id" : ["list_int", [0, 1]],
+    }
+    graph = json.dumps({"nodes": [node0, node1],
+                        "arg_nodes": [0],
+                        "node_row_ptr": [0, 1, 2],
+                        "heads": [[1, 0, 0]],
+                        "attrs": attrs})
+    if not tvm.module.enabled("llvm"):
+        print("Skip because llvm is not enabled")
+        return
+    mlib = tvm.build(s, [A, B], "llvm", name="myadd")
+    mod = graph_runtime.create(graph, mlib, tvm.cpu(0))
+    a = np.random.uniform(size=shape).astype(A.dtype)
+    mod.set_input(x=a)
+
+    trace.start()
+    mod.run()
+    out = mod.get_output(0, tvm.nd.empty(shape))
+    trace.stop()
+    # not recorded once stopped
+    mod.run()
+
+    temp = util.tempdir()
+    path = temp.relpath("trace.json")
+    result = trace.dump(path)
+    with open(path) as f:
+        assert json.load(f) == result
+    events = result["traceEvents"]
+    assert all(event["ph"] == 'X' for event in events)
+    names = [(event["cat"], event["name"]) for event in events]
+    assert names.count(("graph", "run")) == 1
+    assert names.count(("op", "add")) == 1
+    copies = [event for event in events if event["name"] == "copy"]
+    assert copies and copies[-1]["args"]["bytes"] == n * 4
+    np.testing.assert_equal(out.asnumpy(), a + 1)
+
+
+if __name__ == "__main__":
+    test_trace_graph_runtime()
@@ -26,7 +26,9 @@
 
 #include "../src/runtime/c_runtime_api.cc"
 #include "../src/runtime/cpu_device_api.cc"
+#include "../src/runtime/threading_backend.cc"
 #include "../src/runtime/workspace_pool.cc"
+#include "../src/runtime/trace.cc"
 #include "../src/runtime/module_util.cc"
 #include "../src/runtime/system_lib_module.cc"
 #include "../src/runtime/module.cc"
@@ -38,6 +40,7 @@
 #include "../src/runtime/rpc/rpc_event_impl.cc"
 #include "../src/runtime/rpc/rpc_server_env.cc"
 #include "../src/runtime/graph/graph_runtime.cc"
+#include "../src/runtime/graph/inter_op_executor.cc"
 #include "../src/runtime/opengl/opengl_device_api.cc"
 #include "../src/runtime/opengl/opengl_module.cc"
 